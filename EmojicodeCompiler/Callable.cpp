@@ -16,3 +16,19 @@ Type Callable::type() const {
     }
     return t;
 }
+
+int Callable::argumentsSize() const {
+    int size = 0;
+    for (auto &argument : arguments) {
+        size += argument.type.size();
+    }
+    return size;
+}
+
+void Closure::relocate(InstructionCount bodyStart) {
+    for (auto &information : objectVariableInformation_) {
+        // Captured variables and arguments are assigned before the closure’s block is entered
+        information.from = information.from > static_cast<int>(bodyStart) ? information.from - bodyStart : 0;
+        information.to = information.to > static_cast<int>(bodyStart) ? information.to - bodyStart : 0;
+    }
+}
@@ -23,6 +23,16 @@ struct Argument {
     Type type;
 };
 
+struct FunctionObjectVariableInformation : public ObjectVariableInformation {
+    FunctionObjectVariableInformation(int index, ObjectVariableType type, InstructionCount from, InstructionCount to)
+        : ObjectVariableInformation(index, type), from(from), to(to) {}
+    FunctionObjectVariableInformation(int index, int condition, ObjectVariableType type, InstructionCount from,
+                                      InstructionCount to)
+        : ObjectVariableInformation(index, condition, type), from(from), to(to) {}
+    int from;
+    int to;
+};
+
 /** A callable is a self-containing piece of code that can be executed, "called", and returns a value. Methods, class
  methods and closures are examples of callables. */
 class Callable {
@@ -42,9 +52,36 @@ public:
 
     /** The type of this callable when used as value. */
     virtual Type type() const;
+
+    /** The number of values the arguments of this callable take in its frame. */
+    int argumentsSize() const;
+
+    std::vector<FunctionObjectVariableInformation>& objectVariableInformation() { return objectVariableInformation_; }
+protected:
+    std::vector<FunctionObjectVariableInformation> objectVariableInformation_;
 private:
     TokenStream tokenStream_;
     SourcePosition position_;
 };
 
+class Closure: public Callable {
+public:
+    Closure(SourcePosition p) : Callable(p) {};
+
+    /// Makes the positions of the object variable information relative to @c bodyStart, the position of the first
+    /// instruction of the closure’s block, at which the closure begins to execute.
+    void relocate(InstructionCount bodyStart);
+
+    /// The position of the first instruction of the closure’s block in the instructions of the enclosing function
+    InstructionCount bodyStart = 0;
+    /// The number of instructions of the closure’s block
+    InstructionCount instructionCount = 0;
+    /// Whether the closure is called on an object, i.e. it uses self in an object method or initializer.
+    bool objectContext = false;
+    /// The number of variables the closure needs.
+    int fullSize = 0;
+    /// Describes which of the captured variables, which the closure stores one after the other, contain objects.
+    std::vector<ObjectVariableInformation> captureInformation;
+};
+
 #endif /* Callable_hpp */
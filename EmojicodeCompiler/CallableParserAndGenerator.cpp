@@ -142,6 +142,9 @@ void CallableParserAndGenerator::produceToVariable(ResolvedVariable var, SourceP
     writeInstructionForStackOrInstance(var.inInstanceScope, INS_PRODUCE_WITH_STACK_DESTINATION,
                                        INS_PRODUCE_WITH_OBJECT_DESTINATION, INS_PRODUCE_WITH_VT_DESTINATION, p);
     writer.writeInstruction(var.variable.id(), p);
+    if (var.inInstanceScope && typeContext.calleeType().type() != TypeContent::ValueType) {
+        writer.writeInstruction(var.variable.type().size(), p);
+    }
 }
 
 void CallableParserAndGenerator::getVTReference(ResolvedVariable var, SourcePosition p) {
@@ -185,7 +188,7 @@ void CallableParserAndGenerator::flowControlBlock(bool pushScope, std::function<
 
     effect = true;
 
-    scoper.popScopeAndRecommendFrozenVariables(static_cast<Function &>(callable).objectVariableInformation(),
+    scoper.popScopeAndRecommendFrozenVariables(callable.objectVariableInformation(),
                                                writer.writtenInstructions());
 
     scoper.popInitializationLevel();
@@ -514,15 +517,17 @@ void CallableParserAndGenerator::parseStatement(const Token &token) {
 
                 if (iteratee.type() == TypeContent::Class && iteratee.eclass() == CL_LIST) {
                     // If the iteratee is a list, the Real-Time Engine has some special sugar
-                    int internalId = scoper.currentScope().allocateInternalVariable(iteratee);
-                    writer.writeInstruction(internalId, token);  // Internally needed
                     auto type = Type(TypeContent::Reference, false, 0, CL_LIST).resolveOn(iteratee);
                     auto &var = scoper.currentScope().setLocalVariable(variableToken.value(), type,
                                                                        true, variableToken.position());
-                    var.initialize(writer.writtenInstructions());
+                    auto &list = scoper.currentScope().allocateInternalVariable(iteratee, token.position());
+                    writer.writeInstruction(list.id(), token);  // Internally needed
                     auto destination = Destination::temporaryReference();
                     writeBoxingAndTemporary(destination, iteratee, token.position(), insertionPoint);
                     insertionPoint.insert({ 0x65, static_cast<unsigned int>(var.id()) });
+                    // The list and the variable are assigned before the block is run
+                    list.initialize(writer.writtenInstructions());
+                    var.initialize(writer.writtenInstructions());
                     flowControlBlock(false);
                 }
                 else if (iteratee.type() == TypeContent::ValueType &&
@@ -539,7 +544,6 @@ void CallableParserAndGenerator::parseStatement(const Token &token) {
                 else if (typeIsEnumerable(iteratee, &itemType)) {
                     auto iteratorMethodIndex = PR_ENUMERATEABLE->lookupMethod(EmojicodeString(E_DANGO))->vtiForUse();
 
-                    auto iteratorId = scoper.currentScope().allocateInternalVariable(Type(PR_ENUMERATOR, false));
                     auto nextVTI = PR_ENUMERATOR->lookupMethod(EmojicodeString(E_DOWN_POINTING_SMALL_RED_TRIANGLE))->vtiForUse();
                     auto moreVTI = PR_ENUMERATOR->lookupMethod(EmojicodeString(E_RED_QUESTION_MARK))->vtiForUse();
 
@@ -547,13 +551,22 @@ void CallableParserAndGenerator::parseStatement(const Token &token) {
                                                                        variableToken.position());
                     var.initialize(writer.writtenInstructions());
 
+                    auto &iterator = scoper.currentScope().allocateInternalVariable(Type(PR_ENUMERATOR, false),
+                                                                                    token.position());
+                    auto iteratorId = iterator.id();
                     auto destination = Destination::temporaryReference(StorageType::Box);
                     writeBoxingAndTemporary(destination, iteratee, token.position(), insertionPoint);
+                    // The variable is only assigned in the block but marked before, so it must not contain garbage
                     insertionPoint.insert({ INS_PRODUCE_WITH_STACK_DESTINATION,
-                        static_cast<EmojicodeInstruction>(iteratorId), INS_DISPATCH_PROTOCOL,
+                        static_cast<EmojicodeInstruction>(var.id()), INS_GET_NOTHINGNESS,
+                        INS_PRODUCE_WITH_STACK_DESTINATION, static_cast<EmojicodeInstruction>(iteratorId),
+                        INS_DISPATCH_PROTOCOL,
                     });
                     writer.writeInstruction({ static_cast<EmojicodeInstruction>(PR_ENUMERATEABLE->index),
-                        static_cast<EmojicodeInstruction>(iteratorMethodIndex), INS_REPEAT_WHILE, INS_DISPATCH_PROTOCOL,
+                        static_cast<EmojicodeInstruction>(iteratorMethodIndex), INS_REPEAT_WHILE });
+                    // The enumerator is assigned once the repetition begins
+                    iterator.initialize(writer.writtenInstructions());
+                    writer.writeInstruction({ INS_DISPATCH_PROTOCOL,
                         INS_GET_VT_REFERENCE_STACK, static_cast<EmojicodeInstruction>(iteratorId),
                         static_cast<EmojicodeInstruction>(PR_ENUMERATOR->index),
                         static_cast<EmojicodeInstruction>(moreVTI)
@@ -776,6 +789,7 @@ Type CallableParserAndGenerator::parseIdentifier(const Token &token, Type expect
             writer.writeInstruction(0x51, token);
 
             auto placeholder = writer.writeInstructionsCountPlaceholderCoin(token);
+            auto packingPlaceholder = writer.writeInstructionPlaceholder(token);
 
             Type type = Type(CL_LIST, false);
             if (expectation.type() == TypeContent::Class && expectation.eclass() == CL_LIST) {
@@ -797,6 +811,7 @@ Type CallableParserAndGenerator::parseIdentifier(const Token &token, Type expect
                 type.genericArguments[0] = ct.getCommonType(token);
             }
 
+            packingPlaceholder.write(type.genericArguments[0].listPackingIdentifier());
             placeholder.write();
             return type;
         }
@@ -1085,6 +1100,7 @@ Type CallableParserAndGenerator::parseIdentifier(const Token &token, Type expect
         case E_GRAPES: {
             writeBoxingAndTemporary(des, Type::callableIncomplete(), token.position());
             writer.writeInstruction(INS_CLOSURE, token);
+            auto closureIndexPlaceholder = writer.writeInstructionPlaceholder(token);
 
             auto function = Closure(token.position());
             parseArgumentList(&function, typeContext);
@@ -1093,6 +1109,7 @@ Type CallableParserAndGenerator::parseIdentifier(const Token &token, Type expect
 
             auto variableCountPlaceholder = writer.writeInstructionPlaceholder(token);
             auto coinCountPlaceholder = writer.writeInstructionsCountPlaceholderCoin(token);
+            auto bodyStart = writer.writtenInstructions();
 
             auto closureScoper = CapturingCallableScoper(scoper);
 
@@ -1101,18 +1118,31 @@ Type CallableParserAndGenerator::parseIdentifier(const Token &token, Type expect
             analyzer.analyze();
 
             coinCountPlaceholder.write();
+            function.instructionCount = writer.writtenInstructions() - bodyStart;
             variableCountPlaceholder.write(closureScoper.fullSize());
             writer.writeInstruction(static_cast<EmojicodeInstruction>(function.arguments.size())
                                     | (analyzer.usedSelfInBody() ? 1 << 16 : 0), token);
 
             writer.writeInstruction(static_cast<EmojicodeInstruction>(closureScoper.captures().size()), token);
             writer.writeInstruction(closureScoper.captureSize(), token);
+            int captureIndex = 0;
             for (auto capture : closureScoper.captures()) {
                 writer.writeInstruction(capture.id, token);
                 writer.writeInstruction(capture.type.size(), token);
                 writer.writeInstruction(capture.captureId, token);
+                capture.type.objectVariableRecords(captureIndex, function.captureInformation);
+                captureIndex += capture.type.size();
             }
 
+            // The garbage collector needs to know the variables of the closure’s frame and the captured variables
+            function.relocate(bodyStart);
+            function.bodyStart = bodyStart;
+            function.fullSize = closureScoper.fullSize();
+            auto objectMode = mode == CallableParserAndGeneratorMode::ObjectMethod
+                              || mode == CallableParserAndGeneratorMode::ObjectInitializer;
+            function.objectContext = analyzer.usedSelfInBody() && objectMode;
+            closureIndexPlaceholder.write(writer.writeClosure(function));
+
             return function.type();
         }
         case E_LOLLIPOP: {
@@ -1232,6 +1262,12 @@ Type CallableParserAndGenerator::parseIdentifier(const Token &token, Type expect
 
             type.unbox();
 
+            if (type.type() == TypeContent::Class && type.eclass() == CL_LIST && !type.optional() &&
+                type.genericArguments[0].listPackingIdentifier() != T_NOTHINGNESS) {
+                // Inserted through a copy so that the boxing is inserted before and applies to the packed list
+                auto packingPoint = insertionPoint;
+                packingPoint.insert({ INS_PACK_LIST, type.genericArguments[0].listPackingIdentifier() });
+            }
             writeBoxingAndTemporary(des, type, token.position(), insertionPoint);
             return type;
         }
@@ -1272,6 +1308,11 @@ Type CallableParserAndGenerator::parseIdentifier(const Token &token, Type expect
             effect = true;
             auto insertionPoint = writer.getInsertionPoint();
             auto placeholder = writer.writeInstructionPlaceholder(token);
+            // The operators of primitives are written directly and their results boxed like a method's
+            auto operatorResult = [&](Type type) {
+                writeBoxingAndTemporary(des, type, token.position(), insertionPoint);
+                return type;
+            };
 
             auto calleePair = parseMethodCallee();
             Type type = calleePair.first;
@@ -1286,17 +1327,17 @@ Type CallableParserAndGenerator::parseIdentifier(const Token &token, Type expect
                     switch (token.value()[0]) {
                         case E_NEGATIVE_SQUARED_CROSS_MARK:
                             placeholder.write(INS_INVERT_BOOLEAN);
-                            return Type::boolean();
+                            return operatorResult(Type::boolean());
                         case E_PARTY_POPPER:
                             placeholder.write(INS_OR_BOOLEAN);
                             parse(stream_.consumeToken(), token, Type::boolean(),
                                   Destination::temporaryReference());
-                            return Type::boolean();
+                            return operatorResult(Type::boolean());
                         case E_CONFETTI_BALL:
                             placeholder.write(INS_AND_BOOLEAN);
                             parse(stream_.consumeToken(), token, Type::boolean(),
                                   Destination::temporaryReference());
-                            return Type::boolean();
+                            return operatorResult(Type::boolean());
                     }
                 }
                 else if (type.valueType() == VT_INTEGER) {
@@ -1305,78 +1346,78 @@ Type CallableParserAndGenerator::parseIdentifier(const Token &token, Type expect
                             placeholder.write(INS_SUBTRACT_INTEGER);
                             parse(stream_.consumeToken(), token, Type::integer(),
                                   Destination::temporaryReference());
-                            return Type::integer();
+                            return operatorResult(Type::integer());
                         case E_HEAVY_PLUS_SIGN:
                             placeholder.write(INS_ADD_INTEGER);
                             parse(stream_.consumeToken(), token, Type::integer(),
                                   Destination::temporaryReference());
-                            return Type::integer();
+                            return operatorResult(Type::integer());
                         case E_HEAVY_DIVISION_SIGN:
                             placeholder.write(INS_DIVIDE_INTEGER);
                             parse(stream_.consumeToken(), token, Type::integer(),
                                   Destination::temporaryReference());
-                            return Type::integer();
+                            return operatorResult(Type::integer());
                         case E_HEAVY_MULTIPLICATION_SIGN:
                             placeholder.write(INS_MULTIPLY_INTEGER);
                             parse(stream_.consumeToken(), token, Type::integer(),
                                   Destination::temporaryReference());
-                            return Type::integer();
+                            return operatorResult(Type::integer());
                         case E_LEFT_POINTING_TRIANGLE:
                             placeholder.write(INS_LESS_INTEGER);
                             parse(stream_.consumeToken(), token, Type::integer(),
                                   Destination::temporaryReference());
-                            return Type::boolean();
+                            return operatorResult(Type::boolean());
                         case E_RIGHT_POINTING_TRIANGLE:
                             placeholder.write(INS_GREATER_INTEGER);
                             parse(stream_.consumeToken(), token, Type::integer(),
                                   Destination::temporaryReference());
-                            return Type::boolean();
+                            return operatorResult(Type::boolean());
                         case E_LEFTWARDS_ARROW:
                             placeholder.write(INS_LESS_OR_EQUAL_INTEGER);
                             parse(stream_.consumeToken(), token, Type::integer(),
                                   Destination::temporaryReference());
-                            return Type::boolean();
+                            return operatorResult(Type::boolean());
                         case E_RIGHTWARDS_ARROW:
                             placeholder.write(INS_GREATER_OR_EQUAL_INTEGER);
                             parse(stream_.consumeToken(), token, Type::integer(),
                                   Destination::temporaryReference());
-                            return Type::boolean();
+                            return operatorResult(Type::boolean());
                         case E_PUT_LITTER_IN_ITS_SPACE:
                             placeholder.write(INS_REMAINDER_INTEGER);
                             parse(stream_.consumeToken(), token, Type::integer(),
                                   Destination::temporaryReference());
-                            return Type::integer();
+                            return operatorResult(Type::integer());
                         case E_HEAVY_LARGE_CIRCLE:
                             placeholder.write(INS_BINARY_AND_INTEGER);
                             parse(stream_.consumeToken(), token, Type::integer(),
                                   Destination::temporaryReference());
-                            return Type::integer();
+                            return operatorResult(Type::integer());
                         case E_ANGER_SYMBOL:
                             placeholder.write(INS_BINARY_OR_INTEGER);
                             parse(stream_.consumeToken(), token, Type::integer(),
                                   Destination::temporaryReference());
-                            return Type::integer();
+                            return operatorResult(Type::integer());
                         case E_CROSS_MARK:
                             placeholder.write(INS_BINARY_XOR_INTEGER);
                             parse(stream_.consumeToken(), token, Type::integer(),
                                   Destination::temporaryReference());
-                            return Type::integer();
+                            return operatorResult(Type::integer());
                         case E_NO_ENTRY_SIGN:
                             placeholder.write(INS_BINARY_NOT_INTEGER);
-                            return Type::integer();
+                            return operatorResult(Type::integer());
                         case E_ROCKET:
                             placeholder.write(INS_INT_TO_DOUBLE);
-                            return Type::doubl();
+                            return operatorResult(Type::doubl());
                         case E_LEFT_POINTING_BACKHAND_INDEX:
                             placeholder.write(INS_SHIFT_LEFT_INTEGER);
                             parse(stream_.consumeToken(), token, Type::integer(),
                                   Destination::temporaryReference());
-                            return Type::integer();
+                            return operatorResult(Type::integer());
                         case E_RIGHT_POINTING_BACKHAND_INDEX:
                             placeholder.write(INS_SHIFT_RIGHT_INTEGER);
                             parse(stream_.consumeToken(), token, Type::integer(),
                                   Destination::temporaryReference());
-                            return Type::integer();
+                            return operatorResult(Type::integer());
                     }
                 }
                 else if (type.valueType() == VT_DOUBLE) {
@@ -1385,52 +1426,52 @@ Type CallableParserAndGenerator::parseIdentifier(const Token &token, Type expect
                             placeholder.write(INS_EQUAL_DOUBLE);
                             parse(stream_.consumeToken(), token, Type::doubl(),
                                   Destination::temporaryReference());
-                            return Type::boolean();
+                            return operatorResult(Type::boolean());
                         case E_HEAVY_MINUS_SIGN:
                             placeholder.write(INS_SUBTRACT_DOUBLE);
                             parse(stream_.consumeToken(), token, Type::doubl(),
                                   Destination::temporaryReference());
-                            return Type::doubl();
+                            return operatorResult(Type::doubl());
                         case E_HEAVY_PLUS_SIGN:
                             placeholder.write(INS_ADD_DOUBLE);
                             parse(stream_.consumeToken(), token, Type::doubl(),
                                   Destination::temporaryReference());
-                            return Type::doubl();
+                            return operatorResult(Type::doubl());
                         case E_HEAVY_DIVISION_SIGN:
                             placeholder.write(INS_DIVIDE_DOUBLE);
                             parse(stream_.consumeToken(), token, Type::doubl(),
                                   Destination::temporaryReference());
-                            return Type::doubl();
+                            return operatorResult(Type::doubl());
                         case E_HEAVY_MULTIPLICATION_SIGN:
                             placeholder.write(INS_MULTIPLY_DOUBLE);
                             parse(stream_.consumeToken(), token, Type::doubl(),
                                   Destination::temporaryReference());
-                            return Type::doubl();
+                            return operatorResult(Type::doubl());
                         case E_LEFT_POINTING_TRIANGLE:
                             placeholder.write(INS_LESS_DOUBLE);
                             parse(stream_.consumeToken(), token, Type::doubl(),
                                   Destination::temporaryReference());
-                            return Type::boolean();
+                            return operatorResult(Type::boolean());
                         case E_RIGHT_POINTING_TRIANGLE:
                             placeholder.write(INS_GREATER_DOUBLE);
                             parse(stream_.consumeToken(), token, Type::doubl(),
                                   Destination::temporaryReference());
-                            return Type::boolean();
+                            return operatorResult(Type::boolean());
                         case E_LEFTWARDS_ARROW:
                             placeholder.write(INS_LESS_OR_EQUAL_DOUBLE);
                             parse(stream_.consumeToken(), token, Type::doubl(),
                                   Destination::temporaryReference());
-                            return Type::boolean();
+                            return operatorResult(Type::boolean());
                         case E_RIGHTWARDS_ARROW:
                             placeholder.write(INS_GREATER_OR_EQUAL_DOUBLE);
                             parse(stream_.consumeToken(), token, Type::doubl(),
                                   Destination::temporaryReference());
-                            return Type::boolean();
+                            return operatorResult(Type::boolean());
                         case E_PUT_LITTER_IN_ITS_SPACE:
                             placeholder.write(INS_REMAINDER_DOUBLE);
                             parse(stream_.consumeToken(), token, Type::doubl(),
                                   Destination::temporaryReference());
-                            return Type::doubl();
+                            return operatorResult(Type::doubl());
                     }
                 }
 
@@ -1438,7 +1479,7 @@ Type CallableParserAndGenerator::parseIdentifier(const Token &token, Type expect
                     parse(stream_.consumeToken(), token, type,
                           Destination(DestinationMutability::Unknown, StorageType::Simple));
                     placeholder.write(INS_EQUAL_PRIMITIVE);
-                    return Type::boolean();
+                    return operatorResult(Type::boolean());
                 }
 
                 method = type.valueType()->getMethod(token, type, typeContext);
@@ -1457,7 +1498,7 @@ Type CallableParserAndGenerator::parseIdentifier(const Token &token, Type expect
                     auto destination = Destination(DestinationMutability::Unknown, StorageType::Simple);
                     parse(stream_.consumeToken(), token, type, destination);  // Must be of the same type as the callee
                     placeholder.write(INS_EQUAL_PRIMITIVE);
-                    return Type::boolean();
+                    return operatorResult(Type::boolean());
                 }
                 method = type.eenum()->getMethod(token, type, typeContext);
                 placeholder.write(INS_CALL_CONTEXTED_FUNCTION);
@@ -1590,7 +1631,7 @@ void CallableParserAndGenerator::analyze() {
             }
         }
 
-        scoper.popScopeAndRecommendFrozenVariables(static_cast<Function &>(callable).objectVariableInformation(),
+        scoper.popScopeAndRecommendFrozenVariables(callable.objectVariableInformation(),
                                                    writer.writtenInstructions());
 
         if (isFullyInitializedCheckRequired()) {
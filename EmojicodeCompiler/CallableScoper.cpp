@@ -23,12 +23,20 @@ void CallableScoper::popScopeAndRecommendFrozenVariables(std::vector<FunctionObj
 
     for (Scope &scope : scopes_) {
         for (auto variable : scope.map()) {
-            if (variable.second.initializationLevel() == 1) {
+            // The variables of a scope pushed before the initialization level, like the variable of a for-in loop,
+            // are initialized at a higher level but must be marked until their scope is popped nonetheless
+            bool inPoppedScope = &scope == &scopes_.front() && variable.second.initialized();
+            if (variable.second.initializationLevel() == 1 || inPoppedScope) {
                 variable.second.type().objectVariableRecords(variable.second.id(), info,
                                                              variable.second.initializationPosition(), count);
             }
         }
     }
+    for (auto variable : scope.internalVariables()) {
+        if (variable.initialized()) {
+            variable.type().objectVariableRecords(variable.id(), info, variable.initializationPosition(), count);
+        }
+    }
     scopes_.pop_front();
 }
 
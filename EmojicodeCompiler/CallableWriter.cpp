@@ -30,6 +30,19 @@ void CallableWriter::writeDoubleCoin(double val, SourcePosition p) {
     writeInstruction(exp, p);
 }
 
+EmojicodeInstruction CallableWriter::writeClosure(const Closure &closure) {
+    closures_.push_back(closure);
+    return static_cast<EmojicodeInstruction>(closures_.size() - 1);
+}
+
+void CallableWriter::moveClosures(size_t index, size_t count) {
+    for (auto &closure : closures_) {
+        if (closure.bodyStart >= index) {
+            closure.bodyStart += count;
+        }
+    }
+}
+
 CallableWriterPlaceholder CallableWriter::writeInstructionPlaceholder(SourcePosition p) {
     writeInstruction(0, p);
     return CallableWriterPlaceholder(this, instructions_.size() - 1);
@@ -54,10 +67,12 @@ void CallableWriterCoinsCountPlaceholder::write() {
 
 void CallableWriterInsertionPoint::insert(EmojicodeInstruction value) {
     writer_->instructions_.insert(writer_->instructions_.begin() + index_, value);
+    writer_->moveClosures(index_, 1);
     index_++;
 }
 
 void CallableWriterInsertionPoint::insert(std::initializer_list<EmojicodeInstruction> values) {
     writer_->instructions_.insert(writer_->instructions_.begin() + index_, values);
+    writer_->moveClosures(index_, values.size());
     index_ += values.size();
 }
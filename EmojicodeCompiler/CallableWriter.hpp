@@ -11,6 +11,7 @@
 
 #include <vector>
 #include "EmojicodeCompiler.hpp"
+#include "Callable.hpp"
 
 class CallableWriter;
 class Writer;
@@ -77,8 +78,15 @@ public:
 
     /** Must be used to write any double to the file. */
     virtual void writeDoubleCoin(double val, SourcePosition p);
+
+    /// Stores @c closure, whose instructions were written, and returns the index by which INS_CLOSURE refers to it.
+    virtual EmojicodeInstruction writeClosure(const Closure &closure);
 private:
+    /// Moves the blocks of the stored closures that begin at or after @c index as @c count instructions were inserted.
+    void moveClosures(size_t index, size_t count);
+
     std::vector<EmojicodeInstruction> instructions_;
+    std::vector<Closure> closures_;
 };
 
 class WriteLocation {
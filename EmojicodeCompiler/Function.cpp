@@ -9,7 +9,6 @@
 #include "Function.hpp"
 #include <map>
 #include <stdexcept>
-#include <numeric>
 #include "Lexer.hpp"
 #include "CompilerError.hpp"
 #include "EmojicodeCompiler.hpp"
@@ -124,9 +123,13 @@ void Function::markUsed() {
         Function::compilationQueue.push(this);
     }
     else {
-        fullSize_ = std::accumulate(arguments.begin(), arguments.end(), 0, [](int a, Argument b) {
-            return a + b.type.size();
-        });
+        // The arguments are the only variables of a native function and must be marked as it might allocate objects
+        fullSize_ = 0;
+        for (auto &argument : arguments) {
+            argument.type.objectVariableRecords(fullSize_, objectVariableInformation_, InstructionCount(0),
+                                                InstructionCount(0));
+            fullSize_ += argument.type.size();
+        }
     }
     for (Function *function : overriders_) {
         function->markUsed();
@@ -46,6 +46,12 @@ int Scope::allocateInternalVariable(Type type) {
     return id;
 }
 
+Variable& Scope::allocateInternalVariable(Type type, SourcePosition p) {
+    int id = allocateInternalVariable(type);
+    internalVariables_.emplace_back(type, id, true, EmojicodeString(), p);
+    return internalVariables_.back();
+}
+
 Variable& Scope::getLocalVariable(const EmojicodeString &variable) {
     return map_.find(variable)->second;
 }
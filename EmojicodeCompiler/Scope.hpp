@@ -9,6 +9,7 @@
 #ifndef Scope_hpp
 #define Scope_hpp
 
+#include <list>
 #include <map>
 #include "Token.hpp"
 #include "Variable.hpp"
@@ -28,6 +29,9 @@ public:
     Variable& setLocalVariable(const EmojicodeString &variable, Type type, bool frozen, SourcePosition pos);
     /// Allocates a variable for internal use only and returns its ID.
     int allocateInternalVariable(Type type);
+    /// Allocates a variable for internal use only. Unlike the variables allocated by the method above, it is marked by
+    /// the garbage collector from the position at which it is initialized until the scope is popped.
+    Variable& allocateInternalVariable(Type type, SourcePosition p);
 
     /**
      * Retrieves a variable form the scope or returns @c nullptr.
@@ -51,6 +55,7 @@ public:
     size_t size() const { return size_; }
 
     const std::map<EmojicodeString, Variable>& map() const { return map_; }
+    const std::list<Variable>& internalVariables() const { return internalVariables_; }
 
     void markInherited() {
         for (auto &pair : map_) {
@@ -59,6 +64,7 @@ public:
     }
 private:
     std::map<EmojicodeString, Variable> map_;
+    std::list<Variable> internalVariables_;
     int size_ = 0;
     Scoper *scoper_;
 };
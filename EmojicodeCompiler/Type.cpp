@@ -369,6 +369,24 @@ EmojicodeInstruction Type::boxIdentifier() const {
     return meta() ? (value | META_MASK) : value;
 }
 
+EmojicodeInstruction Type::listPackingIdentifier() const {
+    if (optional() || meta() || isValueReference()) {
+        return T_NOTHINGNESS;
+    }
+    switch (type()) {
+        case TypeContent::Callable:
+        case TypeContent::Class:
+        case TypeContent::Someobject:
+        case TypeContent::Enum:
+            return boxIdentifier();
+        case TypeContent::ValueType:
+            // Only primitives are known to occupy a single value
+            return valueType()->isPrimitive() ? boxIdentifier() : T_NOTHINGNESS;
+        default:
+            return T_NOTHINGNESS;
+    }
+}
+
 bool Type::requiresBox() const {
     switch (type()) {
         case TypeContent::ValueType:
@@ -113,6 +113,9 @@ public:
     StorageType storageType() const;
     /// Returns a numeric identifier used to differentiate Nothingness, Object References and Value Types at run-time.
     EmojicodeInstruction boxIdentifier() const;
+    /// Returns the box identifier with which a list of elements of this type is packed at run-time, or @c T_NOTHINGNESS
+    /// if the elements must be stored in boxes.
+    EmojicodeInstruction listPackingIdentifier() const;
     /// Unboxes this type.
     /// @throws std::logic_error if unboxing is not possible according to @c requiresBox()
     void unbox() { forceBox_ = false; if (requiresBox()) throw std::logic_error("Cannot unbox!"); }
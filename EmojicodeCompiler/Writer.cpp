@@ -42,16 +42,12 @@ void Writer::writeBytes(const char *bytes, size_t count) {
 void Writer::writeFunction(Function *function) {
     writeUInt16(function->getVti());
     writeByte(static_cast<uint8_t>(function->arguments.size()));
+    writeUInt16(function->argumentsSize());
+    auto mode = function->compilationMode();
+    writeByte(mode == CallableParserAndGeneratorMode::ObjectMethod
+              || mode == CallableParserAndGeneratorMode::ObjectInitializer ? 1 : 0);
 
-    writeUInt16(function->objectVariableInformation().size());
-    for (auto info : function->objectVariableInformation()) {
-        writeUInt16(info.index);
-        writeUInt16(info.conditionIndex);
-        writeUInt16(static_cast<uint16_t>(info.type));
-        writeInstruction(info.from);
-        writeInstruction(info.to);
-    }
-
+    writeObjectVariableInformation(function->objectVariableInformation());
     writeUInt16(function->fullSize());
 
     if (function->isNative()) {
@@ -65,4 +61,33 @@ void Writer::writeFunction(Function *function) {
     for (auto coin : function->writer_.instructions_) {
         writeInstruction(coin);
     }
+
+    writeUInt16(function->writer_.closures_.size());
+    for (auto &closure : function->writer_.closures_) {
+        writeByte(static_cast<uint8_t>(closure.arguments.size()));
+        writeUInt16(closure.argumentsSize());
+        writeByte(closure.objectContext ? 1 : 0);
+        writeObjectVariableInformation(closure.objectVariableInformation());
+        writeUInt16(closure.fullSize);
+        writeInstruction(closure.bodyStart);
+        writeInstruction(closure.instructionCount);
+
+        writeUInt16(closure.captureInformation.size());
+        for (auto info : closure.captureInformation) {
+            writeUInt16(info.index);
+            writeUInt16(info.conditionIndex);
+            writeUInt16(static_cast<uint16_t>(info.type));
+        }
+    }
+}
+
+void Writer::writeObjectVariableInformation(const std::vector<FunctionObjectVariableInformation> &information) {
+    writeUInt16(information.size());
+    for (auto info : information) {
+        writeUInt16(info.index);
+        writeUInt16(info.conditionIndex);
+        writeUInt16(static_cast<uint16_t>(info.type));
+        writeInstruction(info.from);
+        writeInstruction(info.to);
+    }
 }
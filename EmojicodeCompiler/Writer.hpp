@@ -9,12 +9,14 @@
 #ifndef Writer_hpp
 #define Writer_hpp
 
+#include <vector>
 #include "EmojicodeCompiler.hpp"
 
 template <typename T>
 class WriterPlaceholder;
 class WriterCoinsCountPlaceholder;
 class Function;
+struct FunctionObjectVariableInformation;
 
 /**
  * The writer finally writes all types to the byte file.
@@ -52,6 +54,9 @@ public:
         return WriterPlaceholder<T>(*this, position);
     }
 private:
+    /// Writes the object variable information of a function or closure, which the loader turns into stack maps.
+    void writeObjectVariableInformation(const std::vector<FunctionObjectVariableInformation> &information);
+
     void write(uint16_t v) { writeUInt16(v); };
     void write(uint32_t v) { writeEmojicodeChar(v); };
     void write(unsigned char v) { writeByte(v); };
@@ -77,6 +77,8 @@ enum EmojicodeInstructionConstants {
     INS_CONDITIONAL_PRODUCE_BOX = 0x3E,
     INS_CONDITIONAL_PRODUCE_SIMPLE_OPTIONAL = 0x86,
     INS_COPY_REFERENCE = 0x87,
+    // Packs the list produced by the following instruction with the given box type
+    INS_PACK_LIST = 0x88,
     // Know it’s an object instance and want to cast it to a subclass
     INS_DOWNCAST_TO_CLASS = 0x40,
     INS_CAST_TO_PROTOCOL = 0x41,
@@ -13,7 +13,7 @@
 
 struct Class {
     Class() {}
-    explicit Class(void (*mark)(Object *)) : instanceVariableRecords(nullptr), mark(mark), size(0), valueSize(0) {}
+    explicit Class(void (*mark)(Object *)) : pointerMap(), mark(mark), size(0), valueSize(0) {}
 
     /** Returns true if @c a inherits from class @c from */
     bool inheritsFrom(Class *from) const;
@@ -26,8 +26,8 @@ struct Class {
     /** The class’s superclass */
     struct Class *superclass;
 
-    ObjectVariableRecord *instanceVariableRecords;
-    unsigned int instanceVariableRecordsCount;
+    /// The instance variables that contain object references
+    PointerMap pointerMap;
 
     /** Marker FunctionPointer for GC */
     void (*mark)(Object *self);
@@ -36,4 +36,8 @@ struct Class {
     size_t valueSize;
 };
 
+void* Object::value() const {
+    return const_cast<Byte *>(reinterpret_cast<const Byte *>(this)) + sizeof(Object) + klass->size - klass->valueSize;
+}
+
 #endif /* Class_hpp */
@@ -52,6 +52,8 @@ union Value {
 #warning Double does not match the size of an 64-bit integer
 #endif
 
+/// The header of an object, which is followed by its instance variables and its value area. The size of an object is
+/// determined by its class, only arrays store their size in their first word.
 struct Object {
     union {
         /// The class of the object
@@ -59,14 +61,10 @@ struct Object {
         /// Used by the Garbage Collector, do not change!
         Object *newLocation;
     };
-    /** The size of this object: the size of the Object struct and the value area. */
-    size_t size;
-    /**
-     * A pointer to the allocated @c value area. This area is as large as specified in the class.
-     * @warning Never change the content of this variable as the Garbage Collector updates this field
-     * in each cycle.
-     */
-    void *value;
+
+    /// Returns a pointer to the value area, which follows the instance variables and is as large as specified in the
+    /// class. Defined in Class.hpp.
+    inline void* value() const;
 
     inline Value* variableDestination(EmojicodeInstruction index) {
         return reinterpret_cast<Value *>(reinterpret_cast<Byte *>(this) + sizeof(Object) + sizeof(Value) * index);
@@ -101,8 +99,18 @@ struct Box {
 struct String {
     /** The number of code points in @c characters. Strings are not null terminated! */
     EmojicodeInteger length;
-    /** The characters of this string. Strings are not null terminated! */
+    /// The object holding the characters of this string if it has shared backing, or @c nullptr if the characters are
+    /// stored inline behind the string. Shared backing is an array, or the string whose inline characters a substring
+    /// refers to. They take one byte each if @c latin1 is true and are UTF-32 code points otherwise. Strings are not
+    /// null terminated!
     Object *characters;
+    /// The hash of the characters or 0 if it was not computed yet. Use @c stringHash to obtain it.
+    uint64_t hash;
+    /// True if and only if all characters are below 256. Every string whose characters allow it must be stored in this
+    /// form, so that equal strings are always stored in the same form.
+    bool latin1;
+    /// The offset in bytes of the first character from the value of @c characters if the string has shared backing.
+    uint32_t offset;
 };
 
 struct Data {
@@ -152,10 +160,20 @@ extern Object* newArray(size_t size);
  * @param array An array object created by @c newArray.
  * @param size The new size.
  * @returns A pointer to the resized array.
- * @warning GC-invoking
+ * @warning GC-invoking unless the array is shrunk, which never moves it.
  */
 extern Object* resizeArray(Object *array, size_t size);
 
+/// Allocates a string with room for @c length characters, which are zero. They are stored inline behind the string
+/// unless they are too large, in which case an array is allocated as shared backing.
+/// @warning GC-invoking
+extern Object* newString(size_t length, bool latin1);
+
+/// Changes the length of a string created by @c newString, whose characters are stored inline, and returns a pointer
+/// to the resized string. Characters are kept up to the new length and added characters are zero.
+/// @warning GC-invoking
+extern Object* resizeString(Object *string, size_t length);
+
 
 // MARK: Garbage Collection
 
@@ -164,6 +182,24 @@ extern Object* resizeArray(Object *array, size_t size);
  * @warning This function will modify @c P to point to an exact copy of @c O after the function call.
  */
 extern void mark(Object **of);
+
+#define cardShift 9
+#define cardSize (1 << cardShift)
+extern Byte *cardedSpace;
+extern size_t cardedSpaceSize;
+extern Byte *cardTable;
+
+/**
+ * Records that a reference to an object was stored into @c object, which is required by the generational collector.
+ * You must call this function after storing a reference into an object, unless no allocation happened since
+ * @c object was allocated or @c object is retained (see @c Thread::retain) until no more references are stored.
+ */
+inline void writeBarrier(Object *object) {
+    uintptr_t offset = reinterpret_cast<uintptr_t>(object) - reinterpret_cast<uintptr_t>(cardedSpace);
+    if (offset < cardedSpaceSize) {
+        cardTable[offset >> cardShift] = 1;
+    }
+}
 /**
  * If the calling thread needs to be paused for the GC to run, this function will first
  * unlock @c mutex if it is not a @c nullptr pointer, then block until the GC cycle is completed
@@ -6,307 +6,225 @@
 //  Copyright (c) 2015 Theo Weidmann. All rights reserved.
 //
 
-#include <functional>
+#include <cstring>
+#include <cstdint>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 #include "EmojicodeDictionary.h"
 #include "EmojicodeAPI.hpp"
 #include "EmojicodeString.h"
 #include "Thread.hpp"
 
-#define FNV_PRIME_64 1099511628211
-#define FNV_OFFSET_64 14695981039346656037U
-EmojicodeDictionaryHash fnv64(const char *k, size_t length) {
-    EmojicodeDictionaryHash hash = FNV_OFFSET_64;
-    for (size_t i = 0; i < length; i++) {
-        hash = hash ^ k[i];
-        hash = hash * FNV_PRIME_64;
-    }
-    return hash;
-}
-
 EmojicodeDictionaryHash dictionaryHash(EmojicodeDictionary *dict, Object *key) {
-    #define hashString(keyString) fnv64((char*)characters(keyString), ((keyString)->length) * sizeof(EmojicodeChar))
-    return hashString((String *) key->value);
+    return stringHash(static_cast<String *>(key->value()));
 }
 
 bool dictionaryKeyEqual(EmojicodeDictionary *dict, Object *key1, Object *key2) {
-    return stringEqual((String *) key1->value, (String *) key2->value);
-}
-
-bool dictionaryKeyHashEqual(EmojicodeDictionary *dict, EmojicodeDictionaryHash hash1,
-                            EmojicodeDictionaryHash hash2, Object *key1, Object *key2) {
-    return (hash1 == hash2) && dictionaryKeyEqual(dict, key1, key2);
+    return stringEqual((String *) key1->value(), (String *) key2->value());
 }
 
 // MARK: Internal dictionary
-EmojicodeDictionaryNode* dictionaryGetNode(EmojicodeDictionary *dict, EmojicodeDictionaryHash hash, Object *key) {
-    EmojicodeDictionaryNode *e;
-    Object** bucko;
-    size_t n = 0;
-    if (dict->buckets != nullptr) {
-        bucko = (Object**) dict->buckets->value;
-        if ((n = dict->bucketsCounter) > 0) {
-            Object *firsto = bucko[hash & (n - 1)];
-            if (firsto != nullptr) {
-                e = static_cast<EmojicodeDictionaryNode *>(firsto->value);
-                if (dictionaryKeyHashEqual(dict, hash, e->hash, key, e->key)) {
-                    return e;
-                }
-                Object *eo;
-                while ((eo = e->next)) {
-                    e = static_cast<EmojicodeDictionaryNode *>(eo->value);
-                    if (dictionaryKeyHashEqual(dict, hash, e->hash, key, e->key)) {
-                        return e;
-                    }
-                }
-            }
-        }
-    }
-    return nullptr;
-}
-
-Object* dictionaryNewNode(EmojicodeDictionaryHash hash, Object *key, Box value, Object *next, Thread *thread) {
-    Object *nodeo = newArray(sizeof(EmojicodeDictionaryNode));
-    EmojicodeDictionaryNode *node = (EmojicodeDictionaryNode *) nodeo->value;
 
-    node->hash = hash;
-    node->key = key;
-    node->value = value;
-    node->next = next;
-    return nodeo;
+uint8_t* dictionaryControl(Object *table) {
+    return static_cast<uint8_t *>(table->value());
 }
 
-void dictionaryResize(Object *const &dictObject, Thread *thread) {
-    EmojicodeDictionary *dict = static_cast<EmojicodeDictionary *>(dictObject->value);
-
-    Object *oldBuckoo = dict->buckets;
-    size_t oldCap = (oldBuckoo == nullptr) ? 0 : dict->bucketsCounter;
-    size_t oldThr = dict->nextThreshold;
-    size_t newCap = oldCap << 1, newThr = 0;
+EmojicodeDictionarySlot* dictionarySlots(Object *table, size_t capacity) {
+    return reinterpret_cast<EmojicodeDictionarySlot *>(dictionaryControl(table) + capacity);
+}
 
-    if (oldCap > 0) {
-        if (oldCap >= DICTIONARY_MAXIMUM_CAPACTIY) {
-            dict->nextThreshold = DICTIONARY_MAXIMUM_CAPACTIY_THRESHOLD;
-            return;
-        }
-        else if (newCap < DICTIONARY_MAXIMUM_CAPACTIY && oldCap >= DICTIONARY_DEFAULT_INITIAL_CAPACITY) {
-            newThr = oldThr << 1;  // double threshold
-        }
-    }
-    else if (oldThr > 0) {  // initial capacity was placed in threshold
-        newCap = oldThr;
-    }
-    else {  // zero initial threshold signifies using defaults
-        newCap = DICTIONARY_DEFAULT_INITIAL_CAPACITY;
-        newThr = (size_t) (DICTIONARY_DEFAULT_LOAD_FACTOR * DICTIONARY_DEFAULT_INITIAL_CAPACITY);
+/// Returns a mask in which bit i is set if the i-th control byte of @c group is @c byte.
+uint32_t dictionaryGroupMatch(const uint8_t *group, uint8_t byte) {
+#ifdef __SSE2__
+    __m128i control = _mm_loadu_si128(reinterpret_cast<const __m128i *>(group));
+    return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(control, _mm_set1_epi8(static_cast<char>(byte)))));
+#else
+    uint32_t mask = 0;
+    for (int i = 0; i < DICTIONARY_GROUP_SIZE; i++) {
+        mask |= static_cast<uint32_t>(group[i] == byte) << i;
     }
+    return mask;
+#endif
+}
 
-    if (newThr == 0) {
-        float ft = (float) newCap * dict->loadFactor;
-        newThr = (newCap < DICTIONARY_MAXIMUM_CAPACTIY && ft < (float)DICTIONARY_MAXIMUM_CAPACTIY) ? (size_t)ft : DICTIONARY_MAXIMUM_CAPACTIY_THRESHOLD;
+/// Returns a mask in which bit i is set if the i-th slot of @c group holds no item. The control bytes of these slots
+/// are the only ones with the high bit set.
+uint32_t dictionaryGroupMatchFree(const uint8_t *group) {
+#ifdef __SSE2__
+    return static_cast<uint32_t>(_mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(group))));
+#else
+    uint32_t mask = 0;
+    for (int i = 0; i < DICTIONARY_GROUP_SIZE; i++) {
+        mask |= static_cast<uint32_t>(group[i] >> 7) << i;
     }
+    return mask;
+#endif
+}
 
-    Object *newBuckoo = newArray(newCap * sizeof(Object *));
-    dict = static_cast<EmojicodeDictionary *>(dictObject->value);
-
-    dict->buckets = newBuckoo;
-    dict->nextThreshold = newThr;
-    dict->bucketsCounter = newCap;
-
-    Object **newBucko = static_cast<Object **>(newBuckoo->value);
-    if (oldBuckoo != nullptr) {
-        for (int j = 0; j < oldCap; ++j) {
-            Object **oldBucko = static_cast<Object **>(oldBuckoo->value);
-            Object *eo = oldBucko[j];
-            if (eo != nullptr) {
-                EmojicodeDictionaryNode *e = static_cast<EmojicodeDictionaryNode *>(eo->value);
-                oldBucko[j] = nullptr;
-                if (e->next == nullptr) {
-                    newBucko[e->hash & (newCap - 1)] = eo;
-                }
-                else {  // preserve order
-                    Object *loHeado = nullptr, *loTailo = nullptr;
-                    Object *hiHeado = nullptr, *hiTailo = nullptr;
-                    Object *nexto;
-                    do {
-                        e = static_cast<EmojicodeDictionaryNode *>(eo->value);
-                        nexto = e->next;
-                        if ((e->hash & oldCap) == 0) {
-                            if (loTailo == nullptr) {
-                                loHeado = eo;
-                            }
-                            else {
-                                EmojicodeDictionaryNode *loTail = static_cast<EmojicodeDictionaryNode *>(loTailo->value);
-                                loTail->next = eo;
-                            }
-                            loTailo = eo;
-                        }
-                        else {
-                            if (hiTailo == nullptr) {
-                                hiHeado = eo;
-                            }
-                            else {
-                                EmojicodeDictionaryNode *hiTail = static_cast<EmojicodeDictionaryNode *>(hiTailo->value);
-                                hiTail->next = eo;
-                            }
-                            hiTailo = eo;
-                        }
-                    } while ((eo = nexto) != nullptr);
-
-                    if (loTailo != nullptr) {
-                        EmojicodeDictionaryNode *loTail = static_cast<EmojicodeDictionaryNode *>(loTailo->value);
-                        loTail->next = nullptr;
-                        newBucko[j] = loHeado;
-                    }
-                    if (hiTailo != nullptr) {
-                        EmojicodeDictionaryNode *hiTail = static_cast<EmojicodeDictionaryNode *>(hiTailo->value);
-                        hiTail->next = nullptr;
-                        newBucko[j + oldCap] = hiHeado;
-                    }
-                }
+/// Returns the index of the slot holding @c key or @c SIZE_MAX if the key is not in the dictionary.
+size_t dictionaryFind(EmojicodeDictionary *dict, EmojicodeDictionaryHash hash, Object *key) {
+    if (dict->table == nullptr) {
+        return SIZE_MAX;
+    }
+    uint8_t *control = dictionaryControl(dict->table);
+    EmojicodeDictionarySlot *slots = dictionarySlots(dict->table, dict->capacity);
+    size_t groupMask = dict->capacity / DICTIONARY_GROUP_SIZE - 1;
+    // The table always has an empty slot, which ends the probing as the quadratic steps reach every group
+    for (size_t group = (hash >> 7) & groupMask, step = 1;; group = (group + step++) & groupMask) {
+        const uint8_t *groupControl = control + group * DICTIONARY_GROUP_SIZE;
+        for (uint32_t match = dictionaryGroupMatch(groupControl, hash & 0x7F); match != 0; match &= match - 1) {
+            size_t index = group * DICTIONARY_GROUP_SIZE + __builtin_ctz(match);
+            if (slots[index].hash == hash && dictionaryKeyEqual(dict, key, slots[index].key)) {
+                return index;
             }
         }
+        if (dictionaryGroupMatch(groupControl, DICTIONARY_EMPTY) != 0) {
+            return SIZE_MAX;
+        }
     }
 }
 
-void dictionaryPutVal(Object *dicto, Object *key, Box value, Thread *thread) {
-    Object *const &dictionaryObject = thread->retain(dicto);
-    EmojicodeDictionaryHash hash = dictionaryHash(static_cast<EmojicodeDictionary *>(dicto->value), key);
-
-    EmojicodeDictionary *dict = static_cast<EmojicodeDictionary *>(dictionaryObject->value);
-
-    if (dict->buckets == nullptr || dict->bucketsCounter == 0) {
-        dictionaryResize(dictionaryObject, thread);
-        dict = static_cast<EmojicodeDictionary *>(dictionaryObject->value);
+/// Returns the index of the first slot without an item in the probe sequence of @c hash.
+size_t dictionaryFindFree(const uint8_t *control, size_t capacity, EmojicodeDictionaryHash hash) {
+    size_t groupMask = capacity / DICTIONARY_GROUP_SIZE - 1;
+    for (size_t group = (hash >> 7) & groupMask, step = 1;; group = (group + step++) & groupMask) {
+        uint32_t free = dictionaryGroupMatchFree(control + group * DICTIONARY_GROUP_SIZE);
+        if (free != 0) {
+            return group * DICTIONARY_GROUP_SIZE + __builtin_ctz(free);
+        }
     }
+}
 
-    Object **bucko = static_cast<Object **>(dict->buckets->value);
-    size_t n = dict->bucketsCounter, i = 0;
-
-    Object *po;
-
-    if ((po = bucko[i = (hash & (n - 1))]) == nullptr) {
-        bucko[i] = dictionaryNewNode(hash, key, value, nullptr, thread);
-        dict = static_cast<EmojicodeDictionary *>(dictionaryObject->value);
-    }
-    else {
-        EmojicodeDictionaryNode *p = static_cast<EmojicodeDictionaryNode *>(po->value);
-        Object *eo = nullptr;
-        if (dictionaryKeyHashEqual(dict, hash, p->hash, key, p->key)) {
-            eo = po;
-        }
-        else {
-            for (int binCount = 0; ; ++binCount) {
-                if (p->next == nullptr) {
-                    p->next = dictionaryNewNode(hash, key, value, nullptr, thread);
-                    dict = static_cast<EmojicodeDictionary *>(dictionaryObject->value);
-                    eo = nullptr;
-                    break;
-                }
-                eo = p->next;
-                EmojicodeDictionaryNode *e = static_cast<EmojicodeDictionaryNode *>(eo->value);
-
-                if (dictionaryKeyHashEqual(dict, hash, e->hash, key, e->key)) {
-                    break;
-                }
-                p = e;
+/// Moves all items to a new table with @c capacity slots, which drops the deleted slots.
+/// @warning GC-invoking
+void dictionaryRehash(Object *const &dictObject, size_t capacity) {
+    Object *table = newArray(capacity + capacity * sizeof(EmojicodeDictionarySlot));
+    EmojicodeDictionary *dict = static_cast<EmojicodeDictionary *>(dictObject->value());
+
+    uint8_t *control = dictionaryControl(table);
+    EmojicodeDictionarySlot *slots = dictionarySlots(table, capacity);
+    std::memset(control, DICTIONARY_EMPTY, capacity);
+    if (dict->table != nullptr) {
+        uint8_t *oldControl = dictionaryControl(dict->table);
+        EmojicodeDictionarySlot *oldSlots = dictionarySlots(dict->table, dict->capacity);
+        for (size_t i = 0; i < dict->capacity; i++) {
+            if (oldControl[i] & 0x80) {
+                continue;
             }
-        }
-        if (eo != nullptr) {  // existing mapping for key
-            EmojicodeDictionaryNode *e = static_cast<EmojicodeDictionaryNode *>(eo->value);
-            e->value = value;
-            return;
+            size_t index = dictionaryFindFree(control, capacity, oldSlots[i].hash);
+            control[index] = oldControl[i];
+            slots[index] = oldSlots[i];
         }
     }
 
-    if (++dict->size > dict->nextThreshold) {
-        dictionaryResize(dictionaryObject, thread);
-    }
-    thread->release(1);
+    dict->table = table;
+    dict->capacity = capacity;
+    // At most 7/8 of the slots are used
+    dict->growthLeft = capacity - capacity / 8 - dict->size;
+    writeBarrier(dictObject);
 }
 
-EmojicodeDictionaryNode* dictionaryRemoveNode(EmojicodeDictionary *dict, EmojicodeDictionaryHash hash, Object *key, Thread *thread) {
-    size_t n = 0, index = 0;
-    if (dict->buckets != nullptr && (n = dict->bucketsCounter) > 0) {
-        Object **bucko = static_cast<Object **>(dict->buckets->value);
-        Object *po = bucko[index = hash & (n - 1)];
-        if (po != nullptr) {
-            EmojicodeDictionaryNode *p = static_cast<EmojicodeDictionaryNode *>(po->value);
-            EmojicodeDictionaryNode *node = nullptr;
-            if (dictionaryKeyHashEqual(dict, hash, p->hash, key, p->key)) {
-                node = p;
+void dictionaryPutVal(Object *dicto, Object *key, Box value, Thread *thread) {
+    EmojicodeDictionary *dict = static_cast<EmojicodeDictionary *>(dicto->value());
+    EmojicodeDictionaryHash hash = dictionaryHash(dict, key);
+
+    size_t index = dictionaryFind(dict, hash, key);
+    if (index == SIZE_MAX) {
+        if (dict->growthLeft == 0) {
+            Object *const &dictionaryObject = thread->retain(dicto);
+            Object *const &keyObject = thread->retain(key);
+            Object *const &valueObject = thread->retain(value.type.raw == T_OBJECT ? value.value1.object : nullptr);
+            // The table is only grown if the deleted slots are not enough to make room
+            size_t capacity = dict->capacity;
+            if (capacity == 0) {
+                capacity = DICTIONARY_DEFAULT_INITIAL_CAPACITY;
             }
-            else {
-                Object *nexto = p->next;
-                while (nexto) {
-                    EmojicodeDictionaryNode *e = static_cast<EmojicodeDictionaryNode *>(nexto->value);
-                    if (dictionaryKeyHashEqual(dict, hash, e->hash, key, e->key)) {
-                        node = e;
-                        break;
-                    }
-                    p = e;
-                    nexto = e->next;
-                }
+            else if (dict->size >= (capacity - capacity / 8) / 2) {
+                capacity *= 2;
             }
-            if(node != nullptr) {
-                if (node == p) {
-                    bucko[index] = node->next;
-                }
-                else {
-                    p->next = node->next;
-                }
-                dict->size--;
-                return node;
+            dictionaryRehash(dictionaryObject, capacity);
+            dicto = dictionaryObject;
+            key = keyObject;
+            if (value.type.raw == T_OBJECT) {
+                value.value1.object = valueObject;
             }
+            thread->release(3);
+            dict = static_cast<EmojicodeDictionary *>(dicto->value());
         }
+
+        uint8_t *control = dictionaryControl(dict->table);
+        index = dictionaryFindFree(control, dict->capacity, hash);
+        if (control[index] == DICTIONARY_EMPTY) {
+            dict->growthLeft--;
+        }
+        control[index] = hash & 0x7F;
+        EmojicodeDictionarySlot *slot = dictionarySlots(dict->table, dict->capacity) + index;
+        slot->key = key;
+        slot->hash = hash;
+        dict->size++;
     }
-    return nullptr;
+    dictionarySlots(dict->table, dict->capacity)[index].value = value;
+    writeBarrier(dicto);
 }
 
-
 // MARK: Bridge -> Dictionary interface
 void dictionaryRemove(EmojicodeDictionary *dict, Object *key, Thread *thread) {
-    dictionaryRemoveNode(dict, dictionaryHash(dict, key), key, thread);
+    size_t index = dictionaryFind(dict, dictionaryHash(dict, key), key);
+    if (index == SIZE_MAX) {
+        return;
+    }
+    uint8_t *control = dictionaryControl(dict->table);
+    // Probing does not continue past a group with an empty slot, so the slot can become empty if its group has one
+    if (dictionaryGroupMatch(control + index / DICTIONARY_GROUP_SIZE * DICTIONARY_GROUP_SIZE, DICTIONARY_EMPTY) != 0) {
+        control[index] = DICTIONARY_EMPTY;
+        dict->growthLeft++;
+    }
+    else {
+        control[index] = DICTIONARY_DELETED;
+    }
+    EmojicodeDictionarySlot *slot = dictionarySlots(dict->table, dict->capacity) + index;
+    slot->key = nullptr;
+    slot->value.makeNothingness();
+    dict->size--;
 }
 
 bool dictionaryContains(EmojicodeDictionary *dict, Object *key) {
-    return dictionaryGetNode(dict, dictionaryHash(dict, key), key) != nullptr;
+    return dictionaryFind(dict, dictionaryHash(dict, key), key) != SIZE_MAX;
 }
 
 size_t dictionaryClear(EmojicodeDictionary *dict) {
     size_t sizeBefore = dict->size;
-    dict->loadFactor = DICTIONARY_DEFAULT_LOAD_FACTOR;
-    dict->size = 0;
-    dict->buckets = nullptr;
-    dict->nextThreshold = 0;
+    dictionaryInit(dict);
     return sizeBefore;
 }
 
-void dictionaryInit(Thread *thread) {
-    EmojicodeDictionary *dict = static_cast<EmojicodeDictionary *>(thread->getThisObject()->value);
-    dict->loadFactor = DICTIONARY_DEFAULT_LOAD_FACTOR;
+void dictionaryInit(EmojicodeDictionary *dict) {
+    dict->table = nullptr;
+    dict->capacity = 0;
+    dict->size = 0;
+    dict->growthLeft = 0;
 }
 
 void dictionaryMark(Object *object) {
-//    EmojicodeDictionary *dict = static_cast<EmojicodeDictionary *>(object->value);
-//
-//    if(dict->buckets == nullptr){
-//        return;
-//    }
-//    mark(&dict->buckets);
-//
-//    Object **buckets = static_cast<Object **>(dict->buckets->value);
-//    for (size_t i = 0; i < dict->bucketsCounter; i++) {
-//        Object **eo = &buckets[i];
-//        while (*(eo)) {
-//            mark(eo);
-//            EmojicodeDictionaryNode *e = static_cast<EmojicodeDictionaryNode *>((*eo)->value);
-//            mark(&(e->key));
-//            if (isRealObject(e->value)){
-//                mark(&(e->value.object));
-//            }
-//            eo = &(e->next);
-//        }
-//    }
+    EmojicodeDictionary *dict = static_cast<EmojicodeDictionary *>(object->value());
+    if (dict->table == nullptr) {
+        return;
+    }
+    mark(&dict->table);
+
+    uint8_t *control = dictionaryControl(dict->table);
+    EmojicodeDictionarySlot *slots = dictionarySlots(dict->table, dict->capacity);
+    for (size_t group = 0; group < dict->capacity; group += DICTIONARY_GROUP_SIZE) {
+        uint32_t full = ~dictionaryGroupMatchFree(control + group) & ((1u << DICTIONARY_GROUP_SIZE) - 1);
+        for (; full != 0; full &= full - 1) {
+            EmojicodeDictionarySlot &slot = slots[group + __builtin_ctz(full)];
+            mark(&slot.key);
+            if (slot.value.type.raw == T_OBJECT) {
+                mark(&slot.value.value1.object);
+            }
+        }
+    }
 }
 
 //MARK: Bridges
@@ -318,59 +236,57 @@ void bridgeDictionarySet(Thread *thread, Value *destination) {
 
 void bridgeDictionaryGet(Thread *thread, Value *destination) {
     Object *key = thread->getVariable(0).object;
-    EmojicodeDictionary *dictionary = static_cast<EmojicodeDictionary *>(thread->getThisObject()->value);
-    EmojicodeDictionaryNode *node = dictionaryGetNode(dictionary, dictionaryHash(dictionary, key), key);
-    if (node == nullptr) {
+    EmojicodeDictionary *dictionary = static_cast<EmojicodeDictionary *>(thread->getThisObject()->value());
+    size_t index = dictionaryFind(dictionary, dictionaryHash(dictionary, key), key);
+    if (index == SIZE_MAX) {
         destination->raw = T_NOTHINGNESS;
     }
     else {
-        node->value.copyTo(destination);
+        dictionarySlots(dictionary->table, dictionary->capacity)[index].value.copyTo(destination);
     }
 }
 
 void bridgeDictionaryRemove(Thread *thread, Value *destination) {
-    dictionaryRemove(static_cast<EmojicodeDictionary *>(thread->getThisObject()->value), thread->getVariable(0).object, thread);
+    dictionaryRemove(static_cast<EmojicodeDictionary *>(thread->getThisObject()->value()), thread->getVariable(0).object,
+                     thread);
 }
 
 void bridgeDictionaryKeys(Thread *thread, Value *destination) {
     Object *const &listObject = thread->retain(newObject(CL_LIST));
 
-    EmojicodeDictionary *dict = static_cast<EmojicodeDictionary *>(thread->getThisObject()->value);
-
-    List *newList = static_cast<List *>(listObject->value);
-    newList->capacity = dict->size;
-    Object *items = newArray(sizeof(Value) * dict->size);
-    static_cast<List *>(listObject->value)->items = items;
-
-    for (size_t i = 0, l = dict->bucketsCounter; i < l; i++) {
-        Object **bucko = (Object **)static_cast<EmojicodeDictionary *>(thread->getThisObject()->value)->buckets->value;
-        auto nodeo = std::ref(thread->retain(bucko[i]));
-        while (nodeo) {
-            listAppendDestination(listObject, thread)->copySingleValue(T_OBJECT,
-                                                                       ((EmojicodeDictionaryNode *) nodeo.get()->value)->key);
-            thread->release(1);
-            nodeo = std::ref(thread->retain(((EmojicodeDictionaryNode *) nodeo.get()->value)->next));
+    size_t size = static_cast<EmojicodeDictionary *>(thread->getThisObject()->value())->size;
+    Object *items = newArray(sizeof(Value) * size);
+    List *list = static_cast<List *>(listObject->value());
+    list->items = items;
+    list->capacity = size;
+    list->packedType = T_OBJECT;
+
+    EmojicodeDictionary *dict = static_cast<EmojicodeDictionary *>(thread->getThisObject()->value());
+    for (size_t i = 0; i < dict->capacity; i++) {
+        if (!(dictionaryControl(dict->table)[i] & 0x80)) {
+            Object *key = dictionarySlots(dict->table, dict->capacity)[i].key;
+            list->values()[list->count++].object = key;
         }
-        thread->release(1);
     }
+    writeBarrier(listObject);
 
     thread->release(1);
     destination->object = listObject;
 }
 
 void bridgeDictionaryClear(Thread *thread, Value *destination) {
-    destination->raw = static_cast<EmojicodeInteger>(dictionaryClear(static_cast<EmojicodeDictionary *>(thread->getThisObject()->value)));
+    destination->raw = static_cast<EmojicodeInteger>(dictionaryClear(static_cast<EmojicodeDictionary *>(thread->getThisObject()->value())));
 }
 
 void bridgeDictionaryContains(Thread *thread, Value *destination) {
     Object *key = thread->getVariable(0).object;
-    destination->raw = dictionaryContains(static_cast<EmojicodeDictionary *>(thread->getThisObject()->value), key);
+    destination->raw = dictionaryContains(static_cast<EmojicodeDictionary *>(thread->getThisObject()->value()), key);
 }
 
 void bridgeDictionarySize(Thread *thread, Value *destination) {
-    destination->raw = static_cast<EmojicodeInteger>(static_cast<EmojicodeDictionary *>(thread->getThisObject()->value)->size);
+    destination->raw = static_cast<EmojicodeInteger>(static_cast<EmojicodeDictionary *>(thread->getThisObject()->value())->size);
 }
 
 void initDictionaryBridge(Thread *thread, Value *destination) {
-    dictionaryInit(thread);
+    dictionaryInit(static_cast<EmojicodeDictionary *>(thread->getThisObject()->value()));
 }
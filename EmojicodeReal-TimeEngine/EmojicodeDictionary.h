@@ -11,60 +11,52 @@
 
 #include "EmojicodeString.h"
 
-/** Default initial capacity. MUST be a power of two, default: 8 */
-#define DICTIONARY_DEFAULT_INITIAL_CAPACITY (1 << 3)
+/// The number of control bytes that are probed at once. The capacity of a dictionary is a multiple of it.
+#define DICTIONARY_GROUP_SIZE 16
 
-/** Factor for determining whether the dictionary should be resized. */
-#define DICTIONARY_DEFAULT_LOAD_FACTOR (0.75f)
+/// The capacity of a dictionary when the first item is inserted. MUST be a power of two.
+#define DICTIONARY_DEFAULT_INITIAL_CAPACITY DICTIONARY_GROUP_SIZE
 
-#define DICTIONARY_MAXIMUM_CAPACTIY (1 << 30)
-
-#define DICTIONARY_MAXIMUM_CAPACTIY_THRESHOLD (1 << 16)
+/// The control byte of a slot that never held an item. Probing ends at a group with such a slot.
+#define DICTIONARY_EMPTY 0x80
+/// The control byte of a slot whose item was removed
+#define DICTIONARY_DELETED 0xFE
 
 typedef uint64_t EmojicodeDictionaryHash;
 
-/** The datastructure with the key-value pair */
+/// A slot of the table of a dictionary, which holds an item if its control byte says so.
 typedef struct {
-    /** The user specified key. */
+    /// The user specified key.
     Object *key;
-    
-    /** The user specified value. */
-    Box value;
-    
-    /** The cached hash for the key. Calculated on item addition. */
+    /// The cached hash for the key. Calculated on item addition.
     EmojicodeDictionaryHash hash;
-    
-    /** EmojicodeDictionary stores a bucket's elements in a linked list. */
-    Object *next;
-    
-} EmojicodeDictionaryNode;
+    /// The user specified value.
+    Box value;
+} EmojicodeDictionarySlot;
 
-/** Structure for the Emojicode standard Dictionary. The implementation is similar to Java's Hashmap. */
+/// Structure for the Emojicode standard Dictionary, an open addressing hash table similar to Google’s SwissTable.
+/// The table is an array of @c capacity control bytes followed by @c capacity slots. A control byte is
+/// @c DICTIONARY_EMPTY, @c DICTIONARY_DELETED or the lower 7 bits of the hash of the key in its slot. The slots are
+/// divided into groups of @c DICTIONARY_GROUP_SIZE, which are probed in quadratic steps starting at the group selected
+/// by the upper bits of the hash. All control bytes of a group are compared to the hash at once.
 typedef struct {
-    /** An array with pointers to linked lists. Initializes when the first item is inserted. */
-    Object *buckets;
-    
-    /** Length of buckets array. */
-    size_t bucketsCounter;
-    
-    /** The number of items stored in this dictionary. Used for determining whether to resize. */
+    /// The array with the control bytes and the slots. Allocated when the first item is inserted.
+    Object *table;
+    /// The number of slots, a power of two or 0.
+    size_t capacity;
+    /// The number of items stored in this dictionary.
     size_t size;
-    
-    /** When size * loadFactor >= bucketsCounter the dictionary doubles the amount of buckets */
-    float loadFactor;
-    
-    /** Stores the next threshold for resizing. Is 0 until first resize when item is inserted. */
-    size_t nextThreshold;
+    /// The number of empty slots that may still be filled before the table must be rehashed.
+    size_t growthLeft;
 } EmojicodeDictionary;
 
+/// Sets the value for @c key in the dictionary @c dicto.
+/// @warning GC-invoking
 void dictionaryPutVal(Object *dicto, Object *key, Box value, Thread *thread);
 
 /** Remove an item by keyString as key */
 void dictionaryRemove(EmojicodeDictionary *dict, Object *key, Thread *thread);
 
-/** Get an item by keyString as key */
-Value dictionaryLookup(EmojicodeDictionary *dict, Object *key, Thread *thread);
-
 /** Check whether a key is in the dictionary */
 bool dictionaryContains(EmojicodeDictionary *dict, Object *key);
 
@@ -72,8 +64,8 @@ void dictionaryMark(Object *dict);
 
 void initDictionaryBridge(Thread *thread, Value *destination);
 
-/** @warning GC-invoking */
-void dictionaryInit(Thread *thread);
+/// Initializes the empty dictionary @c dict.
+void dictionaryInit(EmojicodeDictionary *dict);
 
 void bridgeDictionarySet(Thread *thread, Value *destination);
 void bridgeDictionaryGet(Thread *thread, Value *destination);
@@ -7,51 +7,100 @@
 //
 
 #include "EmojicodeList.h"
+#include <algorithm>
+#include <cmath>
 #include <cstring>
+#include <functional>
 #include <utility>
+#include <vector>
 #include "EmojicodeString.h"
 #include "Thread.hpp"
 
 void expandListSize(Object *const &listObject) {
 #define initialSize 7
-    List *list = static_cast<List *>(listObject->value);
+    List *list = static_cast<List *>(listObject->value());
     if (list->capacity == 0) {
-        Object *object = newArray(sizeof(Box) * initialSize);
-        list = static_cast<List *>(listObject->value);
+        Object *object = newArray(list->elementSize() * initialSize);
+        list = static_cast<List *>(listObject->value());
         list->items = object;
         list->capacity = initialSize;
+        writeBarrier(listObject);
     }
     else {
         size_t newSize = list->capacity + (list->capacity >> 1);
-        Object *object = resizeArray(list->items, sizeCalculationWithOverflowProtection(newSize, sizeof(Box)));
-        list = static_cast<List *>(listObject->value);
+        Object *object = resizeArray(list->items, sizeCalculationWithOverflowProtection(newSize, list->elementSize()));
+        list = static_cast<List *>(listObject->value());
         list->items = object;
         list->capacity = newSize;
+        writeBarrier(listObject);
     }
 #undef initialSize
 }
 
 void listEnsureCapacity(Thread *thread, size_t size) {
-    List *list = static_cast<List *>(thread->getThisObject()->value);
+    List *list = static_cast<List *>(thread->getThisObject()->value());
     if (list->capacity < size) {
         Object *object;
         if (list->capacity == 0) {
-            object = newArray(sizeCalculationWithOverflowProtection(size, sizeof(Box)));
+            object = newArray(sizeCalculationWithOverflowProtection(size, list->elementSize()));
         }
         else {
-            object = resizeArray(list->items, sizeCalculationWithOverflowProtection(size, sizeof(Box)));
+            object = resizeArray(list->items, sizeCalculationWithOverflowProtection(size, list->elementSize()));
         }
-        list = static_cast<List *>(thread->getThisObject()->value);
+        list = static_cast<List *>(thread->getThisObject()->value());
         list->items = object;
         list->capacity = size;
+        writeBarrier(thread->getThisObject());
     }
 }
 
+void listPack(Object *lo, EmojicodeInteger type) {
+    List *list = static_cast<List *>(lo->value());
+    if (type == T_NOTHINGNESS || list->packed()) {
+        return;
+    }
+    // The values are moved to the front of the items, the remainder of which is released
+    for (size_t i = 0; i < list->count; i++) {
+        list->values()[i] = list->elements()[i].value1;
+    }
+    if (list->items != nullptr) {
+        list->items = resizeArray(list->items, list->capacity * sizeof(Value));
+    }
+    list->packedType = type;
+}
+
+/// Stores the elements of the packed list @c listObject as Boxes, so that elements of other types, like Nothingness,
+/// can be stored. @warning GC-invoking
+static void listUnpack(Object *const &listObject) {
+    List *list = static_cast<List *>(listObject->value());
+    if (!list->packed()) {
+        return;
+    }
+    Object *items = newArray(sizeCalculationWithOverflowProtection(list->capacity, sizeof(Box)));
+    list = static_cast<List *>(listObject->value());
+    auto boxes = static_cast<Box *>(items->value());
+    for (size_t i = 0; i < list->count; i++) {
+        boxes[i] = list->element(i);
+    }
+    list->items = items;
+    list->packedType = T_NOTHINGNESS;
+    writeBarrier(listObject);
+}
+
 void listMark(Object *self) {
-    List *list = static_cast<List *>(self->value);
+    List *list = static_cast<List *>(self->value());
     if (list->items) {
         mark(&list->items);
     }
+    if (list->packed()) {
+        // Packed lists of primitives do not contain any references
+        if (list->packedType == T_OBJECT) {
+            for (size_t i = 0; i < list->count; i++) {
+                mark(&list->values()[i].object);
+            }
+        }
+        return;
+    }
     for (size_t i = 0; i < list->count; i++) {
         if (list->elements()[i].type.raw == T_OBJECT) {
            mark(&list->elements()[i].value1.object);
@@ -59,27 +108,53 @@ void listMark(Object *self) {
     }
 }
 
-Box* listAppendDestination(Object *lo, Thread *thread) {
-    Object *const &listObject = thread->retain(lo);
-    List *list = static_cast<List *>(lo->value);
+/// Makes room for one more element at the end of @c listObject and returns its index. @warning GC-invoking
+static size_t listAddSlot(Object *const &listObject) {
+    List *list = static_cast<List *>(listObject->value());
     if (list->capacity - list->count == 0) {
         expandListSize(listObject);
     }
-    list = static_cast<List *>(listObject->value);
+    return static_cast<List *>(listObject->value())->count++;
+}
+
+Value* listAppendDestination(Object *lo, Thread *thread) {
+    Object *const &listObject = thread->retain(lo);
+    // The caller stores a Box, the type of which is not known yet
+    listUnpack(listObject);
+    size_t index = listAddSlot(listObject);
+    // The caller stores into the returned slot without allocating before
+    writeBarrier(listObject);
     thread->release(1);
-    return list->elements() + list->count++;
+    return static_cast<List *>(listObject->value())->slot(index);
+}
+
+void listAppend(Object *lo, Thread *thread, const Box &box) {
+    Object *const &listObject = thread->retain(lo);
+    // The list might grow, which moves the object of the element
+    Box element = box;
+    Object *const &object = thread->retain(element.type.raw == T_OBJECT ? element.value1.object : nullptr);
+    if (!static_cast<List *>(listObject->value())->canStore(element)) {
+        listUnpack(listObject);
+    }
+    size_t index = listAddSlot(listObject);
+    if (element.type.raw == T_OBJECT) {
+        element.value1.object = object;
+    }
+    static_cast<List *>(listObject->value())->setElement(index, element);
+    writeBarrier(listObject);
+    thread->release(2);
 }
 
 void listCountBridge(Thread *thread, Value *destination) {
-    destination->raw = static_cast<List *>(thread->getThisObject()->value)->count;
+    destination->raw = static_cast<List *>(thread->getThisObject()->value())->count;
 }
 
 void listAppendBridge(Thread *thread, Value *destination) {
-    *listAppendDestination(thread->getThisObject(), thread) = *reinterpret_cast<Box *>(thread->variableDestination(0));
+    listAppend(thread->getThisObject(), thread, *reinterpret_cast<Box *>(thread->variableDestination(0)));
 }
 
 void listGetBridge(Thread *thread, Value *destination) {
-    List *list = static_cast<List *>(thread->getThisObject()->value);
+    List *list = static_cast<List *>(thread->getThisObject()->value());
     EmojicodeInteger index = thread->getVariable(0).raw;
     if (index < 0) {
         index += list->count;
@@ -88,11 +163,17 @@ void listGetBridge(Thread *thread, Value *destination) {
         destination->makeNothingness();
         return;
     }
-    list->elements()[index].copyTo(destination);
+    list->element(index).copyTo(destination);
+}
+
+/// Clears the element at @c index, which is no longer used, so that the GC does not see a stale reference.
+static void listClearElement(List *list, size_t index) {
+    if (list->packed()) list->values()[index].raw = 0;
+    else list->elements()[index].makeNothingness();
 }
 
 void listRemoveBridge(Thread *thread, Value *destination) {
-    List *list = static_cast<List *>(thread->getThisObject()->value);
+    List *list = static_cast<List *>(thread->getThisObject()->value());
     EmojicodeInteger index = thread->getVariable(0).raw;
     if (index < 0) {
         index += list->count;
@@ -101,26 +182,26 @@ void listRemoveBridge(Thread *thread, Value *destination) {
         destination->raw = 0;
         return;
     }
-    std::memmove(list->elements() + index, list->elements() + index + 1, sizeof(Box) * (list->count - index - 1));
-    list->elements()[--list->count].makeNothingness();
+    std::memmove(list->slot(index), list->slot(index + 1), list->elementSize() * (list->count - index - 1));
+    listClearElement(list, --list->count);
     destination->raw = 1;
 }
 
 void listPopBridge(Thread *thread, Value *destination) {
-    List *list = static_cast<List *>(thread->getThisObject()->value);
+    List *list = static_cast<List *>(thread->getThisObject()->value());
     if (list->count == 0) {
         destination->makeNothingness();
         return;
     }
     size_t index = --list->count;
-    Box v = list->elements()[index];
-    list->elements()[index].makeNothingness();
+    Box v = list->element(index);
+    listClearElement(list, index);
     v.copyTo(destination);
 }
 
 void listInsertBridge(Thread *thread, Value *destination) {
     EmojicodeInteger index = thread->getVariable(0).raw;
-    List *list = static_cast<List *>(thread->getThisObject()->value);
+    List *list = static_cast<List *>(thread->getThisObject()->value());
 
     if (index < 0) {
         index += list->count;
@@ -130,109 +211,443 @@ void listInsertBridge(Thread *thread, Value *destination) {
         return;
     }
 
+    Object *&object = thread->currentStackFrame()->thisContext.object;
+    if (!list->canStore(*reinterpret_cast<Box *>(thread->variableDestination(1)))) {
+        listUnpack(object);
+        list = static_cast<List *>(thread->getThisObject()->value());
+    }
     if (list->capacity - list->count == 0) {
-        Object *&object = thread->currentStackFrame()->thisContext.object;
         expandListSize(object);
     }
 
-    list = static_cast<List *>(thread->getThisObject()->value);
+    list = static_cast<List *>(thread->getThisObject()->value());
 
-    std::memmove(list->elements() + index + 1, list->elements() + index, sizeof(Box) * (list->count++ - index));
-    list->elements()[index].copy(thread->variableDestination(1));
+    std::memmove(list->slot(index + 1), list->slot(index), list->elementSize() * (list->count++ - index));
+    list->setElement(index, *reinterpret_cast<Box *>(thread->variableDestination(1)));
+    writeBarrier(thread->getThisObject());
 }
 
-void listQSort(Thread *thread, size_t off, size_t n) {
-    if (n < 2)
-        return;
+// MARK: Sorting
+
+// The comparator closure may allocate and thereby move the list, its elements and the closure, so the sorts below
+// refer to elements by index and fetch them again after every call. Elements held outside the list are kept in a
+// retained buffer list, never in C++ variables across a call.
+
+/// Orders elements by calling the comparator closure, which is the first argument of the sorting method, and checks
+/// that the comparator does not change the length of the list, which would invalidate the indices.
+class ClosureOrder {
+public:
+    explicit ClosureOrder(Thread *thread) : thread_(thread), count_(list()->count) {
+        Object *callable = thread->getVariable(0).object;
+        Function *function = callable->klass == CL_CAPTURED_FUNCTION_CALL
+                                ? static_cast<CapturedFunctionCall *>(callable->value())->function
+                                : static_cast<Closure *>(callable->value())->function;
+        // The comparator takes two elements of the same type, which are boxed if it is generic
+        elementSize_ = function->argumentsSize / 2;
+        if (elementSize_ > STORAGE_BOX_VALUE_SIZE) {
+            error("The elements of the list are too large to be passed to the comparator.");
+        }
+    }
 
-    Box *items = ((List *)thread->getThisObject()->value)->elements() + off;
-    Box pivot = items[n / 2];
-    size_t i, j;
-
-    for (i = 0, j = n - 1; ; i++, j--) {
-        while (true) {
-            Value args[2 * STORAGE_BOX_VALUE_SIZE];
-            items[i].copyTo(args);
-            pivot.copyTo(args + STORAGE_BOX_VALUE_SIZE);
-            Value c;
-            executeCallableExtern(thread->getVariable(0).object, args, thread, &c);
-            items = ((List *)thread->getThisObject()->value)->elements() + off;
-            if (c.raw >= 0) break;
-            i++;
-        }
-
-        while (true) {
-            Value args[2 * STORAGE_BOX_VALUE_SIZE];
-            items[i].copyTo(args);
-            pivot.copyTo(args + STORAGE_BOX_VALUE_SIZE);
-            Value c;
-            executeCallableExtern(thread->getVariable(0).object, args, thread, &c);
-            items = ((List *)thread->getThisObject()->value)->elements() + off;
-            if (c.raw >= 0) break;
-            j--;
-        }
-
-        if (i >= j)
-            break;
+    Object* listObject() const { return thread_->getThisObject(); }
+    List* list() const { return static_cast<List *>(listObject()->value()); }
+    Box element(size_t index) const { return list()->element(index); }
+
+    /// Returns true if @c a must be ordered before @c b. Both are copied before the comparator is called, which takes
+    /// them unboxed unless its parameters are generic.
+    bool less(Box a, Box b) const {
+        Value args[2 * STORAGE_BOX_VALUE_SIZE];
+        if (elementSize_ == STORAGE_BOX_VALUE_SIZE) {
+            a.copyTo(args);
+            b.copyTo(args + STORAGE_BOX_VALUE_SIZE);
+        }
+        else {
+            std::memcpy(args, &a.value1, elementSize_ * sizeof(Value));
+            std::memcpy(args + elementSize_, &b.value1, elementSize_ * sizeof(Value));
+        }
+        Value c;
+        executeCallableExtern(thread_->getVariable(0).object, args, thread_, &c);
+        if (list()->count != count_) {
+            error("The list was modified by the comparator while it was being sorted.");
+        }
+        return c.raw < 0;
+    }
+    bool less(size_t a, size_t b) const { return less(element(a), element(b)); }
+    void swap(size_t a, size_t b) const {
+        List *list = this->list();
+        if (list->packed()) std::swap(list->values()[a], list->values()[b]);
+        else std::swap(list->elements()[a], list->elements()[b]);
+    }
+    /// Moves the element at @c from to @c to, which is before it, and shifts the elements in between to the right.
+    void moveBefore(size_t from, size_t to) const {
+        List *list = this->list();
+        Box element = list->element(from);
+        std::memmove(list->slot(to + 1), list->slot(to), (from - to) * list->elementSize());
+        list->setElement(to, element);
+    }
+private:
+    Thread *thread_;
+    size_t count_;
+    /// The number of values of an element as passed to the comparator
+    int elementSize_;
+};
+
+/// Sorts three elements and leaves the median at @c b.
+static void sort3(const ClosureOrder &order, size_t a, size_t b, size_t c) {
+    if (order.less(b, a)) order.swap(a, b);
+    if (order.less(c, b)) {
+        order.swap(b, c);
+        if (order.less(b, a)) order.swap(a, b);
+    }
+}
+
+static void insertionSort(const ClosureOrder &order, size_t begin, size_t end) {
+    for (size_t i = begin + 1; i < end; i++) {
+        for (size_t j = i; j > begin && order.less(j, j - 1); j--) {
+            order.swap(j, j - 1);
+        }
+    }
+}
 
-        std::swap(items[i], items[j]);
+/// Insertion sort that gives up and returns false once more than 8 elements had to be moved.
+static bool partialInsertionSort(const ClosureOrder &order, size_t begin, size_t end) {
+    size_t moves = 0;
+    for (size_t i = begin + 1; i < end; i++) {
+        size_t j = i;
+        for (; j > begin && order.less(j, j - 1); j--) {
+            order.swap(j, j - 1);
+        }
+        moves += i - j;
+        if (moves > 8) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void siftDown(const ClosureOrder &order, size_t begin, size_t root, size_t size) {
+    while (2 * root + 1 < size) {
+        size_t child = 2 * root + 1;
+        if (child + 1 < size && order.less(begin + child, begin + child + 1)) child++;
+        if (!order.less(begin + root, begin + child)) return;
+        order.swap(begin + root, begin + child);
+        root = child;
     }
+}
 
-    listQSort(thread, off, i);
-    listQSort(thread, off + i, n - i);
+static void heapSort(const ClosureOrder &order, size_t begin, size_t end) {
+    size_t size = end - begin;
+    for (size_t i = size / 2; i-- > 0;) {
+        siftDown(order, begin, i, size);
+    }
+    for (size_t i = size - 1; i > 0; i--) {
+        order.swap(begin, begin + i);
+        siftDown(order, begin, 0, i);
+    }
+}
+
+/// Partitions the elements around the pivot at @c begin so that the elements equal to the pivot end up on the right.
+/// Returns the new position of the pivot and stores whether no elements had to be swapped in @c alreadyPartitioned.
+/// All scans are bounded, as a comparator that is not a strict weak order must not make them leave the range.
+static size_t partitionRight(const ClosureOrder &order, size_t begin, size_t end, bool *alreadyPartitioned) {
+    size_t first = begin + 1, last = end;
+    while (first < end && order.less(first, begin)) first++;
+    while (last > first && !order.less(last - 1, begin)) last--;
+    *alreadyPartitioned = first >= last;
+    while (first < last) {
+        order.swap(first, --last);
+        first++;
+        while (first < last && order.less(first, begin)) first++;
+        while (last > first && !order.less(last - 1, begin)) last--;
+    }
+    size_t pivot = first - 1;
+    order.swap(begin, pivot);
+    return pivot;
+}
+
+/// Partitions the elements around the pivot at @c begin so that the elements equal to the pivot end up on the left
+/// and returns the new position of the pivot. Used if the pivot equals the element before the range, in which case no
+/// element can be less than the pivot and the elements equal to it need not be sorted any further.
+static size_t partitionLeft(const ClosureOrder &order, size_t begin, size_t end) {
+    size_t first = begin + 1, last = end;
+    while (last > first && order.less(begin, last - 1)) last--;
+    while (first < last && !order.less(begin, first)) first++;
+    while (first < last) {
+        order.swap(first, --last);
+        first++;
+        while (last > first && order.less(begin, last - 1)) last--;
+        while (first < last && !order.less(begin, first)) first++;
+    }
+    size_t pivot = first - 1;
+    order.swap(begin, pivot);
+    return pivot;
+}
+
+/// Pattern-defeating quicksort by Orson Peters: Introsort that detects sorted runs and many equal elements, which
+/// it sorts in linear time, and breaks up patterns that would lead to bad partitions.
+static void patternDefeatingQuicksort(const ClosureOrder &order, size_t begin, size_t end, int badAllowed,
+                                      bool leftmost) {
+    while (true) {
+        size_t size = end - begin;
+        if (size < 24) {
+            insertionSort(order, begin, end);
+            return;
+        }
+
+        size_t half = size / 2;
+        if (size > 128) {
+            sort3(order, begin, begin + half, end - 1);
+            sort3(order, begin + 1, begin + half - 1, end - 2);
+            sort3(order, begin + 2, begin + half + 1, end - 3);
+            sort3(order, begin + half - 1, begin + half, begin + half + 1);
+            order.swap(begin, begin + half);
+        }
+        else {
+            sort3(order, begin + half, begin, end - 1);
+        }
+
+        if (!leftmost && !order.less(begin - 1, begin)) {
+            begin = partitionLeft(order, begin, end) + 1;
+            continue;
+        }
+
+        bool alreadyPartitioned;
+        size_t pivot = partitionRight(order, begin, end, &alreadyPartitioned);
+        size_t leftSize = pivot - begin, rightSize = end - pivot - 1;
+        if (leftSize < size / 8 || rightSize < size / 8) {
+            if (--badAllowed == 0) {
+                heapSort(order, begin, end);
+                return;
+            }
+            if (leftSize >= 24) {
+                order.swap(begin, begin + leftSize / 4);
+                order.swap(pivot - 1, pivot - leftSize / 4);
+            }
+            if (rightSize >= 24) {
+                order.swap(pivot + 1, pivot + 1 + rightSize / 4);
+                order.swap(end - 1, end - rightSize / 4);
+            }
+        }
+        else if (alreadyPartitioned && partialInsertionSort(order, begin, pivot) &&
+                 partialInsertionSort(order, pivot + 1, end)) {
+            return;
+        }
+
+        patternDefeatingQuicksort(order, begin, pivot, badAllowed, leftmost);
+        begin = pivot + 1;
+        leftmost = false;
+    }
 }
 
 void listSort(Thread *thread, Value *destination) {
-    List *list = static_cast<List *>(thread->getThisObject()->value);
-    listQSort(thread, 0, list->count);
+    ClosureOrder order(thread);
+    size_t count = order.list()->count;
+    if (count < 2) {
+        return;
+    }
+    int badAllowed = 1;
+    for (size_t n = count; n > 1; n >>= 1) badAllowed++;
+    patternDefeatingQuicksort(order, 0, count, badAllowed, true);
+}
+
+/// Sorts the elements in runs of this many elements with binary insertion before merging them.
+static const size_t stableSortRunLength = 16;
+
+/// Sorts the elements from @c begin to @c end stably by inserting each at the position found by binary search.
+static void binaryInsertionSort(const ClosureOrder &order, size_t begin, size_t end) {
+    for (size_t i = begin + 1; i < end; i++) {
+        size_t low = begin, high = i;
+        while (low < high) {
+            size_t middle = low + (high - low) / 2;
+            if (order.less(i, middle)) high = middle;
+            else low = middle + 1;
+        }
+        order.moveBefore(i, low);
+    }
+}
+
+/// Merges the sorted ranges from @c begin to @c middle and from @c middle to @c end, taking the left element if they
+/// are equal. The shorter range is moved into @c buffer first, which must hold half of the elements.
+static void merge(const ClosureOrder &order, Object *const &buffer, size_t begin, size_t middle, size_t end) {
+    auto bufferList = [&buffer]() { return static_cast<List *>(buffer->value()); };
+    size_t leftCount = middle - begin, rightCount = end - middle;
+    size_t size = order.list()->elementSize();
+
+    if (leftCount <= rightCount) {
+        std::memcpy(bufferList()->slot(0), order.list()->slot(begin), leftCount * size);
+        writeBarrier(buffer);
+        size_t i = 0, j = middle, k = begin;
+        while (i < leftCount && j < end) {
+            if (order.less(order.element(j), bufferList()->element(i))) {
+                order.list()->setElement(k++, order.element(j++));
+            }
+            else {
+                order.list()->setElement(k++, bufferList()->element(i++));
+                writeBarrier(order.listObject());
+            }
+        }
+        std::memcpy(order.list()->slot(k), bufferList()->slot(i), (leftCount - i) * size);
+    }
+    else {
+        // The right range is moved into the buffer and the ranges are merged from their ends
+        std::memcpy(bufferList()->slot(0), order.list()->slot(middle), rightCount * size);
+        writeBarrier(buffer);
+        size_t i = middle, j = rightCount, k = end;
+        while (i > begin && j > 0) {
+            if (order.less(bufferList()->element(j - 1), order.element(i - 1))) {
+                order.list()->setElement(--k, order.element(--i));
+            }
+            else {
+                order.list()->setElement(--k, bufferList()->element(--j));
+                writeBarrier(order.listObject());
+            }
+        }
+        std::memcpy(order.list()->slot(begin), bufferList()->slot(0), j * size);
+    }
+    writeBarrier(order.listObject());
+}
+
+void listStableSort(Thread *thread, Value *destination) {
+    ClosureOrder order(thread);
+    size_t count = order.list()->count;
+    if (count < 2) {
+        return;
+    }
+
+    for (size_t begin = 0; begin < count; begin += stableSortRunLength) {
+        binaryInsertionSort(order, begin, std::min(begin + stableSortRunLength, count));
+    }
+    if (count <= stableSortRunLength) {
+        return;
+    }
+
+    // The buffer is a list so that the garbage collector marks and updates the elements moved into it
+    Object *const &buffer = thread->retain(newObject(CL_LIST));
+    Object *items = newArray(sizeCalculationWithOverflowProtection(count / 2, order.list()->elementSize()));
+    List *bufferList = static_cast<List *>(buffer->value());
+    bufferList->items = items;
+    bufferList->capacity = bufferList->count = count / 2;
+    bufferList->packedType = order.list()->packedType;
+    writeBarrier(buffer);
+
+    for (size_t width = stableSortRunLength; width < count; width *= 2) {
+        for (size_t begin = 0; begin + width < count; begin += 2 * width) {
+            size_t middle = begin + width, end = std::min(begin + 2 * width, count);
+            if (order.less(middle, middle - 1)) {  // otherwise the ranges are in order already
+                merge(order, buffer, begin, middle, end);
+            }
+        }
+    }
+    thread->release(1);
+}
+
+/// Sorts the values of the elements of @c list, which are all of the same type, with @c less. The values of a packed
+/// list are sorted in place.
+template <typename Less>
+static void sortValues(List *list, Less less) {
+    if (list->packed()) {
+        std::sort(list->values(), list->values() + list->count, less);
+        return;
+    }
+    std::vector<Value> values(list->count);
+    for (size_t i = 0; i < list->count; i++) {
+        values[i] = list->elements()[i].value1;
+    }
+    std::sort(values.begin(), values.end(), less);
+    for (size_t i = 0; i < list->count; i++) {
+        list->elements()[i].value1 = values[i];
+    }
+}
+
+void listNaturalSort(Thread *thread, Value *destination) {
+    List *list = static_cast<List *>(thread->getThisObject()->value());
+    if (list->count < 2) {
+        return;
+    }
+    auto isString = [](const Box &box) { return box.type.raw == T_OBJECT && box.value1.object->klass == CL_STRING; };
+    EmojicodeInteger type = list->element(0).type.raw;
+    for (size_t i = 0; i < list->count; i++) {
+        Box element = list->element(i);
+        if (element.type.raw != type || (type == T_OBJECT && !isString(element))) {
+            error("🐆 can only sort lists whose elements are all 🚂, 🚀 or 🔡.");
+        }
+    }
+
+    // Nothing below allocates on the Emojicode heap, so the elements do not move
+    switch (type) {
+        case T_INTEGER:
+            sortValues(list, [](Value a, Value b) { return a.raw < b.raw; });
+            break;
+        case T_DOUBLE:
+            // NaN is ordered after all other numbers to keep the order strict and weak
+            sortValues(list, [](Value a, Value b) {
+                return a.doubl < b.doubl || (std::isnan(b.doubl) && !std::isnan(a.doubl));
+            });
+            break;
+        case T_OBJECT:
+            sortValues(list, [](Value a, Value b) {
+                return stringCompare(static_cast<String *>(a.object->value()),
+                                     static_cast<String *>(b.object->value())) < 0;
+            });
+            break;
+        default:
+            error("🐆 can only sort lists whose elements are all 🚂, 🚀 or 🔡.");
+    }
 }
 
 void listFromListBridge(Thread *thread, Value *destination) {
     Object *const &listO = thread->retain(newObject(CL_LIST));
 
-    List *list = static_cast<List *>(listO->value);
-    List *originalList = static_cast<List *>(thread->getThisObject()->value);
+    List *list = static_cast<List *>(listO->value());
+    List *originalList = static_cast<List *>(thread->getThisObject()->value());
 
+    Object *items = newArray(originalList->elementSize() * originalList->capacity);
+    list = static_cast<List *>(listO->value());
+    originalList = static_cast<List *>(thread->getThisObject()->value());
+    // The count is only set now as the list is marked if the allocation above collects garbage
     list->count = originalList->count;
     list->capacity = originalList->capacity;
-
-    Object *items = newArray(sizeof(Box) * originalList->capacity);
-    list = static_cast<List *>(listO->value);
-    originalList = static_cast<List *>(thread->getThisObject()->value);
+    list->packedType = originalList->packedType;
     list->items = items;
 
-    std::memcpy(list->elements(), originalList->elements(), originalList->count * sizeof(Box));
+    std::memcpy(list->slot(0), originalList->slot(0), originalList->count * originalList->elementSize());
     thread->release(1);
     destination->object = listO;
 }
 
 void listRemoveAllBridge(Thread *thread, Value *destination) {
-    List *list = static_cast<List *>(thread->getThisObject()->value);
-    std::memset(list->elements(), 0, list->count * sizeof(Box));
+    List *list = static_cast<List *>(thread->getThisObject()->value());
+    std::memset(list->slot(0), 0, list->count * list->elementSize());
     list->count = 0;
 }
 
 void listSetBridge(Thread *thread, Value *destination) {
     EmojicodeInteger index = thread->getVariable(0).raw;
-    List *list = static_cast<List *>(thread->getThisObject()->value);
+    List *list = static_cast<List *>(thread->getThisObject()->value());
 
+    // A packed list can neither store elements of another type nor the Nothingness of the elements skipped
+    if (list->count < index || !list->canStore(*reinterpret_cast<Box *>(thread->variableDestination(1)))) {
+        listUnpack(thread->currentStackFrame()->thisContext.object);
+    }
     listEnsureCapacity(thread, index + 1);
-    list = static_cast<List *>(thread->getThisObject()->value);
+    list = static_cast<List *>(thread->getThisObject()->value());
 
     if (list->count <= index)
         list->count = index + 1;
 
-    list->elements()[index].copy(thread->variableDestination(1));
+    list->setElement(index, *reinterpret_cast<Box *>(thread->variableDestination(1)));
+    writeBarrier(thread->getThisObject());
 }
 
 void listShuffleInPlaceBridge(Thread *thread, Value *destination) {
-    List *list = static_cast<List *>(thread->getThisObject()->value);
+    List *list = static_cast<List *>(thread->getThisObject()->value());
     EmojicodeInteger i, n = (EmojicodeInteger)list->count;
     Box tmp;
 
     for (i = n - 1; i > 0; i--) {
         EmojicodeInteger newIndex = secureRandomNumber(0, i);
-        std::swap(list->elements()[i], list->elements()[newIndex]);
+        if (list->packed()) std::swap(list->values()[i], list->values()[newIndex]);
+        else std::swap(list->elements()[i], list->elements()[newIndex]);
     }
 }
 
@@ -247,7 +662,8 @@ void initListEmptyBridge(Thread *thread, Value *destination) {
 void initListWithCapacity(Thread *thread, Value *destination) {
     EmojicodeInteger capacity = thread->getVariable(0).raw;
     Object *n = newArray(sizeCalculationWithOverflowProtection(capacity, sizeof(Box)));
-    List *list = static_cast<List *>(thread->getThisObject()->value);
+    List *list = static_cast<List *>(thread->getThisObject()->value());
     list->capacity = capacity;
     list->items = n;
+    writeBarrier(thread->getThisObject());
 }
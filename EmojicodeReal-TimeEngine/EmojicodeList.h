@@ -10,6 +10,7 @@
 #define EmojicodeList_h
 
 #include "EmojicodeAPI.hpp"
+#include "Class.hpp"
 
 struct List {
     /** The number of elements in the list. */
@@ -17,17 +18,48 @@ struct List {
     /** The capacity of the list. */
     size_t capacity;
     /**
-     * The array which stores the list items which has a size of @c capacity * sizeof(Value).
+     * The array which stores the list items which has a size of @c capacity * elementSize().
      * Can be @c nullptr if @c capacity is 0.
      */
     Object *items;
+    /// The box type of all elements if the list is packed, or @c T_NOTHINGNESS if every element is stored as a Box.
+    /// A packed list stores only the value of each element in a single Value. The compiler packs lists whose elements
+    /// are known to be primitives or objects, only the latter must be marked by the GC.
+    EmojicodeInteger packedType;
 
-    Box* elements() const { return static_cast<Box *>(items->value); }
+    bool packed() const { return packedType != T_NOTHINGNESS; }
+    /// The number of bytes an element occupies in @c items.
+    size_t elementSize() const { return packed() ? sizeof(Value) : sizeof(Box); }
+    /// The elements of a list that is not packed.
+    Box* elements() const { return static_cast<Box *>(items->value()); }
+    /// The elements of a packed list.
+    Value* values() const { return static_cast<Value *>(items->value()); }
+    /// Returns a pointer to the element at @c index, which is a Box unless the list is packed.
+    Value* slot(size_t index) const {
+        return reinterpret_cast<Value *>(static_cast<Byte *>(items->value()) + index * elementSize());
+    }
+
+    /// Returns the element at @c index as Box regardless of how the list stores it.
+    Box element(size_t index) const { return packed() ? Box(packedType, values()[index]) : elements()[index]; }
+    /// Returns true if @c box can be stored with setElement, i.e. the list is not packed or @c box is of @c packedType.
+    bool canStore(const Box &box) const { return !packed() || box.type.raw == packedType; }
+    /// Stores @c box, for which canStore() must return true, at @c index.
+    void setElement(size_t index, const Box &box) const {
+        if (packed()) values()[index] = box.value1;
+        else elements()[index] = box;
+    }
 };
 
 /// Prepares the list for a new element to be added to the end and returns a pointer to where the new element should be
-/// copied.
-Box* listAppendDestination(Object *lo, Thread *thread);
+/// copied as a Box. A packed list is unpacked first. @warning GC-invoking
+Value* listAppendDestination(Object *lo, Thread *thread);
+
+/// Appends @c box to the list @c lo. @warning GC-invoking
+void listAppend(Object *lo, Thread *thread, const Box &box);
+
+/// Packs the list @c lo, all elements of which must be of the type @c type, in place. Does nothing if @c type is
+/// @c T_NOTHINGNESS.
+void listPack(Object *lo, EmojicodeInteger type);
 
 /**
  * Creates a list by copying all references from @c cpdList.
@@ -54,6 +86,8 @@ void listRemoveBridge(Thread *thread, Value *destination);
 void listPopBridge(Thread *thread, Value *destination);
 void listInsertBridge(Thread *thread, Value *destination);
 void listSort(Thread *thread, Value *destination);
+void listStableSort(Thread *thread, Value *destination);
+void listNaturalSort(Thread *thread, Value *destination);
 void listFromListBridge(Thread *thread, Value *destination);
 void listRemoveAllBridge(Thread *thread, Value *destination);
 void listSetBridge(Thread *thread, Value *destination);
@@ -10,11 +10,128 @@
 #include <cstring>
 #include <cmath>
 #include <utility>
+#include <algorithm>
+#include <vector>
 #include "EmojicodeString.h"
 #include "../utf8.h"
 #include "EmojicodeList.h"
 #include "algorithms.h"
 #include "Thread.hpp"
+#include "Object.hpp"
+
+bool isLatin1(const EmojicodeChar *characters, size_t count) {
+    EmojicodeChar bits = 0;
+    for (size_t i = 0; i < count; i++) {
+        bits |= characters[i];
+    }
+    return bits < 256;
+}
+
+void narrowCharacters(uint8_t *destination, const EmojicodeChar *source, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        destination[i] = static_cast<uint8_t>(source[i]);
+    }
+}
+
+void widenCharacters(EmojicodeChar *destination, const uint8_t *source, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        destination[i] = source[i];
+    }
+}
+
+void stringDecodeUTF8(String *string, const char *bytes, size_t size) {
+    if (string->latin1) {
+        u8_tolatin1(latin1Characters(string), string->length, bytes, size);
+    }
+    else {
+        u8_toucs(utf32Characters(string), string->length, bytes, size);
+    }
+}
+
+/// Returns the number of bytes needed to encode @c string as UTF-8.
+static size_t utf8Size(const String *string) {
+    if (string->latin1) {
+        return u8_codingsize_latin1(latin1Characters(string), string->length);
+    }
+    return u8_codingsize(utf32Characters(string), string->length);
+}
+
+/// Encodes @c string as UTF-8 into @c destination, which has room for @c size bytes, and returns the number of bytes
+/// written.
+static size_t stringEncodeUTF8(char *destination, size_t size, const String *string) {
+    if (string->latin1) {
+        return u8_fromlatin1(destination, size, latin1Characters(string), string->length);
+    }
+    return u8_toutf8(destination, size, utf32Characters(string), string->length);
+}
+
+/// Returns true if the characters of @c string starting at @c offset equal the characters of @c part.
+static bool stringRegionEqual(String *string, size_t offset, String *part) {
+    if (string->latin1 == part->latin1) {
+        size_t size = string->latin1 ? 1 : sizeof(EmojicodeChar);
+        return memcmp(static_cast<Byte *>(stringCharacters(string)) + offset * size, stringCharacters(part),
+                      part->length * size) == 0;
+    }
+    if (string->latin1) {
+        return false;  // part contains a character above 255
+    }
+    const EmojicodeChar *characters = utf32Characters(string) + offset;
+    const uint8_t *partCharacters = latin1Characters(part);
+    for (size_t i = 0; i < static_cast<size_t>(part->length); i++) {
+        if (characters[i] != partCharacters[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// Returns the index of the first occurrence of @c search in @c string at or after @c from or -1 if there is none.
+static EmojicodeInteger stringFind(String *string, String *search, size_t from = 0) {
+    size_t length = static_cast<size_t>(string->length);
+    if (search->length == 0 || from > length || static_cast<size_t>(search->length) > length - from) {
+        return -1;
+    }
+    if (string->latin1) {
+        if (!search->latin1) {
+            return -1;  // search contains a character above 255
+        }
+        const uint8_t *characters = latin1Characters(string);
+        auto location = static_cast<const uint8_t *>(findBytesInBytes(characters + from, length - from,
+                                                                      latin1Characters(search), search->length));
+        return location != nullptr ? static_cast<EmojicodeInteger>(location - characters) : -1;
+    }
+    const EmojicodeChar *characters = utf32Characters(string);
+    const EmojicodeChar *location;
+    if (search->latin1) {
+        std::vector<EmojicodeChar> wide(search->length);
+        widenCharacters(wide.data(), latin1Characters(search), search->length);
+        location = findCodePoints(characters + from, length - from, wide.data(), wide.size());
+    }
+    else {
+        location = findCodePoints(characters + from, length - from, utf32Characters(search), search->length);
+    }
+    return location != nullptr ? static_cast<EmojicodeInteger>(location - characters) : -1;
+}
+
+/// Returns the index of the first occurrence of @c character in @c string at or after @c from or -1 if there is none.
+static EmojicodeInteger stringFindCharacter(String *string, EmojicodeChar character, size_t from) {
+    size_t length = static_cast<size_t>(string->length);
+    if (from >= length) {
+        return -1;
+    }
+    if (string->latin1) {
+        if (character >= 256) {
+            return -1;
+        }
+        const uint8_t *characters = latin1Characters(string);
+        auto location = static_cast<const uint8_t *>(memchr(characters + from, static_cast<int>(character),
+                                                            length - from));
+        return location != nullptr ? static_cast<EmojicodeInteger>(location - characters) : -1;
+    }
+    const EmojicodeChar *characters = utf32Characters(string);
+    const EmojicodeChar *location = findCodePoints(characters + from, length - from, &character, 1);
+    return location != nullptr ? static_cast<EmojicodeInteger>(location - characters) : -1;
+}
 
 EmojicodeInteger stringCompare(String *a, String *b) {
     if (a == b) {
@@ -23,17 +140,127 @@ EmojicodeInteger stringCompare(String *a, String *b) {
     if (a->length != b->length) {
         return a->length - b->length;
     }
-
-    return memcmp(a->characters->value, b->characters->value, a->length * sizeof(EmojicodeChar));
+    if (a->latin1 && b->latin1) {
+        return memcmp(latin1Characters(a), latin1Characters(b), a->length);
+    }
+    for (size_t i = 0; i < static_cast<size_t>(a->length); i++) {
+        EmojicodeChar x = stringCharacterAt(a, i), y = stringCharacterAt(b, i);
+        if (x != y) {
+            return x < y ? -1 : 1;
+        }
+    }
+    return 0;
 }
 
 bool stringEqual(String *a, String *b) {
-    return stringCompare(a, b) == 0;
+    if (a == b) {
+        return true;
+    }
+    // Equal strings are always stored in the same form
+    if (a->length != b->length || a->latin1 != b->latin1) {
+        return false;
+    }
+    // Strings whose hashes were computed already are unequal if the hashes are
+    if (a->hash != 0 && b->hash != 0 && a->hash != b->hash) {
+        return false;
+    }
+    size_t size = a->latin1 ? 1 : sizeof(EmojicodeChar);
+    return memcmp(stringCharacters(a), stringCharacters(b), a->length * size) == 0;
 }
 
-/** @warning GC-invoking */
-Object* stringSubstring(EmojicodeInteger from, EmojicodeInteger length, Thread *thread) {
-    String *string = static_cast<String *>(thread->getThisObject()->value);
+uint64_t stringComputeHash(const String *string) {
+    // As equal strings are stored in the same form, the bytes of either form can be hashed
+    auto bytes = static_cast<const Byte *>(stringCharacters(string));
+    size_t size = string->length * (string->latin1 ? 1 : sizeof(EmojicodeChar));
+    uint64_t hash = 0x9E3779B97F4A7C15 ^ static_cast<uint64_t>(string->length);
+    // Eight bytes, that is eight Latin-1 characters or two code points, are mixed in per step
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+        uint64_t word;
+        std::memcpy(&word, bytes + i, sizeof(word));
+        hash = (((hash << 5) | (hash >> 59)) ^ word) * 0x517CC1B727220A95;
+    }
+    if (i < size) {
+        uint64_t word = 0;
+        std::memcpy(&word, bytes + i, size - i);
+        hash = (((hash << 5) | (hash >> 59)) ^ word) * 0x517CC1B727220A95;
+    }
+    // The finalizer of MurmurHash3 spreads the entropy to all bits, the dictionary probes with the lower and upper ones
+    hash ^= hash >> 33;
+    hash *= 0xFF51AFD7ED558CCD;
+    hash ^= hash >> 33;
+    hash *= 0xC4CEB9FE1A85EC53;
+    hash ^= hash >> 33;
+    return hash != 0 ? hash : 1;
+}
+
+/// Copies the first @c count characters of @c source to @c destination starting at @c offset. @c destination must be
+/// stored as UTF-32 unless @c source is Latin-1.
+static void copyCharacters(String *destination, size_t offset, String *source, size_t count) {
+    if (destination->latin1) {
+        memcpy(latin1Characters(destination) + offset, latin1Characters(source), count);
+    }
+    else if (source->latin1) {
+        widenCharacters(utf32Characters(destination) + offset, latin1Characters(source), count);
+    }
+    else {
+        memcpy(utf32Characters(destination) + offset, utf32Characters(source), count * sizeof(EmojicodeChar));
+    }
+}
+
+/// Returns a string buffer with room for at least @c capacity characters, which holds the first @c length characters of
+/// the string buffer @c buffer and is stored as UTF-32 if @c buffer is or @c widen is true. The capacity is at least
+/// doubled so that appending to a buffer takes amortized constant time per character. @warning GC-invoking
+static Object* growStringBuffer(Object *const &buffer, size_t length, size_t capacity, bool widen) {
+    auto bufferString = static_cast<String *>(buffer->value());
+    capacity = std::max(capacity, 2 * static_cast<size_t>(bufferString->length));
+    bool latin1 = !widen && bufferString->latin1;
+    size_t size = latin1 ? capacity : capacity * sizeof(EmojicodeChar);
+    // Large buffers are moved to shared backing in the large object space, where they are not copied by collections
+    if (widen || bufferString->characters != nullptr || size >= largeObjectSize) {
+        Object *newBuffer = newString(capacity, latin1);
+        copyCharacters(static_cast<String *>(newBuffer->value()), 0, static_cast<String *>(buffer->value()), length);
+        return newBuffer;
+    }
+    return resizeString(buffer, capacity);
+}
+
+Object* stringConcatenationBegin() {
+    return newString(16, true);
+}
+
+void stringConcatenationAppend(Thread *thread, Object **buffer, size_t &length, Object *stringObject) {
+    auto string = static_cast<String *>(stringObject->value());
+    auto bufferString = static_cast<String *>((*buffer)->value());
+    size_t required = length + static_cast<size_t>(string->length);
+    // The length of the buffer is its capacity until the concatenation ends
+    bool widen = bufferString->latin1 && !string->latin1;
+    if (required > static_cast<size_t>(bufferString->length) || widen) {
+        Object *const &retainedString = thread->retain(stringObject);
+        *buffer = growStringBuffer(*buffer, length, required, widen);
+        string = static_cast<String *>(retainedString->value());
+        bufferString = static_cast<String *>((*buffer)->value());
+        thread->release(1);
+    }
+    copyCharacters(bufferString, length, string, string->length);
+    length = required;
+}
+
+Object* stringConcatenationEnd(Object *buffer, size_t length) {
+    auto string = static_cast<String *>(buffer->value());
+    if (string->characters == nullptr) {
+        return resizeString(buffer, length);
+    }
+    string->length = length;
+    return buffer;
+}
+
+/// Returns the substring of @c length characters at @c from of the string in the this-slot. Substrings share the
+/// characters of the string unless they are short, a small part of it or must be narrowed to Latin-1. If @c piece is
+/// true, the substring is one of the pieces of a split, which together refer to all of the characters, and shares them
+/// regardless of its part of them. @warning GC-invoking
+static Object* stringSubstring(EmojicodeInteger from, EmojicodeInteger length, Thread *thread, bool piece = false) {
+    String *string = static_cast<String *>(thread->getThisObject()->value());
     if (from >= string->length) {
         length = 0;
         from = 0;
@@ -46,67 +273,85 @@ Object* stringSubstring(EmojicodeInteger from, EmojicodeInteger length, Thread *
     if (length == 0) {
         return emptyString;
     }
+    if (length == string->length) {
+        return thread->getThisObject();
+    }
 
-    Object *const &co = thread->retain(newArray(length * sizeof(EmojicodeChar)));
-
-    Object *ostro = newObject(CL_STRING);
-    String *ostr = static_cast<String *>(ostro->value);
-
-    ostr->length = length;
-    ostr->characters = co;
+    bool latin1 = string->latin1 || isLatin1(utf32Characters(string) + from, length);
+    size_t width = string->latin1 ? 1 : sizeof(EmojicodeChar);
+    size_t offset = (string->characters != nullptr ? string->offset : sizeof(String)) + from * width;
+    if (latin1 == string->latin1 && length * width >= stringViewMinimumSize && offset <= UINT32_MAX &&
+        (piece || string->length <= length * stringViewMaximumRetention)) {
+        Object *viewObject = newObject(CL_STRING);
+        String *view = static_cast<String *>(viewObject->value());
+        Object *stringObject = thread->getThisObject();
+        string = static_cast<String *>(stringObject->value());
+        view->characters = string->characters != nullptr ? string->characters : stringObject;
+        view->offset = static_cast<uint32_t>(offset);
+        view->length = length;
+        view->latin1 = latin1;
+        return viewObject;
+    }
 
-    memcpy(ostr->characters->value, characters(static_cast<String *>(thread->getThisObject()->value)) + from,
-           length * sizeof(EmojicodeChar));
+    Object *ostro = newString(length, latin1);
+    String *ostr = static_cast<String *>(ostro->value());
 
-    thread->release(1);
+    string = static_cast<String *>(thread->getThisObject()->value());
+    if (string->latin1) {
+        memcpy(latin1Characters(ostr), latin1Characters(string) + from, length);
+    }
+    else if (latin1) {
+        narrowCharacters(latin1Characters(ostr), utf32Characters(string) + from, length);
+    }
+    else {
+        memcpy(utf32Characters(ostr), utf32Characters(string) + from, length * sizeof(EmojicodeChar));
+    }
     return ostro;
 }
 
 char* stringToChar(String *str) {
     // Size needed for UTF8 representation
-    size_t ds = u8_codingsize(characters(str), str->length);
+    size_t ds = utf8Size(str);
     // Allocate space for the UTF8 string
     char *utf8str = new char[ds + 1];
     // Convert
-    size_t written = u8_toutf8(utf8str, ds, characters(str), str->length);
+    size_t written = stringEncodeUTF8(utf8str, ds, str);
     utf8str[written] = 0;
     return utf8str;
 }
 
 Object* stringFromChar(const char *cstring) {
-    EmojicodeInteger len = u8_strlen(cstring);
+    size_t size = strlen(cstring);
+    int latin1;
+    EmojicodeInteger len = u8_measure(cstring, size, &latin1, nullptr);
 
     if (len == 0) {
         return emptyString;
     }
 
-    Object *stro = newObject(CL_STRING);
-    String *string = static_cast<String *>(stro->value);
-    string->length = len;
-    string->characters = newArray(len * sizeof(EmojicodeChar));
-
-    u8_toucs(characters(string), len, cstring, strlen(cstring));
+    Object *stro = newString(len, latin1);
+    stringDecodeUTF8(static_cast<String *>(stro->value()), cstring, size);
 
     return stro;
 }
 
 void stringPrintStdoutBrigde(Thread *thread, Value *destination) {
-    String *string = static_cast<String *>(thread->getThisObject()->value);
+    String *string = static_cast<String *>(thread->getThisObject()->value());
     char *utf8str = stringToChar(string);
     printf("%s\n", utf8str);
     delete [] utf8str;
 }
 
 void stringEqualBridge(Thread *thread, Value *destination) {
-    String *a = static_cast<String *>(thread->getThisObject()->value);
-    String *b = static_cast<String *>(thread->getVariable(0).object->value);
+    String *a = static_cast<String *>(thread->getThisObject()->value());
+    String *b = static_cast<String *>(thread->getVariable(0).object->value());
     destination->raw = stringEqual(a, b);
 }
 
 void stringSubstringBridge(Thread *thread, Value *destination) {
     EmojicodeInteger from = thread->getVariable(0).raw;
     EmojicodeInteger length = thread->getVariable(1).raw;
-    String *string = static_cast<String *>(thread->getThisObject()->value);
+    String *string = static_cast<String *>(thread->getThisObject()->value());
 
     if (from < 0) {
         from = (EmojicodeInteger)string->length + from;
@@ -119,36 +364,35 @@ void stringSubstringBridge(Thread *thread, Value *destination) {
 }
 
 void stringIndexOf(Thread *thread, Value *destination) {
-    String *string = static_cast<String *>(thread->getThisObject()->value);
-    String *search = static_cast<String *>(thread->getVariable(0).object->value);
+    String *string = static_cast<String *>(thread->getThisObject()->value());
+    String *search = static_cast<String *>(thread->getVariable(0).object->value());
 
-    const void *location = findBytesInBytes(characters(string), string->length * sizeof(EmojicodeChar),
-                                            characters(search), search->length * sizeof(EmojicodeChar));
-    if (!location) {
+    EmojicodeInteger index = stringFind(string, search);
+    if (index < 0) {
         destination->makeNothingness();
     }
     else {
-        destination->optionalSet(static_cast<EmojicodeInteger>(((Byte *)location - (Byte *)characters(string)) / sizeof(EmojicodeChar)));
+        destination->optionalSet(index);
     }
 }
 
 void stringTrimBridge(Thread *thread, Value *destination) {
-    String *string = static_cast<String *>(thread->getThisObject()->value);
+    String *string = static_cast<String *>(thread->getThisObject()->value());
 
     EmojicodeInteger start = 0;
     EmojicodeInteger stop = string->length - 1;
 
-    while (start < string->length && isWhitespace(characters(string)[start]))
+    while (start < string->length && isWhitespace(stringCharacterAt(string, start)))
         start++;
 
-    while (stop > 0 && isWhitespace(characters(string)[stop]))
+    while (stop > 0 && isWhitespace(stringCharacterAt(string, stop)))
         stop--;
 
     destination->object = stringSubstring(start, stop - start + 1, thread);
 }
 
 void stringGetInput(Thread *thread, Value *destination) {
-    String *prompt = static_cast<String *>(thread->getVariable(0).object->value);
+    String *prompt = static_cast<String *>(thread->getVariable(0).object->value());
     char *utf8str = stringToChar(prompt);
     printf("%s\n", utf8str);
     fflush(stdout);
@@ -159,12 +403,12 @@ void stringGetInput(Thread *thread, Value *destination) {
     size_t bufferUsedSize = 0;
 
     while (true) {
-        fgets((char *)buffer->value + oldBufferSize, bufferSize - oldBufferSize, stdin);
+        fgets((char *)buffer->value() + oldBufferSize, bufferSize - oldBufferSize, stdin);
 
-        bufferUsedSize = strlen(static_cast<char *>(buffer->value));
+        bufferUsedSize = strlen(static_cast<char *>(buffer->value()));
 
         if (bufferUsedSize < bufferSize - 1) {
-            if (((char *)buffer->value)[bufferUsedSize - 1] == '\n') {
+            if (((char *)buffer->value())[bufferUsedSize - 1] == '\n') {
                 bufferUsedSize -= 1;
             }
             break;
@@ -175,213 +419,240 @@ void stringGetInput(Thread *thread, Value *destination) {
         buffer = resizeArray(buffer, bufferSize);
     }
 
-    EmojicodeInteger len = u8_strlen_l(static_cast<char *>(buffer->value), bufferUsedSize);
+    int latin1;
+    EmojicodeInteger len = u8_measure(static_cast<char *>(buffer->value()), bufferUsedSize, &latin1, nullptr);
 
-    String *string = static_cast<String *>(thread->getThisObject()->value);
+    Object *const &retainedBuffer = thread->retain(buffer);
+    Object *chars = newCharacters(len, latin1);
+    String *string = static_cast<String *>(thread->getThisObject()->value());
     string->length = len;
-
-    Object *chars = newArray(len * sizeof(EmojicodeChar));
-    string = static_cast<String *>(thread->getThisObject()->value);
+    string->latin1 = latin1;
     string->characters = chars;
+    writeBarrier(thread->getThisObject());
 
-    u8_toucs(characters(string), len, static_cast<char *>(buffer->value), bufferUsedSize);
+    stringDecodeUTF8(string, static_cast<char *>(retainedBuffer->value()), bufferUsedSize);
+    thread->release(1);
 }
 
 void stringSplitByStringBridge(Thread *thread, Value *destination) {
     Object *const &listObject = thread->retain(newObject(CL_LIST));
+    static_cast<List *>(listObject->value())->packedType = T_OBJECT;
 
-    EmojicodeInteger firstOfSeperator = 0, seperatorIndex = 0, firstAfterSeperator = 0;
-
-    for (EmojicodeInteger i = 0, l = ((String *)thread->getThisObject()->value)->length; i < l; i++) {
-        Object *stringObject = thread->getThisObject();
-        Object *separatorObject = thread->getVariable(0).object;
-        String *separator = (String *)separatorObject->value;
-        if (characters((String *)stringObject->value)[i] == characters(separator)[seperatorIndex]) {
-            if (seperatorIndex == 0) {
-                firstOfSeperator = i;
-            }
-
-            // Full seperator found
-            if (firstOfSeperator + separator->length == i + 1) {
-                Object *stro;
-                if (firstAfterSeperator == firstOfSeperator) {
-                    stro = emptyString;
-                }
-                else {
-                    stro = stringSubstring(firstAfterSeperator, i - firstAfterSeperator - separator->length + 1, thread);
-                }
-                listAppendDestination(listObject, thread)->copySingleValue(T_OBJECT, stro);
-                seperatorIndex = 0;
-                firstAfterSeperator = i + 1;
-            }
-            else {
-                seperatorIndex++;
-            }
-        }
-        else if (seperatorIndex > 0) {  // and not matching
-            seperatorIndex = 0;
-            // We search from the begin of the last partial match
-            i = firstOfSeperator;
+    EmojicodeInteger from = 0;
+    while (true) {
+        String *string = static_cast<String *>(thread->getThisObject()->value());
+        String *separator = static_cast<String *>(thread->getVariable(0).object->value());
+        EmojicodeInteger index = stringFind(string, separator, from);
+        if (index < 0) {
+            break;
         }
+        EmojicodeInteger separatorLength = separator->length;
+        Object *piece = index == from ? emptyString : stringSubstring(from, index - from, thread, true);
+        listAppend(listObject, thread, Box(T_OBJECT, piece));
+        from = index + separatorLength;
     }
 
-    Object *stringObject = thread->getThisObject();
-    String *string = (String *)stringObject->value;
-    listAppendDestination(listObject, thread)->copySingleValue(T_OBJECT, stringSubstring(firstAfterSeperator, string->length - firstAfterSeperator, thread));
+    String *string = static_cast<String *>(thread->getThisObject()->value());
+    Object *last = stringSubstring(from, string->length - from, thread, true);
+    listAppend(listObject, thread, Box(T_OBJECT, last));
 
-    Value list = thread->getVariable(1);
+    destination->object = listObject;
     thread->release(1);
-    *destination = list;
 }
 
 void stringLengthBridge(Thread *thread, Value *destination) {
-    String *string = static_cast<String *>(thread->getThisObject()->value);
+    String *string = static_cast<String *>(thread->getThisObject()->value());
     destination->raw = string->length;
 }
 
 void stringUTF8LengthBridge(Thread *thread, Value *destination) {
-    String *str = static_cast<String *>(thread->getThisObject()->value);
-    destination->raw = u8_codingsize(characters(str), str->length);
+    String *str = static_cast<String *>(thread->getThisObject()->value());
+    destination->raw = utf8Size(str);
 }
 
 void stringByAppendingSymbolBridge(Thread *thread, Value *destination) {
-    String *string = static_cast<String *>(thread->getThisObject()->value);
-    Object *const &co = thread->retain(newArray((string->length + 1) * sizeof(EmojicodeChar)));
-
-    Object *ostro = newObject(CL_STRING);
-    String *ostr = static_cast<String *>(ostro->value);
-    string = static_cast<String *>(thread->getThisObject()->value);
-
-    ostr->length = string->length + 1;
-    ostr->characters = co;
-
-    memcpy(characters(ostr), characters(string), string->length * sizeof(EmojicodeChar));
-
-    characters(ostr)[string->length] = thread->getVariable(0).character;
+    String *string = static_cast<String *>(thread->getThisObject()->value());
+    EmojicodeChar character = thread->getVariable(0).character;
+    bool latin1 = string->latin1 && character < 256;
+    Object *ostro = newString(string->length + 1, latin1);
+    String *ostr = static_cast<String *>(ostro->value());
+    string = static_cast<String *>(thread->getThisObject()->value());
+
+    if (latin1) {
+        memcpy(latin1Characters(ostr), latin1Characters(string), string->length);
+        latin1Characters(ostr)[string->length] = static_cast<uint8_t>(character);
+    }
+    else {
+        if (string->latin1) {
+            widenCharacters(utf32Characters(ostr), latin1Characters(string), string->length);
+        }
+        else {
+            memcpy(utf32Characters(ostr), utf32Characters(string), string->length * sizeof(EmojicodeChar));
+        }
+        utf32Characters(ostr)[string->length] = character;
+    }
 
     destination->object = ostro;
-    thread->release(1);
 }
 
 void stringSymbolAtBridge(Thread *thread, Value *destination) {
     EmojicodeInteger index = thread->getVariable(0).raw;
-    String *str = static_cast<String *>(thread->getThisObject()->value);
+    String *str = static_cast<String *>(thread->getThisObject()->value());
     if (index >= str->length) {
         destination->makeNothingness();
         return;
     }
 
-    destination->optionalSet(characters(str)[index]);
+    destination->optionalSet(stringCharacterAt(str, index));
 }
 
 void stringBeginsWithBridge(Thread *thread, Value *destination) {
-    String *a = static_cast<String *>(thread->getThisObject()->value);
-    String *with = static_cast<String *>(thread->getVariable(0).object->value);
+    String *a = static_cast<String *>(thread->getThisObject()->value());
+    String *with = static_cast<String *>(thread->getVariable(0).object->value());
     if (a->length < with->length) {
         destination->raw = 0;
         return;
     }
 
-    destination->raw = memcmp(a->characters->value, with->characters->value,
-                              with->length * sizeof(EmojicodeChar)) == 0 ? 1 : 0;
+    destination->raw = stringRegionEqual(a, 0, with) ? 1 : 0;
 }
 
 void stringEndsWithBridge(Thread *thread, Value *destination) {
-    String *a = static_cast<String *>(thread->getThisObject()->value);
-    String *end = static_cast<String *>(thread->getVariable(0).object->value);
+    String *a = static_cast<String *>(thread->getThisObject()->value());
+    String *end = static_cast<String *>(thread->getVariable(0).object->value());
     if (a->length < end->length) {
         destination->raw = 0;
         return;
     }
 
-    destination->raw = memcmp(((EmojicodeChar*)a->characters->value) + (a->length - end->length),
-                              end->characters->value, end->length * sizeof(EmojicodeChar)) == 0 ? 1 : 0;
+    destination->raw = stringRegionEqual(a, a->length - end->length, end) ? 1 : 0;
 }
 
 void stringSplitBySymbolBridge(Thread *thread, Value *destination) {
     EmojicodeChar separator = thread->getVariable(0).character;
     Object *const &list = thread->retain(newObject(CL_LIST));
+    static_cast<List *>(list->value())->packedType = T_OBJECT;
 
     EmojicodeInteger from = 0;
-
-    for (EmojicodeInteger i = 0, l = ((String *)thread->getThisObject()->value)->length; i < l; i++) {
-        if (characters((String *)thread->getThisObject()->value)[i] == separator) {
-            listAppendDestination(list, thread)->copySingleValue(T_OBJECT, stringSubstring(from, i - from, thread));
-            from = i + 1;
-        }
+    EmojicodeInteger index;
+    while ((index = stringFindCharacter(static_cast<String *>(thread->getThisObject()->value()), separator,
+                                        from)) >= 0) {
+        Object *piece = stringSubstring(from, index - from, thread, true);
+        listAppend(list, thread, Box(T_OBJECT, piece));
+        from = index + 1;
     }
 
     Object *stringObject = thread->getThisObject();
-    listAppendDestination(list, thread)->copySingleValue(T_OBJECT,
-                                    stringSubstring(from, ((String *) stringObject->value)->length - from, thread));
+    Object *last = stringSubstring(from, ((String *) stringObject->value())->length - from, thread, true);
+    listAppend(list, thread, Box(T_OBJECT, last));
 
     thread->release(1);
     destination->object = list;
 }
 
 void stringToData(Thread *thread, Value *destination) {
-    String *str = static_cast<String *>(thread->getThisObject()->value);
+    String *str = static_cast<String *>(thread->getThisObject()->value());
 
-    size_t ds = u8_codingsize(characters(str), str->length);
+    size_t ds = utf8Size(str);
 
     Object *const &bytesObject = thread->retain(newArray(ds));
 
-    str = static_cast<String *>(thread->getThisObject()->value);
-    u8_toutf8(static_cast<char *>(bytesObject->value), ds, characters(str), str->length);
+    str = static_cast<String *>(thread->getThisObject()->value());
+    stringEncodeUTF8(static_cast<char *>(bytesObject->value()), ds, str);
 
     Object *o = newObject(CL_DATA);
-    Data *d = static_cast<Data *>(o->value);
+    Data *d = static_cast<Data *>(o->value());
     d->length = ds;
     d->bytesObject = bytesObject;
-    d->bytes = static_cast<char *>(d->bytesObject->value);
+    d->bytes = static_cast<char *>(d->bytesObject->value());
 
     thread->release(1);
     destination->object = o;
 }
 
 void stringToCharacterList(Thread *thread, Value *destination) {
-    String *str = static_cast<String *>(thread->getThisObject()->value);
-    Object *list = newObject(CL_LIST);
-
-    for (size_t i = 0; i < str->length; i++) {
-        listAppendDestination(list, thread)->copySingleValue(T_SYMBOL, characters(str)[i]);
+    Object *const &listObject = thread->retain(newObject(CL_LIST));
+    size_t length = static_cast<String *>(thread->getThisObject()->value())->length;
+    Object *items = newArray(sizeCalculationWithOverflowProtection(length, sizeof(Value)));
+
+    String *str = static_cast<String *>(thread->getThisObject()->value());
+    List *list = static_cast<List *>(listObject->value());
+    list->items = items;
+    list->capacity = length;
+    list->count = length;
+    list->packedType = T_SYMBOL;
+    for (size_t i = 0; i < length; i++) {
+        list->values()[i].character = stringCharacterAt(str, i);
     }
-    destination->object = list;
+    writeBarrier(listObject);
+
+    thread->release(1);
+    destination->object = listObject;
 }
 
 void stringJSON(Thread *thread, Value *destination) {
     parseJSON(thread, reinterpret_cast<Box *>(destination));
 }
 
-void initStringFromSymbolList(String *str, List *list) {
-    size_t count = list->count;
-    str->length = count;
-    str->characters = newArray(count * sizeof(EmojicodeChar));
+/// Returns true if the characters in @c list up to the first Nothingness are all below 256.
+static bool symbolListIsLatin1(List *list) {
+    for (size_t i = 0; i < list->count && !list->element(i).isNothingness(); i++) {
+        if (list->element(i).value1.character >= 256) {
+            return false;
+        }
+    }
+    return true;
+}
 
-    for (size_t i = 0; i < count; i++) {
-        Box b = list->elements()[i];
+/// Copies the characters in @c list up to the first Nothingness to @c string, which has room for all of them.
+static void copySymbolList(String *string, List *list) {
+    for (size_t i = 0; i < list->count; i++) {
+        Box b = list->element(i);
         if (b.isNothingness()) break;
-        characters(str)[i] = b.value1.character;
+        if (string->latin1) {
+            latin1Characters(string)[i] = static_cast<uint8_t>(b.value1.character);
+        }
+        else {
+            utf32Characters(string)[i] = b.value1.character;
+        }
     }
 }
 
+Object* newStringFromSymbolList(Object *const &listObject) {
+    auto list = static_cast<List *>(listObject->value());
+    Object *object = newString(list->count, symbolListIsLatin1(list));
+    copySymbolList(static_cast<String *>(object->value()), static_cast<List *>(listObject->value()));
+    return object;
+}
+
 void stringFromSymbolListBridge(Thread *thread, Value *destination) {
-    String *str = static_cast<String *>(thread->getThisObject()->value);
-    List *list = static_cast<List *>(thread->getVariable(0).object->value);
+    List *list = static_cast<List *>(thread->getVariable(0).object->value());
+    size_t count = list->count;
+    bool latin1 = symbolListIsLatin1(list);
 
-    initStringFromSymbolList(str, list);
+    Object *characters = newCharacters(count, latin1);
+    String *str = static_cast<String *>(thread->getThisObject()->value());
+    str->length = count;
+    str->latin1 = latin1;
+    str->characters = characters;
+    writeBarrier(thread->getThisObject());
+    copySymbolList(str, static_cast<List *>(thread->getVariable(0).object->value()));
 }
 
 void stringFromStringList(Thread *thread, Value *destination) {
     size_t stringSize = 0;
     size_t appendLocation = 0;
+    bool latin1;
 
     {
-        List *list = static_cast<List *>(thread->getVariable(0).object->value);
-        String *glue = static_cast<String *>(thread->getVariable(1).object->value);
+        List *list = static_cast<List *>(thread->getVariable(0).object->value());
+        String *glue = static_cast<String *>(thread->getVariable(1).object->value());
 
+        latin1 = glue->latin1;
         for (size_t i = 0; i < list->count; i++) {
-            stringSize += ((String *)list->elements()[i].value1.object->value)->length;
+            String *aString = static_cast<String *>(list->element(i).value1.object->value());
+            stringSize += aString->length;
+            latin1 = latin1 && aString->latin1;
         }
 
         if (list->count > 0) {
@@ -389,29 +660,32 @@ void stringFromStringList(Thread *thread, Value *destination) {
         }
     }
 
-    Object *co = newArray(stringSize * sizeof(EmojicodeChar));
+    Object *co = newCharacters(stringSize, latin1);
 
     {
-        List *list = static_cast<List *>(thread->getVariable(0).object->value);
-        String *glue = static_cast<String *>(thread->getVariable(1).object->value);
+        List *list = static_cast<List *>(thread->getVariable(0).object->value());
+        String *glue = static_cast<String *>(thread->getVariable(1).object->value());
 
-        String *string = static_cast<String *>(thread->getThisObject()->value);
+        String *string = static_cast<String *>(thread->getThisObject()->value());
         string->length = stringSize;
+        string->latin1 = latin1;
         string->characters = co;
+        writeBarrier(thread->getThisObject());
 
         for (size_t i = 0; i < list->count; i++) {
-            String *aString = static_cast<String *>(list->elements()[i].value1.object->value);
-            memcpy(characters(string) + appendLocation, characters(aString), aString->length * sizeof(EmojicodeChar));
+            String *aString = static_cast<String *>(list->element(i).value1.object->value());
+            copyCharacters(string, appendLocation, aString, aString->length);
             appendLocation += aString->length;
             if (i + 1 < list->count) {
-                memcpy(characters(string) + appendLocation, characters(glue), glue->length * sizeof(EmojicodeChar));
+                copyCharacters(string, appendLocation, glue, glue->length);
                 appendLocation += glue->length;
             }
         }
     }
 }
 
-std::pair<EmojicodeInteger, bool> charactersToInteger(EmojicodeChar *characters, EmojicodeInteger base,
+template <typename Character>
+std::pair<EmojicodeInteger, bool> charactersToInteger(const Character *characters, EmojicodeInteger base,
                                                       EmojicodeInteger length) {
     if (length == 0) {
         return std::make_pair(0, false);
@@ -452,23 +726,16 @@ std::pair<EmojicodeInteger, bool> charactersToInteger(EmojicodeChar *characters,
 
 void stringToInteger(Thread *thread, Value *destination) {
     EmojicodeInteger base = thread->getVariable(0).raw;
-    String *string = (String *)thread->getThisObject()->value;
+    String *string = (String *)thread->getThisObject()->value();
 
-    auto pair = charactersToInteger(characters(string), base, string->length);
+    auto pair = string->latin1 ? charactersToInteger(latin1Characters(string), base, string->length) :
+                                 charactersToInteger(utf32Characters(string), base, string->length);
     if (pair.second) destination->optionalSet(pair.first);
     else destination->makeNothingness();
 }
 
-void stringToDouble(Thread *thread, Value *destination) {
-    String *string = (String *)thread->getThisObject()->value;
-
-    if (string->length == 0) {
-        destination->makeNothingness();
-        return;
-    }
-
-    EmojicodeChar *characters = characters(string);
-
+template <typename Character>
+void charactersToDouble(const Character *characters, EmojicodeInteger length, Value *destination) {
     double d = 0.0;
     bool sign = true;
     bool foundSeparator = false;
@@ -482,7 +749,7 @@ void stringToDouble(Thread *thread, Value *destination) {
         i++;
     }
 
-    for (; i < string->length; i++) {
+    for (; i < length; i++) {
         if (characters[i] == '.') {
             if (foundSeparator) {
                 destination->makeNothingness();
@@ -493,7 +760,7 @@ void stringToDouble(Thread *thread, Value *destination) {
             }
         }
         if (characters[i] == 'e' || characters[i] == 'E') {
-            auto exponent = charactersToInteger(characters + i + 1, 10, string->length - i - 1);
+            auto exponent = charactersToInteger(characters + i + 1, 10, length - i - 1);
             if (!exponent.second) {
                 destination->makeNothingness();
                 return;
@@ -528,51 +795,237 @@ void stringToDouble(Thread *thread, Value *destination) {
     destination->optionalSet(d);
 }
 
+void stringToDouble(Thread *thread, Value *destination) {
+    String *string = (String *)thread->getThisObject()->value();
+
+    if (string->length == 0) {
+        destination->makeNothingness();
+        return;
+    }
+
+    if (string->latin1) {
+        charactersToDouble(latin1Characters(string), string->length, destination);
+    }
+    else {
+        charactersToDouble(utf32Characters(string), string->length, destination);
+    }
+}
+
 void stringToUppercase(Thread *thread, Value *destination) {
-    Object *const &o = thread->retain(newObject(CL_STRING));
-    size_t length = static_cast<String *>(thread->getThisObject()->value)->length;
-
-    Object *characters = newArray(length * sizeof(EmojicodeChar));
-    String *news = static_cast<String *>(o->value);
-    news->characters = characters;
-    news->length = length;
-    String *os = static_cast<String *>(thread->getThisObject()->value);
+    size_t length = static_cast<String *>(thread->getThisObject()->value())->length;
+    // Only characters up to z are changed, which leaves the form of the string as it is
+    bool latin1 = static_cast<String *>(thread->getThisObject()->value())->latin1;
+
+    Object *o = newString(length, latin1);
+    String *news = static_cast<String *>(o->value());
+    String *os = static_cast<String *>(thread->getThisObject()->value());
     for (size_t i = 0; i < length; i++) {
-        EmojicodeChar c = characters(os)[i];
-        if (c <= 'z') characters(news)[i] = toupper(c);
-        else characters(news)[i] = c;
+        EmojicodeChar c = stringCharacterAt(os, i);
+        if (c <= 'z') c = toupper(c);
+        if (latin1) latin1Characters(news)[i] = static_cast<uint8_t>(c);
+        else utf32Characters(news)[i] = c;
     }
-    thread->release(1);
     destination->object = o;
 }
 
 void stringToLowercase(Thread *thread, Value *destination) {
-    Object *const &o = thread->retain(newObject(CL_STRING));
-    size_t length = static_cast<String *>(thread->getThisObject()->value)->length;
-
-    Object *characters = newArray(length * sizeof(EmojicodeChar));
-    String *news = static_cast<String *>(o->value);
-    news->characters = characters;
-    news->length = length;
-    String *os = static_cast<String *>(thread->getThisObject()->value);
+    size_t length = static_cast<String *>(thread->getThisObject()->value())->length;
+    // Only characters up to z are changed, which leaves the form of the string as it is
+    bool latin1 = static_cast<String *>(thread->getThisObject()->value())->latin1;
+
+    Object *o = newString(length, latin1);
+    String *news = static_cast<String *>(o->value());
+    String *os = static_cast<String *>(thread->getThisObject()->value());
     for (size_t i = 0; i < length; i++) {
-        EmojicodeChar c = characters(os)[i];
-        if (c <= 'z') characters(news)[i] = tolower(c);
-        else characters(news)[i] = c;
+        EmojicodeChar c = stringCharacterAt(os, i);
+        if (c <= 'z') c = tolower(c);
+        if (latin1) latin1Characters(news)[i] = static_cast<uint8_t>(c);
+        else utf32Characters(news)[i] = c;
     }
-    thread->release(1);
     destination->object = o;
 }
 
 void stringCompareBridge(Thread *thread, Value *destination) {
-    String *a = static_cast<String *>(thread->getThisObject()->value);
-    String *b = static_cast<String *>(thread->getVariable(0).object->value);
+    String *a = static_cast<String *>(thread->getThisObject()->value());
+    String *b = static_cast<String *>(thread->getVariable(0).object->value());
     destination->raw = stringCompare(a, b);
 }
 
 void stringMark(Object *self) {
-    auto string = static_cast<String *>(self->value);
+    auto string = static_cast<String *>(self->value());
     if (string->characters) {
         mark(&string->characters);
     }
 }
+
+void stringBuilderMark(Object *self) {
+    auto builder = static_cast<StringBuilder *>(self->value());
+    if (builder->buffer) {
+        mark(&builder->buffer);
+    }
+}
+
+// MARK: Number Formatting
+
+size_t integerCharacterCount(EmojicodeInteger n, EmojicodeInteger base) {
+    size_t count = n < 0 ? 2 : 1;
+    while (n /= base) count++;
+    return count;
+}
+
+void writeInteger(uint8_t *characters, size_t count, EmojicodeInteger n, EmojicodeInteger base) {
+    EmojicodeInteger a = std::abs(n);
+    characters += count;
+    do
+        *--characters =  "0123456789abcdefghijklmnopqrstuvxyz"[a % base % 35];
+    while (a /= base);
+
+    if (n < 0) characters[-1] = '-';
+}
+
+/// Returns the number of digits before the decimal point of @c absD.
+static size_t integralDigitCount(double absD) {
+    size_t count = 1;
+    for (size_t i = 1; pow(10, i) < absD; i++) {
+        count++;
+    }
+    return count;
+}
+
+size_t doubleCharacterCount(double d, EmojicodeInteger precision) {
+    size_t count = d < 0 ? 1 : 0;
+    if (precision != 0) {
+        count++;
+    }
+    return count + precision + integralDigitCount(std::abs(d));
+}
+
+void writeDouble(uint8_t *characters, size_t count, double d, EmojicodeInteger precision) {
+    double absD = std::abs(d);
+    characters += count;
+
+    for (size_t i = precision; i > 0; i--) {
+        *--characters =  (unsigned char) (fmod(absD * pow(10, i), 10.0)) % 10 + '0';
+    }
+
+    if (precision != 0) {
+        *--characters = '.';
+    }
+
+    for (size_t i = 0, iLength = integralDigitCount(absD); i < iLength; i++) {
+        *--characters =  (unsigned char) (fmod(absD / pow(10, i), 10.0)) % 10 + '0';
+    }
+
+    if (d < 0) characters[-1] = '-';
+}
+
+// MARK: String Builder
+
+void initStringBuilder(Thread *thread, Value *destination) {
+    // The Real-Time Engine guarantees pre-nulled objects.
+}
+
+void initStringBuilderWithCapacity(Thread *thread, Value *destination) {
+    Object *buffer = newString(thread->getVariable(0).raw, true);
+    static_cast<StringBuilder *>(thread->getThisObject()->value())->buffer = buffer;
+    writeBarrier(thread->getThisObject());
+}
+
+/// Makes room for @c count more characters in the string builder in the this-slot, whose buffer is widened to UTF-32
+/// unless @c latin1 is true, and returns its buffer. @warning GC-invoking
+static String* stringBuilderReserve(Thread *thread, size_t count, bool latin1) {
+    auto builder = static_cast<StringBuilder *>(thread->getThisObject()->value());
+    if (builder->buffer == nullptr) {
+        Object *buffer = newString(std::max(count, static_cast<size_t>(16)), latin1);
+        static_cast<StringBuilder *>(thread->getThisObject()->value())->buffer = buffer;
+        writeBarrier(thread->getThisObject());
+        return static_cast<String *>(buffer->value());
+    }
+
+    auto bufferString = static_cast<String *>(builder->buffer->value());
+    size_t required = builder->length + count;
+    // The length of the buffer is its capacity until the string is finished
+    bool widen = bufferString->latin1 && !latin1;
+    if (required > static_cast<size_t>(bufferString->length) || widen) {
+        Object *const &buffer = thread->retain(builder->buffer);
+        Object *newBuffer = growStringBuffer(buffer, builder->length, required, widen);
+        thread->release(1);
+        builder = static_cast<StringBuilder *>(thread->getThisObject()->value());
+        builder->buffer = newBuffer;
+        writeBarrier(thread->getThisObject());
+        bufferString = static_cast<String *>(newBuffer->value());
+    }
+    return bufferString;
+}
+
+/// Appends @c count characters below 128, which @c write writes to the pointer it is called with, to the string
+/// builder in the this-slot. @warning GC-invoking
+template <typename Writer>
+static void stringBuilderAppendASCII(Thread *thread, size_t count, Writer write) {
+    String *buffer = stringBuilderReserve(thread, count, true);
+    auto builder = static_cast<StringBuilder *>(thread->getThisObject()->value());
+    if (buffer->latin1) {
+        write(latin1Characters(buffer) + builder->length);
+    }
+    else {
+        std::vector<uint8_t> characters(count);
+        write(characters.data());
+        widenCharacters(utf32Characters(buffer) + builder->length, characters.data(), count);
+    }
+    builder->length += count;
+}
+
+void stringBuilderAppendString(Thread *thread, Value *destination) {
+    auto string = static_cast<String *>(thread->getVariable(0).object->value());
+    if (string->length == 0) {
+        return;
+    }
+    String *buffer = stringBuilderReserve(thread, string->length, string->latin1);
+    auto builder = static_cast<StringBuilder *>(thread->getThisObject()->value());
+    string = static_cast<String *>(thread->getVariable(0).object->value());
+    copyCharacters(buffer, builder->length, string, string->length);
+    builder->length += string->length;
+}
+
+void stringBuilderAppendSymbol(Thread *thread, Value *destination) {
+    EmojicodeChar character = thread->getVariable(0).character;
+    String *buffer = stringBuilderReserve(thread, 1, character < 256);
+    auto builder = static_cast<StringBuilder *>(thread->getThisObject()->value());
+    if (buffer->latin1) {
+        latin1Characters(buffer)[builder->length] = static_cast<uint8_t>(character);
+    }
+    else {
+        utf32Characters(buffer)[builder->length] = character;
+    }
+    builder->length++;
+}
+
+void stringBuilderAppendInteger(Thread *thread, Value *destination) {
+    EmojicodeInteger n = thread->getVariable(0).raw;
+    EmojicodeInteger base = thread->getVariable(1).raw;
+    size_t count = integerCharacterCount(n, base);
+    stringBuilderAppendASCII(thread, count, [=](uint8_t *characters) { writeInteger(characters, count, n, base); });
+}
+
+void stringBuilderAppendDouble(Thread *thread, Value *destination) {
+    double d = thread->getVariable(0).doubl;
+    EmojicodeInteger precision = thread->getVariable(1).raw;
+    size_t count = doubleCharacterCount(d, precision);
+    stringBuilderAppendASCII(thread, count, [=](uint8_t *characters) { writeDouble(characters, count, d, precision); });
+}
+
+void stringBuilderLength(Thread *thread, Value *destination) {
+    destination->raw = static_cast<StringBuilder *>(thread->getThisObject()->value())->length;
+}
+
+void stringBuilderToString(Thread *thread, Value *destination) {
+    auto builder = static_cast<StringBuilder *>(thread->getThisObject()->value());
+    if (builder->length == 0) {
+        destination->object = emptyString;
+        return;
+    }
+    // The buffer becomes the string, the builder starts over with a new buffer once characters are appended again
+    destination->object = stringConcatenationEnd(builder->buffer, builder->length);
+    builder->buffer = nullptr;
+    builder->length = 0;
+}
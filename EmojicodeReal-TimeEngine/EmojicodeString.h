@@ -14,10 +14,105 @@
 
 extern Object **stringPool;
 #define emptyString (stringPool[0])
-#define characters(string) ((EmojicodeChar*)(string)->characters->value)
+
+#ifndef stringViewMinimumSize
+/// Substrings whose characters take fewer bytes are copied, as sharing the characters would not save memory.
+#define stringViewMinimumSize 32
+#endif
+
+#ifndef stringViewMaximumRetention
+/// A substring shares the characters of its string only if they are at most this many times the size of its own
+/// characters, as it keeps all of them alive.
+#define stringViewMaximumRetention 8
+#endif
+
+/// Returns the memory the characters of @c string are stored in, which is either its shared backing or follows the
+/// string inline.
+inline void* stringCharacters(const String *string) {
+    if (string->characters != nullptr) {
+        return static_cast<Byte *>(string->characters->value()) + string->offset;
+    }
+    return const_cast<String *>(string + 1);
+}
+
+/// Returns the characters of @c string, which must be stored in the Latin-1 form.
+inline uint8_t* latin1Characters(const String *string) {
+    return static_cast<uint8_t *>(stringCharacters(string));
+}
+
+/// Returns the characters of @c string, which must be stored as UTF-32.
+inline EmojicodeChar* utf32Characters(const String *string) {
+    return static_cast<EmojicodeChar *>(stringCharacters(string));
+}
+
+/// Returns the character at @c index of @c string, regardless of the form it is stored in.
+inline EmojicodeChar stringCharacterAt(const String *string, size_t index) {
+    return string->latin1 ? latin1Characters(string)[index] : utf32Characters(string)[index];
+}
+
+/// Allocates an array for @c count characters, one byte each if @c latin1 is true and four bytes otherwise, to be used
+/// as shared backing of a string that was allocated already, like the string an initializer is called on.
+/// @warning GC-invoking
+inline Object* newCharacters(size_t count, bool latin1) {
+    return newArray(latin1 ? count : count * sizeof(EmojicodeChar));
+}
+
+/// Returns true if all of the @c count characters are below 256.
+bool isLatin1(const EmojicodeChar *characters, size_t count);
+/// Copies @c count characters, which must all be below 256, to @c destination with one byte per character.
+void narrowCharacters(uint8_t *destination, const EmojicodeChar *source, size_t count);
+/// Copies @c count Latin-1 characters to @c destination as UTF-32.
+void widenCharacters(EmojicodeChar *destination, const uint8_t *source, size_t count);
+
+/// Decodes @c size bytes of UTF-8 into the characters of @c string, whose @c length, @c latin1 and @c characters
+/// must already be set up for the decoded characters as reported by @c u8_measure.
+void stringDecodeUTF8(String *string, const char *bytes, size_t size);
+
+/// A string builder (🏗), which collects characters in a string buffer whose length is its capacity until the string is
+/// finished.
+struct StringBuilder {
+    /// The number of characters appended
+    size_t length;
+    /// The string the characters are collected in or @c nullptr if no characters were appended since the builder was
+    /// created or finished.
+    Object *buffer;
+};
+
+/// Returns a new string to collect the characters of a string concatenation in. @warning GC-invoking
+Object* stringConcatenationBegin();
+/// Appends the string @c stringObject to a string concatenation. @c buffer points to the retained string returned by
+/// @c stringConcatenationBegin, @c length characters of which are used. It grows as needed and is Latin-1 until the
+/// first string that is not Latin-1 is appended. @warning GC-invoking
+void stringConcatenationAppend(Thread *thread, Object **buffer, size_t &length, Object *stringObject);
+/// Returns the string of a concatenation of @c length characters, whose unused capacity is released.
+Object* stringConcatenationEnd(Object *buffer, size_t length);
+
+/// Returns the number of characters needed to represent @c n in @c base.
+size_t integerCharacterCount(EmojicodeInteger n, EmojicodeInteger base);
+/// Writes the @c count characters, as returned by @c integerCharacterCount, representing @c n in @c base.
+void writeInteger(uint8_t *characters, size_t count, EmojicodeInteger n, EmojicodeInteger base);
+/// Returns the number of characters needed to represent @c d with @c precision decimal places.
+size_t doubleCharacterCount(double d, EmojicodeInteger precision);
+/// Writes the @c count characters, as returned by @c doubleCharacterCount, representing @c d with @c precision decimal
+/// places.
+void writeDouble(uint8_t *characters, size_t count, double d, EmojicodeInteger precision);
 
 /** Compares if the value of @c a is equal to @c b. */
 bool stringEqual(String *a, String *b);
+/// Returns a value less than, equal to, or greater than 0 if @c a is ordered before, equal to, or after @c b, which is
+/// the order ↔️ provides.
+EmojicodeInteger stringCompare(String *a, String *b);
+
+/// Computes the hash of the characters of @c string, which is never 0. Use @c stringHash instead.
+uint64_t stringComputeHash(const String *string);
+
+/// Returns the hash of @c string. As strings are immutable it is only computed once and cached in the string.
+inline uint64_t stringHash(String *string) {
+    if (string->hash == 0) {
+        string->hash = stringComputeHash(string);
+    }
+    return string->hash;
+}
 
 /**
  * Converts the string to a UTF8 char array and returns it.
@@ -34,8 +129,10 @@ Object* stringFromChar(const char *cstring);
 void parseJSON(Thread *thread, Box *destination);
 
 void stringMark(Object *self);
+void stringBuilderMark(Object *self);
 
-void initStringFromSymbolList(String *string, List *list);
+/// Creates a string of the characters in the list @c listObject, which must be retained. @warning GC-invoking
+Object* newStringFromSymbolList(Object *const &listObject);
 
 void stringPrintStdoutBrigde(Thread *thread, Value *destination);
 void stringEqualBridge(Thread *thread, Value *destination);
@@ -62,4 +159,13 @@ void stringToUppercase(Thread *thread, Value *destination);
 void stringToLowercase(Thread *thread, Value *destination);
 void stringCompareBridge(Thread *thread, Value *destination);
 
+void initStringBuilder(Thread *thread, Value *destination);
+void initStringBuilderWithCapacity(Thread *thread, Value *destination);
+void stringBuilderAppendString(Thread *thread, Value *destination);
+void stringBuilderAppendSymbol(Thread *thread, Value *destination);
+void stringBuilderAppendInteger(Thread *thread, Value *destination);
+void stringBuilderAppendDouble(Thread *thread, Value *destination);
+void stringBuilderLength(Thread *thread, Value *destination);
+void stringBuilderToString(Thread *thread, Value *destination);
+
 #endif /* EmojicodeString_h */
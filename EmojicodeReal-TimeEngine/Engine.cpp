@@ -7,10 +7,16 @@
 //
 
 #include "Engine.hpp"
+#include <cctype>
+#include <cerrno>
 #include <cstdarg>
+#include <cstdint>
 #include <cstdlib>
+#include <cstring>
 #include "Thread.hpp"
 #include "Processor.hpp"
+#include "ThreadedProcessor.hpp"
+#include "JIT.hpp"
 #include "Class.hpp"
 #include "Object.hpp"
 #include "Reader.hpp"
@@ -31,6 +37,8 @@ int cliArgumentCount;
 
 const char *packageDirectory = defaultPackagesDirectory;
 
+ExecutionEngine executionEngine = ExecutionEngine::Recursive;
+
 Class **classTable;
 Function **functionTable;
 ProtocolDispatchTable *protocolDispatchTableTable;
@@ -52,7 +60,133 @@ Object **stringPool;
     abort();
 }
 
+static void selectEngine(const char *name) {
+    if (strcmp(name, "recursive") == 0) {
+        executionEngine = ExecutionEngine::Recursive;
+    }
+    else if (strcmp(name, "threaded") == 0) {
+        executionEngine = ExecutionEngine::Threaded;
+    }
+    else {
+        error("Unknown engine %s.", name);
+    }
+}
+
+/// Reads a size in bytes, which can be followed by K, M or G in either case.
+static size_t readSize(const char *string) {
+    char *end;
+    errno = 0;
+    unsigned long long size = strtoull(string, &end, 10);
+    if (!isdigit(static_cast<unsigned char>(string[0])) || errno == ERANGE) {
+        error("Invalid size %s.", string);
+    }
+    unsigned int shift = 0;
+    switch (*end) {
+        case 'G':
+        case 'g':
+            shift += 10;
+            // Falls through
+        case 'M':
+        case 'm':
+            shift += 10;
+            // Falls through
+        case 'K':
+        case 'k':
+            shift += 10;
+            end++;
+    }
+    if (*end != 0 || size > (SIZE_MAX >> shift)) {
+        error("Invalid size %s.", string);
+    }
+    return static_cast<size_t>(size) << shift;
+}
+
+/// Reads a number of garbage collector threads. 0 means one per processor.
+static unsigned int readGCThreads(const char *string) {
+    char *end;
+    errno = 0;
+    unsigned long threads = strtoul(string, &end, 10);
+    if (!isdigit(static_cast<unsigned char>(string[0])) || *end != 0 || errno == ERANGE ||
+        threads > maximumGCThreads) {
+        error("Invalid number of garbage collector threads %s. Use a number from 0 to %d.", string, maximumGCThreads);
+    }
+    return static_cast<unsigned int>(threads);
+}
+
+static void selectCollector(const char *name) {
+    if (strcmp(name, "copying") == 0) {
+        collector = Collector::Copying;
+    }
+    else if (strcmp(name, "generational") == 0) {
+        collector = Collector::Generational;
+    }
+    else if (strcmp(name, "compacting") == 0) {
+        collector = Collector::Compacting;
+    }
+    else {
+        error("Unknown garbage collector %s.", name);
+    }
+}
+
+/// Reads the engine options preceding the file name and removes them from the arguments passed to the program.
+static void readOptions(int &argc, char **&argv) {
+    const char *engine;
+    if ((engine = getenv("EMOJICODE_ENGINE"))) {
+        selectEngine(engine);
+    }
+    const char *gc;
+    if ((gc = getenv("EMOJICODE_GC"))) {
+        selectCollector(gc);
+    }
+    const char *size;
+    if ((size = getenv("EMOJICODE_HEAP_SIZE"))) {
+        maximumHeapSize = readSize(size);
+    }
+    const char *threads;
+    if ((threads = getenv("EMOJICODE_GC_THREADS"))) {
+        gcThreads = readGCThreads(threads);
+    }
+
+    int i = 1;
+    for (; i < argc && strncmp(argv[i], "--", 2) == 0; i++) {
+        if (strncmp(argv[i], "--engine=", 9) == 0) {
+            selectEngine(argv[i] + 9);
+        }
+        else if (strncmp(argv[i], "--gc=", 5) == 0) {
+            selectCollector(argv[i] + 5);
+        }
+        else if (strncmp(argv[i], "--heap-size=", 12) == 0) {
+            maximumHeapSize = readSize(argv[i] + 12);
+        }
+        else if (strncmp(argv[i], "--gc-threads=", 13) == 0) {
+            gcThreads = readGCThreads(argv[i] + 13);
+        }
+        else if (strcmp(argv[i], "--ic-stats") == 0) {
+            inlineCacheStatistics = true;
+        }
+        else if (strncmp(argv[i], "--jit", 5) == 0 && (argv[i][5] == 0 || argv[i][5] == '=')) {
+            jitEnabled = true;
+            if (argv[i][5] == '=') {
+                jitThreshold = static_cast<unsigned int>(strtoul(argv[i] + 6, nullptr, 10));
+            }
+        }
+        else {
+            error("Unknown option %s.", argv[i]);
+        }
+    }
+
+    if (jitEnabled && executionEngine != ExecutionEngine::Threaded) {
+        error("The JIT requires the threaded engine. Use --engine=threaded.");
+    }
+
+    argv[i - 1] = argv[0];
+    argv += i - 1;
+    argc -= i - 1;
+}
+
 int main(int argc, char *argv[]) {
+    readOptions(argc, argv);
+
     cliArgumentCount = argc;
     cliArguments = argv;
     const char *ppath;
@@ -60,6 +194,13 @@ int main(int argc, char *argv[]) {
         packageDirectory = ppath;
     }
 
+    if (executionEngine == ExecutionEngine::Threaded) {
+        prepareThreadedEngine();
+    }
+    if (inlineCacheStatistics) {
+        atexit(printInlineCacheStatistics);
+    }
+
     if (argc < 2) {
         error("No file provided.");
     }
@@ -27,23 +27,81 @@ public:
     int to;
 };
 
+/// Describes which variables of an object or a frame contain object references. The loader computes it from the
+/// object variable records, only references in boxes and in optional value types are kept as @c exceptions.
+struct PointerMap {
+    /// Bit i is set if variable i contains an object reference
+    uint64_t *references;
+    /// Bit i is set if variable i contains an object reference unless variable i - 1, the flag of the optional, is 0
+    uint64_t *optionalReferences;
+    /// The number of words in each of the bitmaps
+    unsigned int words;
+    ObjectVariableRecord *exceptions;
+    unsigned int exceptionsCount;
+};
+
+/// The pointer map of a function’s frame from the instruction @c from up to the @c from of the next stack map.
+struct StackMap {
+    int from;
+    PointerMap map;
+};
+
+struct Function;
+struct InlineCache;
+struct StackFrame;
+
+/// Machine code compiled by the JIT for a function. It is called with the function’s frame already pushed.
+typedef void (*CompiledFunction)(Thread *thread, StackFrame *frame);
+
+/// An instruction or operand decoded for the threaded engine. The code of a block contains exactly one Code value for
+/// each instruction of its bytecode, hence positions can be converted between both.
+union Code {
+    /// The handler of an instruction, or a value smaller than 256 if the instruction was not decoded yet.
+    void *handler;
+    EmojicodeInteger raw;
+    double doubl;
+    Class *klass;
+    Function *function;
+    Object **string;
+    Code *pointer;
+    InlineCache *cache;
+};
+
 struct Block {
     /// A pointer to the first instruction
     EmojicodeInstruction *instructions;
     /// The number of instructions in this block
     unsigned int instructionCount;
+    /// The code run by the threaded engine or @c nullptr if another engine is used
+    Code *code;
 };
 
 struct Function {
     /// Number of arguments taken by this function
     int argumentCount;
+    /// The number of values the arguments take in the function’s frame
+    int argumentsSize;
     /// Whether the method is native
     bool native;
+    /// Whether the function is called on an object, which the garbage collector must mark in the function’s frames
+    bool objectContext;
     /// The frame size needed to execute this function.
     int frameSize;
 
-    FunctionObjectVariableRecord *objectVariableRecords;
-    unsigned int objectVariableRecordsCount;
+    /// The pointer maps of the function’s frame sorted by @c from. The first map applies from instruction 0.
+    StackMap *stackMaps;
+    unsigned int stackMapsCount;
+
+    /// The functions describing the frames of the closures created in this function’s block, including the closures
+    /// nested in these closures, whose functions share this table. @c nullptr if the function has no closures.
+    Function **closures;
+    /// For the function of a closure, the pointer map of the captured variables, which are stored one after the other
+    PointerMap captures;
+
+    /// The number of times this function was called, used by the JIT to find hot functions
+    unsigned int callCount;
+    /// The machine code compiled for this function or @c nullptr
+    CompiledFunction compiled;
 
     union {
         /** FunctionPointer pointer to execute the method. */
@@ -85,6 +143,17 @@ extern int cliArgumentCount;
 
 extern const char *packageDirectory;
 
+/// The execution engines available to run bytecode
+enum class ExecutionEngine {
+    /// Evaluates every instruction with a recursive call to @c produce
+    Recursive,
+    /// Evaluates instructions in a non-recursive loop using threaded dispatch (see ThreadedProcessor.hpp)
+    Threaded,
+};
+
+/// The engine that is used to run bytecode. It is selected at startup and must not be changed afterwards.
+extern ExecutionEngine executionEngine;
+
 struct CapturedFunctionCall {
     Value callee;
     Function *function;
@@ -96,6 +165,8 @@ struct CaptureInformation {
 };
 
 struct Closure {
+    /// The function describing the frame of the closure, which is used by the garbage collector
+    Function *function;
     Block block;
     uint8_t argumentCount;
     uint8_t variableCount;
@@ -112,7 +183,7 @@ struct Closure {
 typedef Marker (*MarkerPointerForClass)(EmojicodeChar cl);
 typedef uint_fast32_t (*SizeForClassFunction)(Class *cl, EmojicodeChar name);
 
-extern FunctionFunctionPointer sLinkingTable[100];
+extern FunctionFunctionPointer sLinkingTable[];
 Marker markerPointerForClass(EmojicodeChar cl);
 uint_fast32_t sizeForClass(Class *cl, EmojicodeChar name);
 
@@ -0,0 +1,1182 @@
+//
+//  JIT.cpp
+//  Emojicode
+//
+
+#include "JIT.hpp"
+
+bool jitEnabled = false;
+unsigned int jitThreshold = 1000;
+
+#if defined(__x86_64__)
+
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <mutex>
+#include <vector>
+#include <sys/mman.h>
+#include "../EmojicodeInstructions.h"
+#include "Processor.hpp"
+#include "ThreadedProcessor.hpp"
+#include "Thread.hpp"
+#include "Class.hpp"
+#include "Object.hpp"
+
+// Functions called by compiled code
+
+/// Executes the instruction at @c position with the recursive engine.
+static void produceInstruction(Thread *thread, EmojicodeInstruction *position, Value *destination) {
+    thread->currentStackFrame()->executionPointer = position + 1;
+    produce(*position, thread, destination);
+}
+
+static StackFrame* reserveFrame(Thread *thread, Function *function, EmojicodeInteger self, Value *destination) {
+    StackFrame *frame = thread->reserveFrame(Value(self), function->frameSize, function, destination,
+                                             function->native ? nullptr : function->block.instructions);
+    frame->argPushIndex = 0;
+    return frame;
+}
+
+static StackFrame* reserveMethodFrame(Thread *thread, InlineCache *cache, Object *self, Value *destination) {
+    return reserveFrame(thread, lookUpMethod(cache, self->klass), reinterpret_cast<EmojicodeInteger>(self),
+                        destination);
+}
+
+static StackFrame* reserveProtocolFrame(Thread *thread, InlineCache *cache, Value *box, Value *destination) {
+    auto type = box[0].raw;
+    if (type == T_OBJECT) {
+        return reserveFrame(thread, lookUpProtocolMethod(cache, box[1].object->klass), box[1].raw, destination);
+    }
+    return reserveFrame(thread, lookUpProtocolMethod(cache, type), reinterpret_cast<EmojicodeInteger>(box + 1),
+                        destination);
+}
+
+/// Pushes the reserved frame, whose arguments were produced, and runs the function.
+static void invokeReservedFrame(Thread *thread) {
+    thread->pushReservedFrame();
+    StackFrame *frame = thread->currentStackFrame();
+    Function *function = frame->function;
+    if (function->native) {
+        function->handler(thread, frame->destination);
+    }
+    else if (CompiledFunction compiled = compiledCode(function)) {
+        compiled(thread, frame);
+    }
+    else {
+        safepoint();
+        runThreaded(thread, function->block);
+    }
+    thread->popStack();
+}
+
+static void rememberObject(Object *object) {
+    writeBarrier(object);
+}
+
+static double remainderDouble(double a, double b) {
+    return fmod(a, b);
+}
+
+// Assembler
+
+enum Register : uint8_t {
+    RAX = 0, RCX = 1, RDX = 2, RBX = 3, RSP = 4, RBP = 5, RSI = 6, RDI = 7, R12 = 12,
+};
+
+/// Condition codes as used by Jcc and SETcc
+enum Condition : uint8_t {
+    Below = 0x2, AboveOrEqual = 0x3, Equal = 0x4, NotEqual = 0x5, Above = 0x7, NotParity = 0xB,
+    Less = 0xC, GreaterOrEqual = 0xD, LessOrEqual = 0xE, Greater = 0xF,
+};
+
+struct Label {
+    /// The position of the label or @c SIZE_MAX if it was not bound yet
+    size_t position = SIZE_MAX;
+    /// The positions of the displacements that must be patched once the label is bound
+    std::vector<size_t> uses;
+};
+
+/// Emits the x86-64 instructions used by the templates. Memory operands always use a 32-bit displacement and must not
+/// use RSP or R12 as base.
+class Assembler {
+public:
+    std::vector<uint8_t> code;
+
+    void byte(uint8_t b) { code.push_back(b); }
+    void int32(uint32_t v) { for (int i = 0; i < 4; i++) byte(static_cast<uint8_t>(v >> (8 * i))); }
+    void int64(uint64_t v) { for (int i = 0; i < 8; i++) byte(static_cast<uint8_t>(v >> (8 * i))); }
+
+    void rex(bool wide, int reg, int rm) {
+        byte(0x40 | (wide ? 8 : 0) | (reg >= 8 ? 4 : 0) | (rm >= 8 ? 1 : 0));
+    }
+    void registerOperand(int reg, int rm) { byte(0xC0 | (reg & 7) << 3 | (rm & 7)); }
+    void memoryOperand(int reg, Register base, int32_t displacement) {
+        byte(0x80 | (reg & 7) << 3 | (base & 7));
+        int32(static_cast<uint32_t>(displacement));
+    }
+
+    void push(Register r) { if (r >= 8) byte(0x41); byte(0x50 + (r & 7)); }
+    void pop(Register r) { if (r >= 8) byte(0x41); byte(0x58 + (r & 7)); }
+    void ret() { byte(0xC3); }
+
+    void moveImmediate(Register r, uint64_t value) { rex(true, 0, r); byte(0xB8 + (r & 7)); int64(value); }
+    void moveImmediate(Register r, const void *value) { moveImmediate(r, reinterpret_cast<uint64_t>(value)); }
+    void move(Register destination, Register source) {
+        rex(true, source, destination); byte(0x89); registerOperand(source, destination);
+    }
+    void load(Register r, Register base, int32_t displacement) {
+        rex(true, r, base); byte(0x8B); memoryOperand(r, base, displacement);
+    }
+    void store(Register base, int32_t displacement, Register r) {
+        rex(true, r, base); byte(0x89); memoryOperand(r, base, displacement);
+    }
+    void store32(Register base, int32_t displacement, uint32_t value) {
+        byte(0xC7); memoryOperand(0, base, displacement); int32(value);
+    }
+    void lea(Register r, Register base, int32_t displacement) {
+        rex(true, r, base); byte(0x8D); memoryOperand(r, base, displacement);
+    }
+
+    /// An ALU instruction of the form OP r/m64, r64, e.g. 0x01 for ADD or 0x39 for CMP.
+    void arithmetic(uint8_t opcode, Register destination, Register source) {
+        rex(true, source, destination); byte(opcode); registerOperand(source, destination);
+    }
+    /// An ALU instruction of the form OP r64, r/m64, e.g. 0x03 for ADD or 0x3B for CMP.
+    void arithmetic(uint8_t opcode, Register r, Register base, int32_t displacement) {
+        rex(true, r, base); byte(opcode); memoryOperand(r, base, displacement);
+    }
+    void multiply(Register destination, Register source) {
+        rex(true, destination, source); byte(0x0F); byte(0xAF); registerOperand(destination, source);
+    }
+    /// An instruction of group 3 (F7), e.g. 2 for NOT and 7 for IDIV.
+    void group3(int extension, Register r) { rex(true, 0, r); byte(0xF7); registerOperand(extension, r); }
+    /// Shifts @c r by CL, 4 for SHL and 7 for SAR.
+    void shift(int extension, Register r) { rex(true, 0, r); byte(0xD3); registerOperand(extension, r); }
+    void signExtendRAX() { byte(0x48); byte(0x99); }
+    /// 0 to increment and 1 to decrement the value in memory.
+    void increment(int extension, Register base, int32_t displacement) {
+        rex(true, 0, base); byte(0xFF); memoryOperand(extension, base, displacement);
+    }
+    void compareWithZero(Register base, int32_t displacement) {
+        rex(true, 0, base); byte(0x83); memoryOperand(7, base, displacement); byte(0);
+    }
+    void compareByteWithZero(Register base, int32_t displacement) {
+        rex(false, 0, base); byte(0x80); memoryOperand(7, base, displacement); byte(0);
+    }
+    void test(Register r) { arithmetic(0x85, r, r); }
+    /// Sets AL or CL to 1 if @c condition holds and to 0 otherwise.
+    void set(Condition condition, Register r) { byte(0x0F); byte(0x90 | condition); registerOperand(0, r); }
+    void andALCL() { byte(0x20); byte(0xC8); }
+    void zeroExtendAL() { byte(0x0F); byte(0xB6); byte(0xC0); }
+    /// Sets RAX to 1 if @c condition holds and to 0 otherwise.
+    void setRAX(Condition condition) { set(condition, RAX); zeroExtendAL(); }
+
+    void moveToXMM(int xmm, Register r) {
+        byte(0x66); rex(true, xmm, r); byte(0x0F); byte(0x6E); registerOperand(xmm, r);
+    }
+    void moveFromXMM(Register r, int xmm) {
+        byte(0x66); rex(true, xmm, r); byte(0x0F); byte(0x7E); registerOperand(xmm, r);
+    }
+    /// A scalar double instruction, e.g. 0x58 for ADDSD.
+    void scalarDouble(uint8_t opcode, int destination, int source) {
+        byte(0xF2); byte(0x0F); byte(opcode); registerOperand(destination, source);
+    }
+    void compareDouble(int a, int b) { byte(0x66); byte(0x0F); byte(0x2E); registerOperand(a, b); }
+    void convertToDouble(int xmm, Register r) {
+        byte(0xF2); rex(true, xmm, r); byte(0x0F); byte(0x2A); registerOperand(xmm, r);
+    }
+
+    template <typename F>
+    void call(F function) { moveImmediate(RAX, reinterpret_cast<uint64_t>(function)); byte(0xFF); byte(0xD0); }
+    void jump(Label &label) { byte(0xE9); use(label); }
+    void jumpIf(Condition condition, Label &label) { byte(0x0F); byte(0x80 | condition); use(label); }
+    void bind(Label &label) {
+        label.position = code.size();
+        for (auto use : label.uses) patch(use, static_cast<uint32_t>(label.position - (use + 4)));
+    }
+    void patch(size_t position, uint32_t value) {
+        for (int i = 0; i < 4; i++) code[position + i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+private:
+    void use(Label &label) {
+        if (label.position != SIZE_MAX) {
+            int32(static_cast<uint32_t>(label.position - (code.size() + 4)));
+        }
+        else {
+            label.uses.push_back(code.size());
+            int32(0);
+        }
+    }
+};
+
+// Compiler
+
+/// The offset of the Value at @c index in a stack frame.
+static int32_t variableOffset(EmojicodeInteger index) {
+    return static_cast<int32_t>(offsetof(StackFrame, thisContext) + sizeof(Value) * (index + 1));
+}
+
+/// The offset of the instance variable at @c index in an object.
+static int32_t instanceVariableOffset(EmojicodeInteger index) {
+    return static_cast<int32_t>(sizeof(Object) + sizeof(Value) * index);
+}
+
+static const int32_t thisContextOffset = offsetof(StackFrame, thisContext);
+static const int32_t destinationOffset = offsetof(StackFrame, destination);
+static const int32_t executionPointerOffset = offsetof(StackFrame, executionPointer);
+static const int32_t argPushIndexOffset = offsetof(StackFrame, argPushIndex);
+
+/// The number of slots at the beginning of the native frame that are used as scratch destination. They are large
+/// enough to hold the value of any statement.
+#define scratchSlots 4
+
+/// Where an expression stores its value
+struct Destination {
+    enum Kind {
+        /// The scratch slots of the native frame
+        Scratch,
+        /// The variable @c index of the frame
+        Variable,
+        /// The destination of the frame
+        Return,
+        /// The variable @c index of the frame reserved for a call, which is stored in the native slot @c frameSlot.
+        Argument,
+    };
+
+    Kind kind;
+    EmojicodeInteger index;
+    int frameSlot;
+
+    static Destination scratch() { return Destination { Scratch, 0, 0 }; }
+    static Destination variable(EmojicodeInteger index) { return Destination { Variable, index, 0 }; }
+    static Destination returnValue() { return Destination { Return, 0, 0 }; }
+    static Destination argument(EmojicodeInteger index, int frameSlot) {
+        return Destination { Argument, index, frameSlot };
+    }
+};
+
+/**
+ * Compiles a function by emitting a template for each instruction.
+ *
+ * While compiled code runs, RBX holds the stack frame and R12 the thread. Expressions leave their value in RAX.
+ * Temporaries are kept in slots of the native frame, which are addressed relative to RBP, so that RSP is aligned at all
+ * calls. No object references are kept in registers or slots across calls into the runtime, so that the garbage
+ * collector finds all of them in the stack frames. The execution pointer of the frame is updated at the beginning of
+ * each statement, hence the frame is marked as it would be by the interpreters.
+ */
+class FunctionCompiler {
+public:
+    explicit FunctionCompiler(Function *function) : block_(function->block) {}
+
+    /// Compiles the function. Returns false if the function contains instructions that cannot be compiled.
+    bool compile();
+    const std::vector<uint8_t>& code() const { return assembler_.code; }
+private:
+    const Block &block_;
+    Assembler assembler_;
+    Label epilogue_;
+    int slots_ = scratchSlots;
+    int maxSlots_ = scratchSlots;
+
+    int allocateSlot() {
+        if (++slots_ > maxSlots_) maxSlots_ = slots_;
+        return slots_ - 1;
+    }
+    void freeSlot() { slots_--; }
+    /// The displacement of @c slot relative to RBP. The callee-saved RBX and R12 are stored directly below RBP.
+    static int32_t slotDisplacement(int slot) { return -16 - 8 * (slot + 1); }
+    static int32_t scratchDisplacement() { return slotDisplacement(scratchSlots - 1); }
+
+    EmojicodeInstruction* compileStatement(EmojicodeInstruction *p);
+    EmojicodeInstruction* compileBlock(EmojicodeInstruction *p);
+    EmojicodeInstruction* compileIf(EmojicodeInstruction *p);
+    EmojicodeInstruction* compileRepeatWhile(EmojicodeInstruction *p);
+    EmojicodeInstruction* compileForInRange(EmojicodeInstruction *p);
+    EmojicodeInstruction* compileFallbackStatement(EmojicodeInstruction *p);
+    /// Compiles the expression at @c p so that its value is stored in @c destination.
+    EmojicodeInstruction* compileExpression(EmojicodeInstruction *p, Destination destination);
+    /// Compiles the expression at @c p, whose value must be one Value large, so that its value is in RAX.
+    EmojicodeInstruction* compileValue(EmojicodeInstruction *p);
+    EmojicodeInstruction* compileBinaryOperation(EmojicodeInstruction *p);
+    EmojicodeInstruction* compileCall(EmojicodeInstruction *p, Destination destination);
+    /// Loads the simple operand at @c p into @c r. Returns @c nullptr if it is not a simple operand.
+    EmojicodeInstruction* loadSimpleOperand(EmojicodeInstruction *p, Register r);
+
+    /// Returns the instruction following the expression at @c p or @c nullptr if its length is not known.
+    EmojicodeInstruction* skipExpression(EmojicodeInstruction *p);
+    EmojicodeInstruction* skipArguments(EmojicodeInstruction *p, Function *callee);
+    /// Returns the function called by the dispatch instruction at @c site the last time it was executed.
+    Function* observedCallee(EmojicodeInstruction *site, EmojicodeInstruction *operand);
+
+    static bool isValueInstruction(EmojicodeInstruction instruction);
+    static bool isCallInstruction(const EmojicodeInstruction *p);
+    static Class* constantClass(const EmojicodeInstruction *p) {
+        return p[0] == INS_GET_CLASS_FROM_INDEX ? classTable[p[1]] : nullptr;
+    }
+
+    void storeValue(Destination destination);
+    void loadAddress(Register r, Destination destination);
+    /// Emits a call to the recursive engine to execute the instruction at @c p.
+    void emitFallback(EmojicodeInstruction *p, Destination destination);
+    /// Sets the frame’s execution pointer to the statement at @c p, past its first instruction as in the recursive
+    /// engine.
+    void updateExecutionPointer(EmojicodeInstruction *p);
+    /// Emits a poll of @c safepointRequested, which pauses for the GC with the execution pointer set to @c p.
+    void emitSafepoint(EmojicodeInstruction *p);
+    /// Emits a call of @c writeBarrier for the object on which the function was called if the generational collector
+    /// is used.
+    void emitWriteBarrier();
+};
+
+bool FunctionCompiler::compile() {
+    assembler_.push(RBP);
+    assembler_.move(RBP, RSP);
+    assembler_.push(RBX);
+    assembler_.push(R12);
+    // SUB RSP, imm32; the size of the native frame is patched in once all slots are known
+    assembler_.byte(0x48);
+    assembler_.byte(0x81);
+    assembler_.byte(0xEC);
+    size_t frameSizePosition = assembler_.code.size();
+    assembler_.int32(0);
+    assembler_.move(R12, RDI);
+    assembler_.move(RBX, RSI);
+    emitSafepoint(block_.instructions);
+
+    EmojicodeInstruction *p = block_.instructions;
+    EmojicodeInstruction *end = block_.instructions + block_.instructionCount;
+    while (p != nullptr && p < end) {
+        p = compileStatement(p);
+    }
+    if (p != end) {
+        return false;
+    }
+
+    assembler_.bind(epilogue_);
+    assembler_.lea(RSP, RBP, -16);
+    assembler_.pop(R12);
+    assembler_.pop(RBX);
+    assembler_.pop(RBP);
+    assembler_.ret();
+    assembler_.patch(frameSizePosition, static_cast<uint32_t>((maxSlots_ * 8 + 15) & ~15));
+    return true;
+}
+
+void FunctionCompiler::updateExecutionPointer(EmojicodeInstruction *p) {
+    assembler_.moveImmediate(RAX, p + 1);
+    assembler_.store(RBX, executionPointerOffset, RAX);
+}
+
+void FunctionCompiler::emitSafepoint(EmojicodeInstruction *p) {
+    static_assert(sizeof(safepointRequested) == 1 && ATOMIC_BOOL_LOCK_FREE == 2,
+                  "Compiled code polls safepointRequested with a plain byte load.");
+    Label skip;
+    assembler_.moveImmediate(RAX, &safepointRequested);
+    assembler_.compareByteWithZero(RAX, 0);
+    assembler_.jumpIf(Equal, skip);
+    updateExecutionPointer(p);
+    assembler_.call(pauseForGC);
+    assembler_.bind(skip);
+}
+
+void FunctionCompiler::emitWriteBarrier() {
+    if (collector == Collector::Generational) {
+        assembler_.load(RDI, RBX, thisContextOffset);
+        assembler_.call(rememberObject);
+    }
+}
+
+void FunctionCompiler::emitFallback(EmojicodeInstruction *p, Destination destination) {
+    loadAddress(RDX, destination);
+    assembler_.moveImmediate(RSI, p);
+    assembler_.move(RDI, R12);
+    assembler_.call(produceInstruction);
+}
+
+void FunctionCompiler::loadAddress(Register r, Destination destination) {
+    switch (destination.kind) {
+        case Destination::Scratch:
+            assembler_.lea(r, RBP, scratchDisplacement());
+            break;
+        case Destination::Variable:
+            assembler_.lea(r, RBX, variableOffset(destination.index));
+            break;
+        case Destination::Return:
+            assembler_.load(r, RBX, destinationOffset);
+            break;
+        case Destination::Argument:
+            assembler_.load(r, RBP, slotDisplacement(destination.frameSlot));
+            assembler_.lea(r, r, variableOffset(destination.index));
+            break;
+    }
+}
+
+void FunctionCompiler::storeValue(Destination destination) {
+    switch (destination.kind) {
+        case Destination::Scratch:
+            assembler_.store(RBP, scratchDisplacement(), RAX);
+            break;
+        case Destination::Variable:
+            assembler_.store(RBX, variableOffset(destination.index), RAX);
+            break;
+        case Destination::Return:
+            assembler_.load(RCX, RBX, destinationOffset);
+            assembler_.store(RCX, 0, RAX);
+            break;
+        case Destination::Argument:
+            assembler_.load(RCX, RBP, slotDisplacement(destination.frameSlot));
+            assembler_.store(RCX, variableOffset(destination.index), RAX);
+            break;
+    }
+}
+
+EmojicodeInstruction* FunctionCompiler::compileBlock(EmojicodeInstruction *p) {
+    EmojicodeInstruction *end = p + 1 + *p;
+    p++;
+    while (p != nullptr && p < end) {
+        p = compileStatement(p);
+    }
+    return p == end ? end : nullptr;
+}
+
+EmojicodeInstruction* FunctionCompiler::compileStatement(EmojicodeInstruction *p) {
+    updateExecutionPointer(p);
+    switch (p[0]) {
+        case INS_PRODUCE_WITH_STACK_DESTINATION:
+            if (p[2] == INS_INCREMENT || p[2] == INS_DECREMENT) {
+                assembler_.increment(p[2] == INS_INCREMENT ? 0 : 1, RBX, variableOffset(p[1]));
+                return p + 3;
+            }
+            return compileExpression(p + 2, Destination::variable(p[1]));
+        case INS_PRODUCE_WITH_OBJECT_DESTINATION:
+        case INS_PRODUCE_WITH_VT_DESTINATION: {
+            bool object = p[0] == INS_PRODUCE_WITH_OBJECT_DESTINATION;
+            int32_t displacement = object ? instanceVariableOffset(p[1]) : static_cast<int32_t>(8 * p[1]);
+            // Instance variable destinations are followed by the size of the variable
+            EmojicodeInstruction *expression = p + (object ? 3 : 2);
+            if (*expression == INS_INCREMENT || *expression == INS_DECREMENT) {
+                assembler_.load(RCX, RBX, thisContextOffset);
+                assembler_.increment(*expression == INS_INCREMENT ? 0 : 1, RCX, displacement);
+                return expression + 1;
+            }
+            if (!isValueInstruction(*expression)) {
+                return compileFallbackStatement(p);
+            }
+            EmojicodeInstruction *next = compileValue(expression);
+            // The object is loaded after the value was produced as the garbage collector might have moved it
+            assembler_.load(RCX, RBX, thisContextOffset);
+            assembler_.store(RCX, displacement, RAX);
+            if (object) {
+                emitWriteBarrier();
+            }
+            return next;
+        }
+        case INS_RETURN: {
+            EmojicodeInstruction *next = compileExpression(p + 1, Destination::returnValue());
+            assembler_.jump(epilogue_);
+            return next;
+        }
+        case INS_IF:
+            return compileIf(p);
+        case INS_REPEAT_WHILE:
+            return compileRepeatWhile(p);
+        case 0x66:
+            return compileForInRange(p);
+        default:
+            if (isValueInstruction(p[0])) {
+                return compileValue(p);
+            }
+            if (isCallInstruction(p)) {
+                return compileCall(p, Destination::scratch());
+            }
+            return compileFallbackStatement(p);
+    }
+}
+
+EmojicodeInstruction* FunctionCompiler::compileFallbackStatement(EmojicodeInstruction *p) {
+    EmojicodeInstruction *next = skipExpression(p);
+    if (next == nullptr) {
+        return nullptr;
+    }
+    emitFallback(p, Destination::scratch());
+    // The statement might have returned from within a block
+    assembler_.compareWithZero(RBX, executionPointerOffset);
+    assembler_.jumpIf(Equal, epilogue_);
+    return next;
+}
+
+EmojicodeInstruction* FunctionCompiler::compileIf(EmojicodeInstruction *p) {
+    EmojicodeInstruction *ifEnd = p + 2 + p[1];
+    Label end;
+    Label nextBranch;
+    if (!(p = compileValue(p + 2))) return nullptr;
+    assembler_.test(RAX);
+    assembler_.jumpIf(Equal, nextBranch);
+    if (!(p = compileBlock(p))) return nullptr;
+    assembler_.jump(end);
+    assembler_.bind(nextBranch);
+
+    while (true) {
+        EmojicodeInstruction branch = *p++;
+        if (branch == 0) {
+            break;
+        }
+        if (branch == 1) {  // Else If
+            Label next;
+            if (!(p = compileValue(p))) return nullptr;
+            assembler_.test(RAX);
+            assembler_.jumpIf(Equal, next);
+            if (!(p = compileBlock(p))) return nullptr;
+            assembler_.jump(end);
+            assembler_.bind(next);
+        }
+        else {  // Else
+            if (!(p = compileBlock(p))) return nullptr;
+            break;
+        }
+    }
+    assembler_.bind(end);
+    return p == ifEnd ? ifEnd : nullptr;
+}
+
+EmojicodeInstruction* FunctionCompiler::compileRepeatWhile(EmojicodeInstruction *p) {
+    Label head;
+    Label end;
+    assembler_.bind(head);
+    emitSafepoint(p);
+    EmojicodeInstruction *next;
+    if (!(next = compileValue(p + 1))) return nullptr;
+    assembler_.test(RAX);
+    assembler_.jumpIf(Equal, end);
+    if (!(next = compileBlock(next))) return nullptr;
+    assembler_.jump(head);
+    assembler_.bind(end);
+    return next;
+}
+
+EmojicodeInstruction* FunctionCompiler::compileForInRange(EmojicodeInstruction *p) {
+    EmojicodeInstruction variable = p[1];
+    EmojicodeInstruction *next;
+    if (!(next = compileExpression(p + 2, Destination::scratch()))) return nullptr;
+
+    // The expression produces a reference to the range, which is copied to the slots i, stop and step
+    int i = allocateSlot();
+    int stop = allocateSlot();
+    int step = allocateSlot();
+    assembler_.load(RCX, RBP, scratchDisplacement());
+    for (int slot = 0; slot < 3; slot++) {
+        assembler_.load(RAX, RCX, 8 * slot);
+        assembler_.store(RBP, slotDisplacement(i + slot), RAX);
+    }
+
+    Label head;
+    Label end;
+    assembler_.bind(head);
+    assembler_.load(RAX, RBP, slotDisplacement(i));
+    assembler_.arithmetic(0x3B, RAX, RBP, slotDisplacement(stop));
+    assembler_.jumpIf(Equal, end);
+    assembler_.store(RBX, variableOffset(variable), RAX);
+    emitSafepoint(p);
+    if (!(next = compileBlock(next))) return nullptr;
+    assembler_.load(RAX, RBP, slotDisplacement(i));
+    assembler_.arithmetic(0x03, RAX, RBP, slotDisplacement(step));
+    assembler_.store(RBP, slotDisplacement(i), RAX);
+    assembler_.jump(head);
+    assembler_.bind(end);
+
+    freeSlot();
+    freeSlot();
+    freeSlot();
+    return next;
+}
+
+EmojicodeInstruction* FunctionCompiler::compileExpression(EmojicodeInstruction *p, Destination destination) {
+    if (isValueInstruction(p[0])) {
+        EmojicodeInstruction *next = compileValue(p);
+        storeValue(destination);
+        return next;
+    }
+    if (isCallInstruction(p)) {
+        return compileCall(p, destination);
+    }
+    EmojicodeInstruction *next = skipExpression(p);
+    if (next != nullptr) {
+        emitFallback(p, destination);
+    }
+    return next;
+}
+
+bool FunctionCompiler::isValueInstruction(EmojicodeInstruction instruction) {
+    switch (instruction) {
+        case INS_GET_32_INTEGER:
+        case INS_GET_64_INTEGER:
+        case INS_GET_DOUBLE:
+        case INS_GET_TRUE:
+        case INS_GET_FALSE:
+        case INS_GET_NOTHINGNESS:
+        case INS_GET_SYMBOL:
+        case INS_GET_CLASS_FROM_INDEX:
+        case INS_GET_STRING_POOL:
+        case INS_GET_THIS:
+        case INS_COPY_SINGLE_STACK:
+        case INS_COPY_SINGLE_OBJECT:
+        case INS_COPY_SINGLE_VT:
+        case INS_GET_VT_REFERENCE_STACK:
+        case INS_GET_VT_REFERENCE_OBJECT:
+        case INS_GET_VT_REFERENCE_VT:
+        case INS_INVERT_BOOLEAN:
+        case INS_BINARY_NOT_INTEGER:
+        case INS_INT_TO_DOUBLE:
+        case INS_IS_NOTHINGNESS:
+        case INS_EQUAL_PRIMITIVE:
+        case INS_SUBTRACT_INTEGER:
+        case INS_ADD_INTEGER:
+        case INS_MULTIPLY_INTEGER:
+        case INS_DIVIDE_INTEGER:
+        case INS_REMAINDER_INTEGER:
+        case INS_OR_BOOLEAN:
+        case INS_AND_BOOLEAN:
+        case INS_LESS_INTEGER:
+        case INS_GREATER_INTEGER:
+        case INS_GREATER_OR_EQUAL_INTEGER:
+        case INS_LESS_OR_EQUAL_INTEGER:
+        case INS_EQUAL_DOUBLE:
+        case INS_SUBTRACT_DOUBLE:
+        case INS_ADD_DOUBLE:
+        case INS_MULTIPLY_DOUBLE:
+        case INS_DIVIDE_DOUBLE:
+        case INS_LESS_DOUBLE:
+        case INS_GREATER_DOUBLE:
+        case INS_LESS_OR_EQUAL_DOUBLE:
+        case INS_GREATER_OR_EQUAL_DOUBLE:
+        case INS_REMAINDER_DOUBLE:
+        case INS_BINARY_AND_INTEGER:
+        case INS_BINARY_OR_INTEGER:
+        case INS_BINARY_XOR_INTEGER:
+        case INS_SHIFT_LEFT_INTEGER:
+        case INS_SHIFT_RIGHT_INTEGER:
+            return true;
+        default:
+            // INS_SAME_OBJECT is not compiled as its left operand, an object, would be kept in a slot
+            return false;
+    }
+}
+
+bool FunctionCompiler::isCallInstruction(const EmojicodeInstruction *p) {
+    switch (p[0]) {
+        case INS_CALL_FUNCTION:
+        case INS_CALL_CONTEXTED_FUNCTION:
+        case INS_DISPATCH_METHOD:
+        case INS_DISPATCH_PROTOCOL:
+            return true;
+        case INS_DISPATCH_TYPE_METHOD:
+            return constantClass(p + 1) != nullptr;
+        default:
+            return false;
+    }
+}
+
+EmojicodeInstruction* FunctionCompiler::loadSimpleOperand(EmojicodeInstruction *p, Register r) {
+    switch (p[0]) {
+        case INS_COPY_SINGLE_STACK:
+            assembler_.load(r, RBX, variableOffset(p[1]));
+            return p + 2;
+        case INS_GET_32_INTEGER:
+            assembler_.moveImmediate(r, static_cast<uint64_t>(static_cast<EmojicodeInteger>(p[1]) - INT32_MAX));
+            return p + 2;
+        case INS_GET_64_INTEGER:
+            assembler_.moveImmediate(r, static_cast<uint64_t>(p[1]) << 32 | p[2]);
+            return p + 3;
+        case INS_GET_DOUBLE: {
+            Value value = decodeDouble(p + 1);
+            assembler_.moveImmediate(r, static_cast<uint64_t>(value.raw));
+            return p + 4;
+        }
+        case INS_GET_TRUE:
+            assembler_.moveImmediate(r, 1);
+            return p + 1;
+        case INS_GET_FALSE:
+        case INS_GET_NOTHINGNESS:
+            assembler_.moveImmediate(r, static_cast<uint64_t>(0));
+            return p + 1;
+        default:
+            return nullptr;
+    }
+}
+
+EmojicodeInstruction* FunctionCompiler::compileValue(EmojicodeInstruction *p) {
+    if (EmojicodeInstruction *next = loadSimpleOperand(p, RAX)) {
+        return next;
+    }
+
+    EmojicodeInstruction *next;
+    switch (p[0]) {
+        case INS_GET_SYMBOL:
+            assembler_.moveImmediate(RAX, p[1]);
+            return p + 2;
+        case INS_GET_CLASS_FROM_INDEX:
+            assembler_.moveImmediate(RAX, classTable[p[1]]);
+            return p + 2;
+        case INS_GET_STRING_POOL:
+            assembler_.moveImmediate(RAX, stringPool + p[1]);
+            assembler_.load(RAX, RAX, 0);
+            return p + 2;
+        case INS_GET_THIS:
+            assembler_.load(RAX, RBX, thisContextOffset);
+            return p + 1;
+        case INS_COPY_SINGLE_OBJECT:
+            assembler_.load(RCX, RBX, thisContextOffset);
+            assembler_.load(RAX, RCX, instanceVariableOffset(p[1]));
+            return p + 2;
+        case INS_COPY_SINGLE_VT:
+            assembler_.load(RCX, RBX, thisContextOffset);
+            assembler_.load(RAX, RCX, static_cast<int32_t>(8 * p[1]));
+            return p + 2;
+        case INS_GET_VT_REFERENCE_STACK:
+            assembler_.lea(RAX, RBX, variableOffset(p[1]));
+            return p + 2;
+        case INS_GET_VT_REFERENCE_OBJECT:
+            emitWriteBarrier();
+            assembler_.load(RAX, RBX, thisContextOffset);
+            assembler_.lea(RAX, RAX, instanceVariableOffset(p[1]));
+            return p + 2;
+        case INS_GET_VT_REFERENCE_VT:
+            assembler_.load(RAX, RBX, thisContextOffset);
+            assembler_.lea(RAX, RAX, static_cast<int32_t>(8 * p[1]));
+            return p + 2;
+        case INS_INVERT_BOOLEAN:
+            if (!(next = compileValue(p + 1))) return nullptr;
+            assembler_.test(RAX);
+            assembler_.setRAX(Equal);
+            return next;
+        case INS_BINARY_NOT_INTEGER:
+            if (!(next = compileValue(p + 1))) return nullptr;
+            assembler_.group3(2, RAX);
+            return next;
+        case INS_INT_TO_DOUBLE:
+            if (!(next = compileValue(p + 1))) return nullptr;
+            assembler_.convertToDouble(0, RAX);
+            assembler_.moveFromXMM(RAX, 0);
+            return next;
+        case INS_IS_NOTHINGNESS:
+            if (!(next = compileValue(p + 1))) return nullptr;
+            assembler_.load(RAX, RAX, 0);
+            assembler_.moveImmediate(RCX, static_cast<uint64_t>(T_NOTHINGNESS));
+            assembler_.arithmetic(0x39, RAX, RCX);
+            assembler_.setRAX(Equal);
+            return next;
+        default:
+            if (isValueInstruction(p[0])) {
+                return compileBinaryOperation(p);
+            }
+            if (!(next = compileExpression(p, Destination::scratch()))) return nullptr;
+            assembler_.load(RAX, RBP, scratchDisplacement());
+            return next;
+    }
+}
+
+EmojicodeInstruction* FunctionCompiler::compileBinaryOperation(EmojicodeInstruction *p) {
+    EmojicodeInstruction *next;
+    if (!(next = compileValue(p + 1))) return nullptr;
+    if (EmojicodeInstruction *afterSimple = loadSimpleOperand(next, RCX)) {
+        next = afterSimple;
+    }
+    else {
+        int slot = allocateSlot();
+        assembler_.store(RBP, slotDisplacement(slot), RAX);
+        if (!(next = compileValue(next))) return nullptr;
+        assembler_.move(RCX, RAX);
+        assembler_.load(RAX, RBP, slotDisplacement(slot));
+        freeSlot();
+    }
+
+    // The left operand is in RAX and the right operand in RCX
+    switch (p[0]) {
+        case INS_ADD_INTEGER:
+            assembler_.arithmetic(0x01, RAX, RCX);
+            break;
+        case INS_SUBTRACT_INTEGER:
+            assembler_.arithmetic(0x29, RAX, RCX);
+            break;
+        case INS_BINARY_AND_INTEGER:
+            assembler_.arithmetic(0x21, RAX, RCX);
+            break;
+        case INS_BINARY_OR_INTEGER:
+            assembler_.arithmetic(0x09, RAX, RCX);
+            break;
+        case INS_BINARY_XOR_INTEGER:
+            assembler_.arithmetic(0x31, RAX, RCX);
+            break;
+        case INS_MULTIPLY_INTEGER:
+            assembler_.multiply(RAX, RCX);
+            break;
+        case INS_DIVIDE_INTEGER:
+            assembler_.signExtendRAX();
+            assembler_.group3(7, RCX);
+            break;
+        case INS_REMAINDER_INTEGER:
+            assembler_.signExtendRAX();
+            assembler_.group3(7, RCX);
+            assembler_.move(RAX, RDX);
+            break;
+        case INS_SHIFT_LEFT_INTEGER:
+            assembler_.shift(4, RAX);
+            break;
+        case INS_SHIFT_RIGHT_INTEGER:
+            assembler_.shift(7, RAX);
+            break;
+        case INS_EQUAL_PRIMITIVE:
+            assembler_.arithmetic(0x39, RAX, RCX);
+            assembler_.setRAX(Equal);
+            break;
+        case INS_LESS_INTEGER:
+            assembler_.arithmetic(0x39, RAX, RCX);
+            assembler_.setRAX(Less);
+            break;
+        case INS_GREATER_INTEGER:
+            assembler_.arithmetic(0x39, RAX, RCX);
+            assembler_.setRAX(Greater);
+            break;
+        case INS_LESS_OR_EQUAL_INTEGER:
+            assembler_.arithmetic(0x39, RAX, RCX);
+            assembler_.setRAX(LessOrEqual);
+            break;
+        case INS_GREATER_OR_EQUAL_INTEGER:
+            assembler_.arithmetic(0x39, RAX, RCX);
+            assembler_.setRAX(GreaterOrEqual);
+            break;
+        case INS_OR_BOOLEAN:
+            assembler_.arithmetic(0x09, RAX, RCX);
+            assembler_.test(RAX);
+            assembler_.setRAX(NotEqual);
+            break;
+        case INS_AND_BOOLEAN:
+            assembler_.test(RAX);
+            assembler_.set(NotEqual, RAX);
+            assembler_.test(RCX);
+            assembler_.set(NotEqual, RCX);
+            assembler_.andALCL();
+            assembler_.zeroExtendAL();
+            break;
+        default: {
+            // Double operations
+            assembler_.moveToXMM(0, RAX);
+            assembler_.moveToXMM(1, RCX);
+            switch (p[0]) {
+                case INS_ADD_DOUBLE:
+                    assembler_.scalarDouble(0x58, 0, 1);
+                    break;
+                case INS_SUBTRACT_DOUBLE:
+                    assembler_.scalarDouble(0x5C, 0, 1);
+                    break;
+                case INS_MULTIPLY_DOUBLE:
+                    assembler_.scalarDouble(0x59, 0, 1);
+                    break;
+                case INS_DIVIDE_DOUBLE:
+                    assembler_.scalarDouble(0x5E, 0, 1);
+                    break;
+                case INS_REMAINDER_DOUBLE:
+                    assembler_.call(remainderDouble);
+                    break;
+                // UCOMISD sets CF and ZF if the operands are unordered, so that only Equal needs to test parity
+                case INS_EQUAL_DOUBLE:
+                    assembler_.compareDouble(0, 1);
+                    assembler_.set(Equal, RAX);
+                    assembler_.set(NotParity, RCX);
+                    assembler_.andALCL();
+                    assembler_.zeroExtendAL();
+                    return next;
+                case INS_LESS_DOUBLE:
+                    assembler_.compareDouble(1, 0);
+                    assembler_.setRAX(Above);
+                    return next;
+                case INS_GREATER_DOUBLE:
+                    assembler_.compareDouble(0, 1);
+                    assembler_.setRAX(Above);
+                    return next;
+                case INS_LESS_OR_EQUAL_DOUBLE:
+                    assembler_.compareDouble(1, 0);
+                    assembler_.setRAX(AboveOrEqual);
+                    return next;
+                case INS_GREATER_OR_EQUAL_DOUBLE:
+                    assembler_.compareDouble(0, 1);
+                    assembler_.setRAX(AboveOrEqual);
+                    return next;
+                default:
+                    return nullptr;
+            }
+            assembler_.moveFromXMM(RAX, 0);
+            break;
+        }
+    }
+    return next;
+}
+
+EmojicodeInstruction* FunctionCompiler::compileCall(EmojicodeInstruction *p, Destination destination) {
+    Function *callee;
+    EmojicodeInstruction *next;
+    // The function reserving the frame is called with the thread, the callee or inline cache, self and destination
+    const void *calleeOperand;
+    StackFrame* (*reserve)(Thread *, Function *, EmojicodeInteger, Value *) = reserveFrame;
+    StackFrame* (*reserveDispatched)(Thread *, InlineCache *, Object *, Value *) = nullptr;
+    StackFrame* (*reserveProtocol)(Thread *, InlineCache *, Value *, Value *) = nullptr;
+    switch (p[0]) {
+        case INS_CALL_FUNCTION:
+            callee = functionTable[p[1]];
+            next = p + 2;
+            assembler_.moveImmediate(RDX, static_cast<uint64_t>(0));
+            calleeOperand = callee;
+            break;
+        case INS_CALL_CONTEXTED_FUNCTION:
+            if (!(next = compileValue(p + 1))) return nullptr;
+            callee = functionTable[*next++];
+            assembler_.move(RDX, RAX);
+            calleeOperand = callee;
+            break;
+        case INS_DISPATCH_TYPE_METHOD: {
+            Class *klass = constantClass(p + 1);
+            callee = klass->methodsVtable[p[3]];
+            next = p + 4;
+            assembler_.moveImmediate(RDX, klass);
+            calleeOperand = callee;
+            break;
+        }
+        case INS_DISPATCH_METHOD:
+        case INS_DISPATCH_PROTOCOL: {
+            EmojicodeInstruction *operand;
+            if (!(operand = compileValue(p + 1))) return nullptr;
+            if (!(callee = observedCallee(p, operand))) return nullptr;
+            next = operand + (p[0] == INS_DISPATCH_METHOD ? 1 : 2);
+            assembler_.move(RDX, RAX);
+            calleeOperand = block_.code[operand - block_.instructions].cache;
+            if (p[0] == INS_DISPATCH_METHOD) {
+                reserveDispatched = reserveMethodFrame;
+            }
+            else {
+                reserveProtocol = reserveProtocolFrame;
+            }
+            break;
+        }
+        default:
+            return nullptr;
+    }
+    loadAddress(RCX, destination);
+    assembler_.moveImmediate(RSI, calleeOperand);
+    assembler_.move(RDI, R12);
+    if (reserveDispatched) {
+        assembler_.call(reserveDispatched);
+    }
+    else if (reserveProtocol) {
+        assembler_.call(reserveProtocol);
+    }
+    else {
+        assembler_.call(reserve);
+    }
+
+    int frameSlot = allocateSlot();
+    assembler_.store(RBP, slotDisplacement(frameSlot), RAX);
+    EmojicodeInteger argPushIndex = 0;
+    for (int i = 0; i < callee->argumentCount; i++) {
+        EmojicodeInstruction size = *next;
+        if (!(next = compileExpression(next + 1, Destination::argument(argPushIndex, frameSlot)))) return nullptr;
+        argPushIndex += size;
+        assembler_.load(RCX, RBP, slotDisplacement(frameSlot));
+        assembler_.store32(RCX, argPushIndexOffset, static_cast<uint32_t>(argPushIndex));
+    }
+    assembler_.move(RDI, R12);
+    assembler_.call(invokeReservedFrame);
+    freeSlot();
+    return next;
+}
+
+Function* FunctionCompiler::observedCallee(EmojicodeInstruction *site, EmojicodeInstruction *operand) {
+    InlineCache *cache = inlineCacheAt(block_, site, operand);
+    if (cache == nullptr || cache->count.load(std::memory_order_acquire) == 0) {
+        return nullptr;
+    }
+    return cache->entries[0].function;
+}
+
+EmojicodeInstruction* FunctionCompiler::skipArguments(EmojicodeInstruction *p, Function *callee) {
+    for (int i = 0; p != nullptr && i < callee->argumentCount; i++) {
+        p = skipExpression(p + 1);
+    }
+    return p;
+}
+
+EmojicodeInstruction* FunctionCompiler::skipExpression(EmojicodeInstruction *p) {
+    EmojicodeInstruction *q;
+    Class *klass;
+    switch (*p++) {
+        case INS_DISPATCH_METHOD:
+        case INS_DISPATCH_PROTOCOL: {
+            if (!(q = skipExpression(p))) return nullptr;
+            Function *callee = observedCallee(p - 1, q);
+            if (callee == nullptr) return nullptr;
+            return skipArguments(q + (p[-1] == INS_DISPATCH_METHOD ? 1 : 2), callee);
+        }
+        case INS_DISPATCH_TYPE_METHOD:
+        case INS_DISPATCH_SUPER:
+            if (!(klass = constantClass(p))) return nullptr;
+            return skipArguments(p + 3, klass->methodsVtable[p[2]]);
+        case INS_NEW_OBJECT:
+        case INS_SUPER_INITIALIZER:
+            if (!(klass = constantClass(p))) return nullptr;
+            return skipArguments(p + 3, klass->initializersVtable[p[2]]);
+        case INS_CALL_CONTEXTED_FUNCTION:
+            if (!(q = skipExpression(p))) return nullptr;
+            return skipArguments(q + 1, functionTable[*q]);
+        case INS_CALL_FUNCTION:
+        case INS_INIT_VT:
+            return skipArguments(p + 1, functionTable[*p]);
+        case INS_GET_TRUE:
+        case INS_GET_FALSE:
+        case INS_GET_NOTHINGNESS:
+        case INS_GET_THIS:
+        case INS_INCREMENT:
+        case INS_DECREMENT:
+            return p;
+        case INS_GET_VT_REFERENCE_STACK:
+        case INS_GET_VT_REFERENCE_OBJECT:
+        case INS_GET_VT_REFERENCE_VT:
+        case INS_GET_CLASS_FROM_INDEX:
+        case INS_GET_STRING_POOL:
+        case INS_GET_32_INTEGER:
+        case INS_GET_SYMBOL:
+        case INS_COPY_SINGLE_STACK:
+        case INS_COPY_SINGLE_OBJECT:
+        case INS_COPY_SINGLE_VT:
+            return p + 1;
+        case INS_PRODUCE_WITH_OBJECT_DESTINATION:
+            return skipExpression(p + 2);
+        case INS_GET_64_INTEGER:
+        case INS_COPY_WITH_SIZE_STACK:
+        case INS_COPY_WITH_SIZE_OBJECT:
+        case INS_COPY_WITH_SIZE_VT:
+            return p + 2;
+        case INS_GET_DOUBLE:
+            return p + 3;
+        case INS_PRODUCE_TO_AND_GET_VT_REFERENCE:
+        case INS_PRODUCE_WITH_STACK_DESTINATION:
+        case INS_PRODUCE_WITH_VT_DESTINATION:
+        case INS_BOX_TO_SIMPLE_OPTIONAL_PRODUCE:
+        case INS_SIMPLE_OPTIONAL_TO_BOX:
+        case INS_BOX_PRODUCE:
+        case INS_UNBOX:
+        case INS_COPY_REFERENCE:
+        case INS_PACK_LIST:
+            return skipExpression(p + 1);
+        case INS_SIMPLE_OPTIONAL_PRODUCE:
+        case INS_GET_CLASS_FROM_INSTANCE:
+        case INS_INVERT_BOOLEAN:
+        case INS_IS_NOTHINGNESS:
+        case INS_INT_TO_DOUBLE:
+        case INS_UNWRAP_BOX_OPTIONAL:
+        case INS_BINARY_NOT_INTEGER:
+        case INS_RETURN:
+            return skipExpression(p);
+        case INS_UNWRAP_SIMPLE_OPTIONAL:
+        case INS_CONDITIONAL_PRODUCE_BOX:
+        case INS_CAST_TO_PROTOCOL:
+        case INS_CAST_TO_VALUE_TYPE:
+        case INS_CAPTURE_METHOD:
+        case INS_CAPTURE_TYPE_METHOD:
+        case INS_CAPTURE_CONTEXTED_FUNCTION:
+            return (q = skipExpression(p)) ? q + 1 : nullptr;
+        case INS_CONDITIONAL_PRODUCE_SIMPLE_OPTIONAL:
+            return (q = skipExpression(p)) ? q + 2 : nullptr;
+        case INS_EQUAL_PRIMITIVE:
+        case INS_SUBTRACT_INTEGER:
+        case INS_ADD_INTEGER:
+        case INS_MULTIPLY_INTEGER:
+        case INS_DIVIDE_INTEGER:
+        case INS_REMAINDER_INTEGER:
+        case INS_OR_BOOLEAN:
+        case INS_AND_BOOLEAN:
+        case INS_LESS_INTEGER:
+        case INS_GREATER_INTEGER:
+        case INS_GREATER_OR_EQUAL_INTEGER:
+        case INS_LESS_OR_EQUAL_INTEGER:
+        case INS_SAME_OBJECT:
+        case INS_EQUAL_DOUBLE:
+        case INS_SUBTRACT_DOUBLE:
+        case INS_ADD_DOUBLE:
+        case INS_MULTIPLY_DOUBLE:
+        case INS_DIVIDE_DOUBLE:
+        case INS_LESS_DOUBLE:
+        case INS_GREATER_DOUBLE:
+        case INS_LESS_OR_EQUAL_DOUBLE:
+        case INS_GREATER_OR_EQUAL_DOUBLE:
+        case INS_REMAINDER_DOUBLE:
+        case INS_BINARY_AND_INTEGER:
+        case INS_BINARY_OR_INTEGER:
+        case INS_BINARY_XOR_INTEGER:
+        case INS_SHIFT_LEFT_INTEGER:
+        case INS_SHIFT_RIGHT_INTEGER:
+        case INS_DOWNCAST_TO_CLASS:
+        case INS_CAST_TO_CLASS:
+            return (q = skipExpression(p)) ? skipExpression(q) : nullptr;
+        case 0x50:
+        case 0x51:
+        case INS_IF:
+            return p + 1 + *p;
+        case 0x52: {
+            EmojicodeInstruction count = *p++;
+            for (EmojicodeInstruction i = 0; p != nullptr && i < count; i++) {
+                p = skipExpression(p);
+            }
+            return p;
+        }
+        case INS_REPEAT_WHILE:
+            return (q = skipExpression(p)) ? q + 1 + *q : nullptr;
+        case 0x65:
+            return (q = skipExpression(p + 1)) ? q + 2 + q[1] : nullptr;
+        case 0x66:
+            return (q = skipExpression(p + 1)) ? q + 1 + *q : nullptr;
+        case INS_CLOSURE: {
+            q = p + 3 + p[2];  // Skip the index, the variable count, the closure’s instructions and their count
+            return q + 3 + 3 * q[1];
+        }
+        default:
+            // The argument count of INS_EXECUTE_CALLABLE is not known
+            return nullptr;
+    }
+}
+
+CompiledFunction compileFunction(Function *function) {
+    static std::mutex mutex;
+    std::lock_guard<std::mutex> lock(mutex);
+
+    CompiledFunction compiled = __atomic_load_n(&function->compiled, __ATOMIC_ACQUIRE);
+    if (compiled != nullptr) {
+        return compiled;
+    }
+
+    FunctionCompiler compiler(function);
+    if (!compiler.compile()) {
+        return nullptr;
+    }
+    const std::vector<uint8_t> &code = compiler.code();
+    void *memory = mmap(nullptr, code.size(), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) {
+        return nullptr;
+    }
+    std::memcpy(memory, code.data(), code.size());
+    if (mprotect(memory, code.size(), PROT_READ | PROT_EXEC) != 0) {
+        munmap(memory, code.size());
+        return nullptr;
+    }
+
+    compiled = reinterpret_cast<CompiledFunction>(memory);
+    __atomic_store_n(&function->compiled, compiled, __ATOMIC_RELEASE);
+    return compiled;
+}
+
+#else
+
+CompiledFunction compileFunction(Function *function) {
+    return nullptr;  // The JIT only supports x86-64
+}
+
+#endif
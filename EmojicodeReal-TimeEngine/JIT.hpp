@@ -0,0 +1,45 @@
+//
+//  JIT.hpp
+//  Emojicode
+//
+
+#ifndef JIT_hpp
+#define JIT_hpp
+
+#include "Engine.hpp"
+
+/// Whether hot functions are compiled to machine code. Set at startup by the @c --jit option.
+extern bool jitEnabled;
+/// The number of calls after which a function is compiled. Set at startup by the @c --jit=threshold option.
+extern unsigned int jitThreshold;
+
+/**
+ * Compiles @c function, which must not be native, to x86-64 machine code.
+ *
+ * Arithmetic, comparisons, variable accesses, control flow and calls are compiled to machine code, all other
+ * instructions are executed by calling into the recursive engine. A function can only be compiled if the length of all
+ * its instructions is known, which is not the case for dispatch instructions that were never executed by the threaded
+ * engine, as their argument count depends on the callee.
+ * @returns The machine code or @c nullptr if the function could not be compiled.
+ */
+CompiledFunction compileFunction(Function *function);
+
+/// Counts a call of @c function and compiles the function once it got hot.
+/// @returns The machine code to run for @c function or @c nullptr if the function must be interpreted.
+inline CompiledFunction compiledCode(Function *function) {
+    if (!jitEnabled) {
+        return nullptr;
+    }
+    CompiledFunction compiled = __atomic_load_n(&function->compiled, __ATOMIC_ACQUIRE);
+    if (compiled != nullptr) {
+        return compiled;
+    }
+    // Compilation is retried at every power of two as calls that could not be compiled might have been executed since.
+    unsigned int calls = __atomic_fetch_add(&function->callCount, 1, __ATOMIC_RELAXED);
+    if (calls == jitThreshold || (calls > jitThreshold && (calls & (calls - 1)) == 0)) {
+        return compileFunction(function);
+    }
+    return nullptr;
+}
+
+#endif /* JIT_hpp */
@@ -38,7 +38,7 @@ struct JSONStackFrame {
 #define errorExit() destination->makeNothingness(); return;
 #define upgrade(now, expect, ec) case now: if (c == ec) { stackCurrent->state = now ## expect; continue; } else { errorExit(); }
 #define upgradeReturn(now, ec, r) case now: if (c == ec) { backValue = r; popTheStack(); } else { errorExit(); }
-#define appendEscape(seq, c) case seq: *listAppendDestination(*stackCurrent->object, thread) = Box(T_SYMBOL, EmojicodeChar(c)); continue;
+#define appendEscape(seq, c) case seq: listAppend(*stackCurrent->object, thread, Box(T_SYMBOL, EmojicodeChar(c))); continue;
 #define whitespaceCase case '\t': case '\n': case '\r': case ' ':
 #define popTheStack() if (stackCurrent->secondaryObject) thread->release(1); if (stackCurrent->object) thread->release(1); stackCurrent--; continue;
 #define pushTheStack() stackCurrent++; if (stackCurrent > stackLimit) { errorExit(); } stackCurrent->state = JSON_NONE; stackCurrent->secondaryObject = nullptr; stackCurrent->object = nullptr; continue;
@@ -52,7 +52,7 @@ struct JSONStackFrame {
 #define jsonMaxDepth 256
 
 void parseJSON(Thread *thread, Box *destination) {
-    const size_t length = ((String*)thread->getThisObject()->value)->length;
+    const size_t length = ((String*)thread->getThisObject()->value())->length;
     JSONStackFrame stack[jsonMaxDepth];
     JSONStackFrame *stackLimit = stack + jsonMaxDepth - 1;
     JSONStackFrame *stackCurrent = stack;
@@ -69,7 +69,7 @@ void parseJSON(Thread *thread, Box *destination) {
             errorExit();
         }
 
-        c = characters((String *)thread->getThisObject()->value)[i++];
+        c = stringCharacterAt((String *)thread->getThisObject()->value(), i++);
 
         switch (stackCurrent->state) {
             case JSON_STRING:
@@ -78,18 +78,14 @@ void parseJSON(Thread *thread, Box *destination) {
                         stackCurrent->state = JSON_STRING_ESCAPE;
                         continue;
                     case '"': {
-                        auto &stringObject = thread->retain(newObject(CL_STRING));
-                        initStringFromSymbolList(static_cast<String *>(stringObject->value),
-                                                 static_cast<List *>((*stackCurrent->object)->value));
-                        thread->release(1);
-                        backValue = Box(T_OBJECT, stringObject);
+                        backValue = Box(T_OBJECT, newStringFromSymbolList(*stackCurrent->object));
                         popTheStack();
                     }
                     default:
                         if (c <= 0x1F) {
                             errorExit();
                         }
-                        *listAppendDestination(*stackCurrent->object, thread) = Box(T_SYMBOL, c);
+                        listAppend(*stackCurrent->object, thread, Box(T_SYMBOL, c));
                         continue;
                 }
             case JSON_STRING_ESCAPE:
@@ -104,7 +100,7 @@ void parseJSON(Thread *thread, Box *destination) {
                         appendEscape('r', '\r')
                         appendEscape('t', '\t')
                     case 'u': {
-                        EmojicodeChar *chars = characters((String *)thread->getThisObject()->value);
+                        String *string = (String *)thread->getThisObject()->value();
                         EmojicodeInteger x = 0, high = 0;
                         while (true) {
                             for (size_t e = i + 4; i < e; i++) {
@@ -112,7 +108,7 @@ void parseJSON(Thread *thread, Box *destination) {
                                     errorExit();
                                 }
 
-                                c = chars[i];
+                                c = stringCharacterAt(string, i);
                                 x *= 16;
 
                                 if ('0' <= c && c <= '9')
@@ -128,7 +124,8 @@ void parseJSON(Thread *thread, Box *destination) {
                             if (high)
                                 x = (high << 10) + x + 0x10000 - (0xD800 << 10) - 0xDC00;
                             else if (0xD800 <= x && x <= 0xDBFF) {
-                                if (i + 2 >= length || chars[i++] != '\\' || chars[i++] != 'u') {
+                                if (i + 2 >= length || stringCharacterAt(string, i++) != '\\' ||
+                                    stringCharacterAt(string, i++) != 'u') {
                                     errorExit();
                                 }
                                 high = x;
@@ -137,7 +134,7 @@ void parseJSON(Thread *thread, Box *destination) {
                             }
                             break;
                         }
-                        *listAppendDestination(*stackCurrent->object, thread) = Box(T_SYMBOL, x);
+                        listAppend(*stackCurrent->object, thread, Box(T_SYMBOL, x));
                         continue;
                     }
                 }
@@ -199,7 +196,7 @@ void parseJSON(Thread *thread, Box *destination) {
                 stackCurrent->state = JSON_ARRAY_BACK_VALUE;
                 pushTheStack();
             case JSON_ARRAY_BACK_VALUE:
-                *listAppendDestination(*stackCurrent->object, thread) = backValue;
+                listAppend(*stackCurrent->object, thread, backValue);
 
                 switch (c) {
                     case ',':
@@ -265,10 +262,8 @@ void parseJSON(Thread *thread, Box *destination) {
                     }
                     case '{': {
                         stackCurrent->state = JSON_OBJECT_KEY;
-                        thread->pushStack(newObject(CL_DICTIONARY), 1, 0, nullptr, nullptr, nullptr);
-                        dictionaryInit(thread);
-                        Object *o = thread->getThisObject();
-                        thread->popStack();
+                        Object *o = newObject(CL_DICTIONARY);
+                        dictionaryInit(static_cast<EmojicodeDictionary *>(o->value()));
                         stackCurrent->object = &thread->retain(o);
                         break;
                     }
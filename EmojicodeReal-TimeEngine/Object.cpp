@@ -7,75 +7,375 @@
 //
 
 #include "Object.hpp"
+#include <sys/mman.h>
+#include <unistd.h>
 #include <cstring>
 #include <cstdlib>
 #include <thread>
 #include <mutex>
 #include <condition_variable>
+#include <atomic>
 #include <algorithm>
+#include <deque>
+#include <map>
+#include <vector>
 #include "Engine.hpp"
 #include "Thread.hpp"
 #include "Class.hpp"
 
-size_t memoryUse = 0;
-bool zeroingNeeded = false;
-Byte *currentHeap;
-Byte *otherHeap;
+/// A contiguous part of the heap, in which objects are allocated by incrementing @c used.
+struct Space {
+    Byte *start = nullptr;
+    /// The number of bytes that can be allocated before a collection is needed.
+    size_t size = 0;
+    size_t used = 0;
+    /// The size of the address space reserved for the space, up to which @c size can grow.
+    size_t capacity = 0;
+    /// All memory behind this number of bytes that was not allocated since the last collection is zero, as it was never
+    /// used or returned to the operating system. Memory before it is zeroed when it is allocated.
+    size_t touched = 0;
 
-void gc(std::unique_lock<std::mutex> &allocationLock);
+    Byte* top() const { return start + used; }
+    size_t available() const { return size - used; }
+    bool contains(const void *p) const {
+        return reinterpret_cast<uintptr_t>(p) - reinterpret_cast<uintptr_t>(start) < capacity;
+    }
+    void updateTouched() { touched = std::max(touched, used); }
+};
+
+Collector collector = Collector::Copying;
+
+/// The semispace that contains all objects that survived a collection. Unless the generational collector is used,
+/// new objects are allocated in this space as well.
+Space currentSpace;
+/// The semispace into which the next full collection copies the live objects.
+Space otherSpace;
+/// The space in which the generational collector allocates new objects. Survivors are promoted to currentSpace.
+Space nursery;
+/// The nursery used before the last collection. Like otherSpace it is left intact until the next collection, as native
+/// code might still read objects that were moved from there, e.g. when resizing an array.
+Space previousNursery;
+/// The space in which new objects are allocated, either nursery or currentSpace.
+Space *allocationSpace = &currentSpace;
+
+size_t maximumHeapSize = heapSize;
+static size_t pageSize;
+
+/// The arrays of at least largeObjectSize bytes, which are never moved. Each array occupies a run of pages of the
+/// reserved address range. A full collection marks the arrays in a byte map and those that were not marked are freed.
+struct LargeObjectSpace {
+    Byte *start = nullptr;
+    size_t capacity = 0;
+    /// The number of bytes occupied by the arrays that were not found unreachable yet
+    size_t used = 0;
+    /// A full collection is started before an allocation increases @c used beyond this number of bytes.
+    size_t limit = 0;
+    /// All pages behind this offset have never been allocated.
+    size_t top = 0;
+    /// The runs of free pages before @c top, their size by their offset
+    std::map<size_t, size_t> freeRuns;
+    /// The number of bytes occupied by each array
+    std::map<Object *, size_t> objects;
+    /// One byte per page, which is set for the first page of each array that was marked by a full collection
+    Byte *marks = nullptr;
+    /// The arrays found unreachable by the last full collection. They are freed by the next collection as they might
+    /// still be read until then like objects that were moved.
+    std::vector<std::pair<Object *, size_t>> condemned;
 
-size_t gcThreshold = heapSize / 2;
+    bool contains(const void *p) const {
+        return reinterpret_cast<uintptr_t>(p) - reinterpret_cast<uintptr_t>(start) < capacity;
+    }
+    Byte& mark(const Object *object) { return marks[(reinterpret_cast<const Byte *>(object) - start) / pageSize]; }
+};
+
+static LargeObjectSpace largeObjectSpace;
+
+/// The space in which the loader allocates constants like the strings of the string pool. Its objects are never moved,
+/// marked or freed, hence they must only reference objects in this space.
+static Space immortalSpace;
 
+// The compacting collector sets the bits of all granules of alignof(Object) bytes occupied by live objects in liveMap.
+// An object is moved to the start of currentSpace plus the size of the live granules before it, which are counted with
+// the help of liveBefore. Both are kept until the next collection so that the new location of an object can be found.
+static const size_t granuleSize = alignof(Object);
+static uint64_t *liveMap = nullptr;
+/// The number of live granules before the granules of each word of liveMap
+static size_t *liveBefore = nullptr;
+/// The number of words of liveMap that cover the objects allocated before the last collection
+static size_t liveMapWords = 0;
+/// True while the compacting collector updates the references to the live objects before it moves them
+static bool updatingReferences = false;
+/// The references marked while updatingReferences is true. They are updated after the object containing them has been
+/// marked completely, as mark functions read the objects referenced by the references they mark.
+static std::vector<Object **> referencesToUpdate;
+
+/// Returns the location to which the compacting collector moves or moved the live @c object.
+static Object* compactedLocation(const Object *object) {
+    size_t granule = (reinterpret_cast<const Byte *>(object) - currentSpace.start) / granuleSize;
+    uint64_t before = liveMap[granule / 64] & ((uint64_t(1) << (granule % 64)) - 1);
+    size_t offset = (liveBefore[granule / 64] + __builtin_popcountll(before)) * granuleSize;
+    return reinterpret_cast<Object *>(currentSpace.start + offset);
+}
+
+/// True while the generational collector only collects the nursery
+bool minorCollection = false;
+
+Byte *cardedSpace = nullptr;
+size_t cardedSpaceSize = 0;
+Byte *cardTable = nullptr;
+/// For each card of the carded space @c cardSize minus the offset of the first object starting in the card, or 0 if no
+/// object starts in it, so that memory returned to the operating system reads as empty. Used to find the objects in a
+/// dirty card.
+uint16_t *firstObjectInCard = nullptr;
+
+void gc(std::unique_lock<std::mutex> &allocationLock, bool full);
+static void resizeSemispaces(size_t size);
+static Object* allocateLargeObject(size_t size, Object **moved);
+
+// The stop-the-world handshake: The collecting thread sets safepointRequested and waits until all other threads
+// reached a safepoint, where they increment pausingThreadsCount and wait until safepointRequested is cleared again.
+// safepointRequested, pausingThreadsCount and the conditions are only modified while pausingThreadsCountMutex is held,
+// which makes all writes to the heap before a pause visible to the collector and vice versa. Reading
+// safepointRequested without the lock is only a hint, which is always confirmed after obtaining the lock.
 int pausingThreadsCount = 0;
-bool pauseThreads = false;  // Must only be set after a allocationMutex lock was obtained
+std::atomic<bool> safepointRequested(false);
 std::mutex pausingThreadsCountMutex;
 std::mutex allocationMutex;
 std::condition_variable pauseThreadsCondition;
 std::condition_variable pausingThreadsCountCondition;
 
-Object* emojicodeMalloc(size_t size) {
-    // We must obtain this mutex lock first to avoid a race condition on pauseThreads
+/// The part of the current semispace reserved by a thread for allocations without locking. Allocation buffers are
+/// invalidated by a collection, which increments gcCycle, as the semispaces are swapped then.
+struct AllocationBuffer {
+    Byte *top = nullptr;
+    Byte *end = nullptr;
+    size_t cycle = 0;
+};
+
+// Only modified while all other threads are paused, the pause handshake makes the new value visible to them
+size_t gcCycle = 1;
+thread_local AllocationBuffer allocationBuffer;
+
+/// Records that an object starts at @c address. Safe to be called by the GC workers concurrently.
+static void recordObjectStart(Byte *address) {
+    size_t offset = address - cardedSpace;
+    uint16_t *first = firstObjectInCard + (offset >> cardShift);
+    auto start = static_cast<uint16_t>(cardSize - (offset & (cardSize - 1)));
+    uint16_t current = __atomic_load_n(first, __ATOMIC_RELAXED);
+    while (start > current && !__atomic_compare_exchange_n(first, &current, start, true, __ATOMIC_RELAXED,
+                                                           __ATOMIC_RELAXED)) {}
+}
+
+/// The objects that threads follow across an allocation with followMove. The collectors keep them alive but do not
+/// update the pointers, as the compacting collector would otherwise overwrite them if they are unreachable. Only
+/// modified while allocationMutex is held.
+static std::vector<Object **> followedObjects;
+
+/// Adds @c moved to followedObjects unless it is @c nullptr. allocationMutex must be held.
+static void follow(Object **moved) {
+    if (moved) {
+        followedObjects.push_back(moved);
+    }
+}
+
+/// Removes @c moved from followedObjects unless it is @c nullptr. allocationMutex must be held.
+static void unfollow(Object **moved) {
+    if (moved) {
+        followedObjects.erase(std::find(followedObjects.begin(), followedObjects.end(), moved));
+    }
+}
+
+/// Returns the new location of @c object if a collection moved it since gcCycle was @c cycle, which is updated. Moved
+/// objects are left intact, or their new location can be computed, until the next collection, so an object can be
+/// followed across allocations without retaining it if this is done after each pause.
+static Object* followMove(Object *object, size_t &cycle) {
+    if (cycle == gcCycle) {
+        return object;
+    }
+    cycle = gcCycle;
+    if (collector == Collector::Compacting) {
+        return currentSpace.contains(object) ? compactedLocation(object) : object;
+    }
+    Object *newLocation = object->newLocation;
+    return currentSpace.contains(newLocation) ? newLocation : object;
+}
+
+/// Zeroes the @c size bytes at @c block, which were just allocated from @c space, unless they are zero already.
+/// Memory is zeroed as it is allocated so that a collection pause does not depend on the size of the heap.
+static void zeroAllocatedMemory(const Space &space, Byte *block, size_t size) {
+    Byte *touchedEnd = space.start + space.touched;
+    if (block < touchedEnd) {
+        std::memset(block, 0, std::min(block + size, touchedEnd) - block);
+    }
+}
+
+/// Allocates @c size bytes directly from the allocation space or refills the allocation buffer of the calling thread
+/// and allocates from it. If @c moved is not @c nullptr, it is updated if a collection moves the object.
+static Object* allocateSlowPath(size_t size, Object **moved) {
+    size_t cycle = gcCycle;
+    // We must obtain this mutex lock first so that no other thread can start a collection meanwhile
     std::unique_lock<std::mutex> lock(allocationMutex);
+    follow(moved);
     pauseForGC();
-    if (memoryUse + size > gcThreshold) {
-        if (size > gcThreshold) {
-            error("Allocation of %zu bytes is too big. Try to enlarge the heap. (Heap size: %zu)", size, heapSize);
+    if (moved) {
+        *moved = followMove(*moved, cycle);
+    }
+    if (size > currentSpace.capacity) {
+        error("Allocation of %zu bytes is too big. Try to enlarge the heap with --heap-size. (Maximum heap size: %zu)",
+              size, maximumHeapSize);
+    }
+
+    // Objects too large for the nursery are allocated in the old space right away
+    bool pretenure = collector == Collector::Generational && size > nursery.size / 2;
+    Space &space = pretenure ? currentSpace : *allocationSpace;
+    if (space.available() < size) {
+        gc(lock, pretenure);
+        if (moved) {
+            *moved = followMove(*moved, cycle);
+        }
+        // The nursery is empty after a collection, so only the semispaces might be too small
+        if (space.available() < size) {
+            if (size > currentSpace.capacity - currentSpace.used) {
+                error("Terminating program due to too high memory pressure.");
+            }
+            resizeSemispaces(std::max(2 * currentSpace.size, currentSpace.used + size));
         }
+    }
 
-        gc(lock);
+    Byte *block = space.top();
+    // Large objects are not allocated in the buffer, which would otherwise waste most of its remaining space
+    if (pretenure || size > allocationBufferSize / 4) {
+        space.used += size;
+        if (pretenure) {
+            recordObjectStart(block);
+        }
+        unfollow(moved);
+        lock.unlock();
+        zeroAllocatedMemory(space, block, size);
+        return reinterpret_cast<Object *>(block);
     }
-    Byte *block = currentHeap + memoryUse;
-    memoryUse += size;
+
+    size_t bufferSize = std::min(std::max(size, static_cast<size_t>(allocationBufferSize)), space.available());
+    space.used += bufferSize;
+    allocationBuffer.top = block + size;
+    allocationBuffer.end = block + bufferSize;
+    allocationBuffer.cycle = gcCycle;
+    unfollow(moved);
+    // No collection can start before this thread reaches a safepoint, so the buffer can be zeroed without the lock
+    lock.unlock();
+    zeroAllocatedMemory(space, block, bufferSize);
     return reinterpret_cast<Object *>(block);
 }
 
+static inline Object* allocate(size_t size, Object **moved) {
+    AllocationBuffer &buffer = allocationBuffer;
+    if (buffer.cycle == gcCycle && size <= static_cast<size_t>(buffer.end - buffer.top)) {
+        Byte *block = buffer.top;
+        buffer.top += size;
+        return reinterpret_cast<Object *>(block);
+    }
+    return allocateSlowPath(size, moved);
+}
+
+Object* emojicodeMalloc(size_t size) {
+    return allocate(size, nullptr);
+}
+
 Object* emojicodeRealloc(Object *ptr, size_t oldSize, size_t newSize) {
-    // We must obtain this mutex lock first to avoid a race condition on pauseThreads
+    size_t cycle = gcCycle;
+    auto end = reinterpret_cast<Byte *>(ptr) + oldSize;
+    // Nothing has been allocated from the allocation buffer since the allocation of ptr
+    AllocationBuffer &buffer = allocationBuffer;
+    if (buffer.cycle == gcCycle && end == buffer.top && newSize <= oldSize + (buffer.end - end)) {
+        buffer.top += newSize - oldSize;
+        return ptr;
+    }
+
     std::unique_lock<std::mutex> lock(allocationMutex);
+    follow(&ptr);
     pauseForGC();
-    // Nothing has been allocated since the allocation of ptr
-    if (ptr == reinterpret_cast<Object *>(currentHeap + memoryUse - oldSize) && memoryUse + newSize < gcThreshold) {
-        memoryUse += newSize - oldSize;
-        return ptr;
+    unfollow(&ptr);
+    ptr = followMove(ptr, cycle);
+    end = reinterpret_cast<Byte *>(ptr) + oldSize;
+    // Nothing has been allocated from the space since the allocation of ptr, which was too large for the buffer
+    for (Space *space : { allocationSpace, &currentSpace }) {
+        if (end == space->top() && newSize <= oldSize + space->available()) {
+            space->used += newSize - oldSize;
+            zeroAllocatedMemory(*space, end, newSize - oldSize);
+            return ptr;
+        }
     }
     lock.unlock();
-    Object *block = emojicodeMalloc(newSize);
+    // The elements of ptr are only updated by a collection if ptr is followed to its new location
+    Object *block = allocate(newSize, &ptr);
     std::memcpy(block, ptr, oldSize);
     return block;
 }
 
-static Object* newObjectWithSizeInternal(Class *klass, size_t size) {
-    size_t fullSize = sizeof(Object) + size;
-    Object *object = emojicodeMalloc(fullSize);
-    object->size = fullSize;
-    object->klass = klass;
-    object->value = ((Byte *)object) + sizeof(Object) + (klass->size - klass->valueSize);
+/// Rounds the size of an object up so that the object following it is aligned. The collector swaps the class of an
+/// object for its new location atomically, which is very slow if the class crosses a cache line.
+static size_t alignedObjectSize(size_t size) {
+    return (size + alignof(Object) - 1) & ~(alignof(Object) - 1);
+}
 
-    return object;
+/// The size of an array is stored in its first word, which CL_ARRAY declares as its only instance variable.
+static size_t& arraySize(Object *array) {
+    return *reinterpret_cast<size_t *>(array->variableDestination(0));
+}
+
+/// Returns the size of an object of @c klass, which must not be CL_ARRAY, including @c inlineSize bytes stored inline
+/// behind it.
+static size_t instanceSize(Class *klass, size_t inlineSize = 0) {
+    return alignedObjectSize(sizeof(Object) + klass->size + inlineSize);
+}
+
+/// Returns the number of bytes of the characters stored inline behind @c string.
+static size_t inlineCharactersSize(const String *string) {
+    if (string->characters != nullptr) {
+        return 0;
+    }
+    return string->latin1 ? string->length : string->length * sizeof(EmojicodeChar);
+}
+
+/// Returns the size of @c object, whose class is @c klass, in bytes. The class is passed as the collector might have
+/// replaced it with the new location of the object already.
+static size_t objectSize(Object *object, Class *klass) {
+    if (klass == CL_ARRAY) {
+        return arraySize(object);
+    }
+    if (klass == CL_STRING) {
+        auto string = reinterpret_cast<String *>(reinterpret_cast<Byte *>(object) + sizeof(Object) + klass->size -
+                                                 klass->valueSize);
+        return instanceSize(klass, inlineCharactersSize(string));
+    }
+    return instanceSize(klass);
+}
+
+/// Returns the size of an array whose value area is @c size bytes large.
+static size_t arrayObjectSize(size_t size) {
+    return alignedObjectSize(sizeof(Object) + sizeof(size_t) + size);
+}
+
+/// The class of the fillers that are too small to be an array. Its instances consist of the header only.
+static Class wordFiller(nullptr);
+
+/// Turns the memory from @c start to @c end into an array, which keeps currentSpace iterable.
+static void fill(Byte *start, Byte *end) {
+    if (start < end) {
+        auto filler = reinterpret_cast<Object *>(start);
+        if (end - start == sizeof(Object)) {
+            filler->klass = &wordFiller;
+            return;
+        }
+        filler->klass = CL_ARRAY;
+        arraySize(filler) = end - start;
+    }
 }
 
 Object* newObject(Class *klass) {
-    return newObjectWithSizeInternal(klass, klass->size);
+    Object *object = emojicodeMalloc(instanceSize(klass));
+    object->klass = klass;
+    return object;
 }
 
 size_t sizeCalculationWithOverflowProtection(size_t items, size_t itemSize) {
@@ -88,114 +388,841 @@ size_t sizeCalculationWithOverflowProtection(size_t items, size_t itemSize) {
 }
 
 Object* newArray(size_t size) {
-    size_t fullSize = sizeof(Object) + size;
-    Object *object = emojicodeMalloc(fullSize);
-    object->size = fullSize;
+    size_t fullSize = arrayObjectSize(size);
+    Object *object = fullSize >= largeObjectSize ? allocateLargeObject(fullSize, nullptr) : emojicodeMalloc(fullSize);
     object->klass = CL_ARRAY;
-    object->value = ((Byte *)object) + sizeof(Object);
-
+    arraySize(object) = fullSize;
     return object;
 }
 
+/// Releases the memory from @c newSize to @c oldSize bytes behind the start of @c object, which was shrunk. The memory
+/// is returned to the allocation buffer if @c object was the last object allocated from it.
+static void releaseTail(Object *object, size_t oldSize, size_t newSize) {
+    Byte *end = reinterpret_cast<Byte *>(object) + oldSize;
+    Byte *newEnd = reinterpret_cast<Byte *>(object) + newSize;
+    AllocationBuffer &buffer = allocationBuffer;
+    if (buffer.cycle == gcCycle && end == buffer.top) {
+        // The allocation buffer must only contain zeroed memory
+        std::memset(newEnd, 0, end - newEnd);
+        buffer.top = newEnd;
+    }
+    else {
+        fill(newEnd, end);
+    }
+}
+
+/// Returns the number of bytes occupied by @c array, which must be in the large object space.
+static size_t largeObjectCapacity(Object *array) {
+    // Other threads insert into and erase from the map while allocating
+    std::lock_guard<std::mutex> lock(allocationMutex);
+    auto it = largeObjectSpace.objects.find(array);
+    return it != largeObjectSpace.objects.end() ? it->second : 0;
+}
+
 Object* resizeArray(Object *array, size_t size) {
-    size_t fullSize = sizeof(Object) + size;
-    Object *object = emojicodeRealloc(array, array->size, fullSize);
-    object->size = fullSize;
-    object->value = ((Byte *)object) + sizeof(Object);
+    size_t fullSize = arrayObjectSize(size);
+    Object *object;
+    if (largeObjectSpace.contains(array) && fullSize <= largeObjectCapacity(array)) {
+        object = array;
+    }
+    else if (largeObjectSpace.contains(array) || fullSize >= largeObjectSize) {
+        object = allocateLargeObject(fullSize, &array);
+        std::memcpy(object, array, std::min(arraySize(array), fullSize));
+    }
+    else if (fullSize < arraySize(array)) {
+        releaseTail(array, arraySize(array), fullSize);
+        object = array;
+    }
+    else {
+        object = emojicodeRealloc(array, arraySize(array), fullSize);
+    }
+    arraySize(object) = fullSize;
     return object;
 }
 
-void allocateHeap() {
-    currentHeap = static_cast<Byte *>(calloc(heapSize, 1));
-    if (!currentHeap) {
+Object* newString(size_t length, bool latin1) {
+    size_t size = latin1 ? length : sizeCalculationWithOverflowProtection(length, sizeof(EmojicodeChar));
+    Object *object;
+    if (size >= largeObjectSize) {
+        // Large objects are never moved, so the characters do not need to be copied by each collection
+        Object *characters = newArray(size);
+        object = allocate(instanceSize(CL_STRING), &characters);
+        object->klass = CL_STRING;
+        static_cast<String *>(object->value())->characters = characters;
+    }
+    else {
+        object = emojicodeMalloc(instanceSize(CL_STRING, size));
+        object->klass = CL_STRING;
+    }
+    auto string = static_cast<String *>(object->value());
+    string->length = length;
+    string->latin1 = latin1;
+    return object;
+}
+
+Object* resizeString(Object *object, size_t length) {
+    auto string = static_cast<String *>(object->value());
+    size_t oldSize = instanceSize(CL_STRING, inlineCharactersSize(string));
+    size_t newSize = instanceSize(CL_STRING, string->latin1 ? length : length * sizeof(EmojicodeChar));
+    if (newSize > oldSize) {
+        object = emojicodeRealloc(object, oldSize, newSize);
+    }
+    else if (newSize < oldSize) {
+        releaseTail(object, oldSize, newSize);
+    }
+    static_cast<String *>(object->value())->length = length;
+    return object;
+}
+
+static size_t roundUpToPage(size_t size) {
+    return (size + pageSize - 1) & ~(pageSize - 1);
+}
+
+/// Reserves address space of @c size bytes. The memory is zero and only committed once it is used.
+static Byte* reserveMemory(size_t size) {
+    void *memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (memory == MAP_FAILED) {
         error("Cannot allocate heap!");
     }
-    otherHeap = currentHeap + (heapSize / 2);
+    return static_cast<Byte *>(memory);
+}
+
+/// Returns the memory from @c from to @c to, which must be page aligned, to the operating system.
+static void releaseMemory(Byte *from, Byte *to) {
+    if (from < to) {
+        madvise(from, to - from, MADV_DONTNEED);
+    }
+}
+
+void allocateImmortalSpace(size_t objects, size_t bytes) {
+    // Each object is padded by less than alignof(Object) bytes and arrays store their size
+    immortalSpace.capacity = immortalSpace.size = objects * (sizeof(Object) + sizeof(size_t) + alignof(Object)) + bytes;
+    if (immortalSpace.capacity > 0) {
+        immortalSpace.start = reserveMemory(immortalSpace.capacity);
+    }
+}
+
+Object* newImmortalObject(Class *klass, size_t size) {
+    size_t fullSize = klass == CL_ARRAY ? arrayObjectSize(size) : instanceSize(klass, size - klass->size);
+    if (fullSize > immortalSpace.available()) {
+        error("The immortal space is too small.");
+    }
+    auto object = reinterpret_cast<Object *>(immortalSpace.top());
+    immortalSpace.used += fullSize;
+    object->klass = klass;
+    if (klass == CL_ARRAY) {
+        arraySize(object) = fullSize;
+    }
+    return object;
+}
+
+/// Returns the memory of @c space behind its size to the operating system.
+static void releaseUnusedMemory(Space &space) {
+    size_t keep = roundUpToPage(space.size);
+    if (space.touched <= keep) {
+        return;
+    }
+    releaseMemory(space.start + keep, space.start + roundUpToPage(space.touched));
+    if (cardTable) {
+        size_t firstCard = (space.start + keep - cardedSpace) >> cardShift;
+        size_t lastCard = (space.start + space.touched - cardedSpace + cardSize - 1) >> cardShift;
+        std::memset(cardTable + firstCard, 0, lastCard - firstCard);
+        std::memset(firstObjectInCard + firstCard, 0, (lastCard - firstCard) * sizeof(uint16_t));
+    }
+#ifdef __linux__
+    // Only Linux guarantees that the memory reads as zero afterwards
+    space.touched = keep;
+#endif
 }
 
-bool inNewHeap(Object *o) {
-    return currentHeap <= reinterpret_cast<Byte *>(o) && reinterpret_cast<Byte *>(o) < currentHeap + heapSize / 2;
+/// Changes the size of both semispaces to @c size bytes, which is rounded to pages and limited to their capacity. The
+/// compacting collector only uses currentSpace.
+static void resizeSemispaces(size_t size) {
+    size = std::max(std::min(roundUpToPage(size), currentSpace.capacity), currentSpace.used);
+    currentSpace.size = otherSpace.size = size;
+}
+
+/// Allocates @c size bytes for an array in the large object space. A full collection is started first if the space
+/// grew too much since the last one. If @c moved is not @c nullptr, it is updated if a collection moves the object.
+static Object* allocateLargeObject(size_t size, Object **moved) {
+    size_t cycle = gcCycle;
+    std::unique_lock<std::mutex> lock(allocationMutex);
+    follow(moved);
+    pauseForGC();
+    if (moved) {
+        *moved = followMove(*moved, cycle);
+    }
+    LargeObjectSpace &space = largeObjectSpace;
+    size = roundUpToPage(size);
+    if (space.used + size > space.limit) {
+        gc(lock, true);
+        if (moved) {
+            *moved = followMove(*moved, cycle);
+        }
+    }
+    unfollow(moved);
+    // The semispaces, of which the compacting collector only uses one, and the large objects together must not exceed
+    // the maximum heap size
+    size_t semispaces = collector == Collector::Compacting ? 1 : 2;
+    if (space.used + size + semispaces * (currentSpace.used + nursery.size) > maximumHeapSize) {
+        error("Terminating program due to too high memory pressure.");
+    }
+
+    size_t offset = space.top;
+    auto run = std::find_if(space.freeRuns.begin(), space.freeRuns.end(), [size](const std::pair<size_t, size_t> &run) {
+        return run.second >= size;
+    });
+    if (run != space.freeRuns.end()) {
+        offset = run->first;
+        if (run->second > size) {
+            space.freeRuns.emplace(offset + size, run->second - size);
+        }
+        space.freeRuns.erase(run);
+    }
+    else if (space.capacity - space.top < size) {
+        error("Terminating program due to too high memory pressure.");
+    }
+    else {
+        space.top += size;
+    }
+    space.used += size;
+
+    auto object = reinterpret_cast<Object *>(space.start + offset);
+#ifndef __linux__
+    // Only Linux guarantees that the memory of freed arrays reads as zero
+    std::memset(object, 0, size);
+#endif
+    space.objects.emplace(object, size);
+    return object;
+}
+
+/// Returns the @c size bytes of the large object space from @c offset on to the operating system and makes them
+/// available for new arrays.
+static void freeLargeObjectPages(size_t offset, size_t size) {
+    LargeObjectSpace &space = largeObjectSpace;
+    releaseMemory(space.start + offset, space.start + offset + size);
+    auto next = space.freeRuns.lower_bound(offset);
+    if (next != space.freeRuns.begin() && std::prev(next)->first + std::prev(next)->second == offset) {
+        auto previous = std::prev(next);
+        offset = previous->first;
+        size += previous->second;
+        space.freeRuns.erase(previous);
+    }
+    if (next != space.freeRuns.end() && next->first == offset + size) {
+        size += next->second;
+        space.freeRuns.erase(next);
+    }
+    if (offset + size == space.top) {
+        space.top = offset;
+    }
+    else {
+        space.freeRuns.emplace(offset, size);
+    }
+}
+
+/// Frees the arrays that were found unreachable by the previous full collection.
+static void freeCondemnedLargeObjects() {
+    for (auto &object : largeObjectSpace.condemned) {
+        freeLargeObjectPages(reinterpret_cast<Byte *>(object.first) - largeObjectSpace.start, object.second);
+    }
+    largeObjectSpace.condemned.clear();
+}
+
+/// Condemns the arrays that were not marked by a full collection and clears the marks of the others.
+static void sweepLargeObjects() {
+    LargeObjectSpace &space = largeObjectSpace;
+    for (auto it = space.objects.begin(); it != space.objects.end();) {
+        Byte &mark = space.mark(it->first);
+        if (mark) {
+            mark = 0;
+            ++it;
+            continue;
+        }
+        space.used -= it->second;
+        space.condemned.emplace_back(*it);
+        it = space.objects.erase(it);
+    }
+    space.limit = std::max(2 * space.used, static_cast<size_t>(initialSemispaceSize));
+}
+
+void allocateHeap() {
+    CL_ARRAY->size = sizeof(size_t);
+    if (gcThreads == 0) {
+        gcThreads = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    if (maximumHeapSize == 0) {
+        maximumHeapSize = static_cast<size_t>(sysconf(_SC_PHYS_PAGES)) * pageSize;
+    }
+
+    // The nursery and the semispaces are page aligned, which makes them card aligned too
+    size_t nurserySize = 0;
+    if (collector == Collector::Generational) {
+        nurserySize = std::min(maximumHeapSize / 32, static_cast<size_t>(maximumNurserySize)) & ~(pageSize - 1);
+    }
+    // The compacting collector does not need otherSpace
+    size_t semispaces = collector == Collector::Compacting ? 1 : 2;
+    size_t semispaceCapacity = (maximumHeapSize - 2 * nurserySize) / semispaces & ~(pageSize - 1);
+    if (semispaceCapacity == 0) {
+        error("The heap size %zu is too small.", maximumHeapSize);
+    }
+    Byte *heap = reserveMemory(2 * nurserySize + semispaces * semispaceCapacity);
+
+    nursery.start = heap;
+    previousNursery.start = heap + nurserySize;
+    nursery.size = nursery.capacity = previousNursery.size = previousNursery.capacity = nurserySize;
+    currentSpace.start = heap + 2 * nurserySize;
+    currentSpace.capacity = semispaceCapacity;
+    if (semispaces == 2) {
+        otherSpace.start = currentSpace.start + semispaceCapacity;
+        otherSpace.capacity = semispaceCapacity;
+    }
+    resizeSemispaces(initialSemispaceSize);
+
+    if (collector == Collector::Compacting) {
+        size_t words = (semispaceCapacity / granuleSize + 63) / 64;
+        liveMap = reinterpret_cast<uint64_t *>(reserveMemory(words * sizeof(uint64_t)));
+        liveBefore = reinterpret_cast<size_t *>(reserveMemory(words * sizeof(size_t)));
+    }
+
+    if (collector == Collector::Generational) {
+        allocationSpace = &nursery;
+        cardedSpace = currentSpace.start;
+        cardedSpaceSize = 2 * semispaceCapacity;
+        size_t cards = cardedSpaceSize >> cardShift;
+        cardTable = reserveMemory(cards);
+        firstObjectInCard = reinterpret_cast<uint16_t *>(reserveMemory(cards * sizeof(uint16_t)));
+    }
+
+    // Freed arrays are only reused if they are large enough, twice the address space is reserved to leave room for
+    // the fragmentation and for the arrays that are not freed yet
+    largeObjectSpace.capacity = 2 * (maximumHeapSize & ~(pageSize - 1));
+    largeObjectSpace.start = reserveMemory(largeObjectSpace.capacity);
+    largeObjectSpace.marks = reserveMemory(largeObjectSpace.capacity / pageSize);
+    largeObjectSpace.limit = initialSemispaceSize;
+}
+
+/// The state of a thread collecting garbage. Every worker copies objects into its own buffer in currentSpace and
+/// keeps the copied objects, whose references must still be marked, on a stack. Part of the stack is shared with the
+/// other workers, which steal from it once they ran out of work.
+struct GCWorker {
+    /// The buffer into which objects are copied
+    Byte *start = nullptr;
+    Byte *top = nullptr;
+    Byte *end = nullptr;
+    /// Objects that were copied, or marked by the compacting collector, but whose references were not marked yet. Only
+    /// accessed by the worker itself.
+    std::vector<Object *> grey;
+    std::mutex sharedMutex;
+    /// Objects that were copied but whose references were not marked yet and which might be stolen.
+    std::deque<Object *> shared;
+    std::atomic<size_t> sharedCount;
+};
+
+/// The threads that help the collecting thread, which are started by the first collection. The pool is never
+/// destroyed as the threads still wait for the next collection when the program exits.
+struct GCWorkerPool {
+    std::mutex mutex;
+    std::condition_variable start;
+    std::condition_variable done;
+    /// Incremented to make the threads perform collectInParallel
+    size_t cycle = 0;
+    unsigned int running = 0;
+};
+
+unsigned int gcThreads = 0;
+static GCWorker *workers = nullptr;
+static GCWorkerPool *workerPool = nullptr;
+thread_local GCWorker *gcWorker = nullptr;
+static std::atomic<unsigned int> idleWorkers;
+
+// The roots are divided into tasks, which are claimed by the workers by incrementing nextRootTask: one task per
+// thread, one task for followedObjects, then cardsTaskSize cards of the old space per task. The strings of the string
+// pool are immortal.
+#define cardsTaskSize 256
+static std::vector<Thread *> rootThreads;
+static size_t cardTasks, firstCard;
+static std::atomic<size_t> nextRootTask;
+/// The top of currentSpace when a minor collection began. Only objects below it must be scanned for dirty cards.
+static Byte *promoted;
+
+/// Reserves @c size bytes in currentSpace. Returns @c nullptr if currentSpace is too full.
+static Byte* reserveInCurrentSpace(size_t size) {
+    size_t used = __atomic_load_n(&currentSpace.used, __ATOMIC_RELAXED);
+    do {
+        // The space is resized after the collection if its size is exceeded
+        if (currentSpace.capacity - used < size) {
+            return nullptr;
+        }
+    } while (!__atomic_compare_exchange_n(&currentSpace.used, &used, used + size, true, __ATOMIC_RELAXED,
+                                          __ATOMIC_RELAXED));
+    return currentSpace.start + used;
+}
+
+/// Allocates @c size bytes in currentSpace to copy an object to.
+static Byte* allocateForCopy(GCWorker &worker, size_t size) {
+    // The remaining space in the buffer must be large enough for a filler
+    size_t remaining = worker.end - worker.top;
+    if (size == remaining || (size < remaining && remaining - size >= sizeof(Object))) {
+        Byte *block = worker.top;
+        worker.top += size;
+        return block;
+    }
+    Byte *block;
+    if (size <= allocationBufferSize / 4 && (block = reserveInCurrentSpace(allocationBufferSize))) {
+        fill(worker.top, worker.end);
+        worker.start = block;
+        worker.top = block + size;
+        worker.end = block + allocationBufferSize;
+        return block;
+    }
+    if (!(block = reserveInCurrentSpace(size))) {
+        error("Terminating program due to too high memory pressure.");
+    }
+    return block;
+}
+
+/// Pushes a copied object, whose references must be marked, and shares some of the objects if nothing is shared.
+static void pushGrey(GCWorker &worker, Object *object) {
+    worker.grey.push_back(object);
+    if (worker.grey.size() >= 64 && worker.sharedCount.load(std::memory_order_relaxed) == 0 && gcThreads > 1) {
+        std::lock_guard<std::mutex> lock(worker.sharedMutex);
+        worker.shared.insert(worker.shared.end(), worker.grey.begin(), worker.grey.begin() + 32);
+        worker.grey.erase(worker.grey.begin(), worker.grey.begin() + 32);
+        worker.sharedCount.store(worker.shared.size(), std::memory_order_relaxed);
+    }
+}
+
+/// Sets the bits of all granules occupied by @c object in liveMap. Returns false if the object was marked already.
+static bool markLive(Object *object) {
+    size_t first = (reinterpret_cast<Byte *>(object) - currentSpace.start) / granuleSize;
+    uint64_t bit = uint64_t(1) << (first % 64);
+    if (__atomic_fetch_or(&liveMap[first / 64], bit, __ATOMIC_RELAXED) & bit) {
+        return false;
+    }
+    // No other object occupies the remaining granules, but other workers might mark objects sharing their words
+    size_t end = first + objectSize(object, object->klass) / granuleSize;
+    for (size_t granule = first + 1; granule < end;) {
+        size_t bits = std::min(64 - granule % 64, end - granule);
+        uint64_t mask = (bits == 64 ? ~uint64_t(0) : (uint64_t(1) << bits) - 1) << (granule % 64);
+        __atomic_fetch_or(&liveMap[granule / 64], mask, __ATOMIC_RELAXED);
+        granule += bits;
+    }
+    return true;
 }
 
 void mark(Object **oPointer) {
     Object *oldObject = *oPointer;
-    if (inNewHeap(oldObject->newLocation)) {
-        *oPointer = oldObject->newLocation;
+    // Instance variables of an object whose initializer is still running might not have been assigned yet.
+    if (oldObject == nullptr || (minorCollection && !nursery.contains(oldObject))) {
+        return;
+    }
+    // Immortal objects only reference other immortal objects
+    if (immortalSpace.contains(oldObject)) {
+        return;
+    }
+    if (updatingReferences) {
+        if (currentSpace.contains(oldObject)) {
+            referencesToUpdate.push_back(oPointer);
+        }
+        return;
+    }
+    // Large objects are arrays, whose elements are marked by the objects owning them
+    if (largeObjectSpace.contains(oldObject)) {
+        __atomic_store_n(&largeObjectSpace.mark(oldObject), 1, __ATOMIC_RELAXED);
+        return;
+    }
+    if (collector == Collector::Compacting) {
+        if (markLive(oldObject)) {
+            pushGrey(*gcWorker, oldObject);
+        }
+        return;
+    }
+    // The class of a moved object is replaced with its new location
+    Object *newLocation = __atomic_load_n(&oldObject->newLocation, __ATOMIC_ACQUIRE);
+    if (currentSpace.contains(newLocation)) {
+        *oPointer = newLocation;
         return;
     }
 
-    Object *newObject = reinterpret_cast<Object *>(currentHeap + memoryUse);
-    memoryUse += oldObject->size;
-
-    std::memcpy(newObject, oldObject, oldObject->size);
+    auto klass = reinterpret_cast<Class *>(newLocation);
+    GCWorker &worker = *gcWorker;
+    size_t size = objectSize(oldObject, klass);
+    Byte *block = allocateForCopy(worker, size);
+    auto newObject = reinterpret_cast<Object *>(block);
+    std::memcpy(newObject, oldObject, size);
+    newObject->klass = klass;
 
-    newObject->value = reinterpret_cast<Byte *>(newObject) + sizeof(Object)
-                        + oldObject->klass->size - oldObject->klass->valueSize;
-    oldObject->newLocation = newObject;
+    // Another worker might be copying the same object
+    if (!__atomic_compare_exchange_n(&oldObject->newLocation, &newLocation, newObject, false, __ATOMIC_ACQ_REL,
+                                     __ATOMIC_ACQUIRE)) {
+        if (block + size == worker.top && block >= worker.start) {
+            worker.top = block;
+        }
+        else {
+            fill(block, block + size);
+        }
+        *oPointer = newLocation;
+        return;
+    }
+    if (cardTable) {
+        recordObjectStart(block);
+    }
+    pushGrey(worker, newObject);
     *oPointer = newObject;
 }
 
-void gc(std::unique_lock<std::mutex> &allocationLock) {
-    pauseThreads = true;
-    allocationLock.unlock();
+static void markObject(Object *object) {
+    markByPointerMap(object->klass->pointerMap, object->variableDestination(0));
 
-    auto pausingThreadsCountLock = std::unique_lock<std::mutex>(pausingThreadsCountMutex);
-    pausingThreadsCount++;
+    if (object->klass->mark) object->klass->mark(object);
+}
 
-    pausingThreadsCountCondition.wait(pausingThreadsCountLock, []{ return pausingThreadsCount == Thread::threads(); });
+/// Marks the objects in the old space that start in a dirty card and cleans the card.
+static void markCard(size_t card) {
+    if (!cardTable[card]) {
+        return;
+    }
+    cardTable[card] = 0;
+    Byte *cardStart = cardedSpace + (card << cardShift);
+    Byte *cardEnd = std::min(cardStart + cardSize, promoted);
+    for (Byte *byte = cardStart + cardSize - firstObjectInCard[card]; byte < cardEnd;) {
+        auto object = reinterpret_cast<Object *>(byte);
+        markObject(object);
+        byte += objectSize(object, object->klass);
+    }
+}
 
-    std::swap(currentHeap, otherHeap);
+static void markRootTask(size_t task) {
+    if (task < rootThreads.size()) {
+        rootThreads[task]->markStack();
+        rootThreads[task]->markRetainList();
+        return;
+    }
+    task -= rootThreads.size();
+    if (task == 0) {
+        // The pointers are updated by followMove after the collection
+        for (Object **moved : followedObjects) {
+            Object *object = *moved;
+            mark(&object);
+        }
+        return;
+    }
+    task--;
+    size_t lastCard = firstCard + ((promoted - currentSpace.start + cardSize - 1) >> cardShift);
+    size_t end = std::min(lastCard, firstCard + (task + 1) * cardsTaskSize);
+    for (size_t card = firstCard + task * cardsTaskSize; card < end; card++) {
+        markCard(card);
+    }
+}
 
-    size_t oldMemoryUse = memoryUse;
-    memoryUse = 0;
+/// Moves half of the shared objects of another worker, or of @c worker itself, to the grey objects of @c worker.
+static bool steal(GCWorker &worker) {
+    size_t index = &worker - workers;
+    for (size_t i = 0; i < gcThreads; i++) {
+        GCWorker &victim = workers[(index + i) % gcThreads];
+        if (victim.sharedCount.load(std::memory_order_relaxed) == 0) {
+            continue;
+        }
+        std::lock_guard<std::mutex> lock(victim.sharedMutex);
+        size_t count = (victim.shared.size() + 1) / 2;
+        worker.grey.insert(worker.grey.end(), victim.shared.begin(), victim.shared.begin() + count);
+        victim.shared.erase(victim.shared.begin(), victim.shared.begin() + count);
+        victim.sharedCount.store(victim.shared.size(), std::memory_order_relaxed);
+        if (count > 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool anySharedObjects() {
+    for (size_t i = 0; i < gcThreads; i++) {
+        if (workers[i].sharedCount.load(std::memory_order_relaxed) > 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/// Marks the roots claimed by @c worker and the objects reachable from them. Returns once all workers ran out of
+/// work, which can only happen once no more objects must be marked.
+static void collectInParallel(GCWorker &worker) {
+    gcWorker = &worker;
+    size_t tasks = rootThreads.size() + 1 + cardTasks;
+    for (size_t task; (task = nextRootTask.fetch_add(1, std::memory_order_relaxed)) < tasks;) {
+        markRootTask(task);
+    }
+
+    while (true) {
+        while (!worker.grey.empty()) {
+            Object *object = worker.grey.back();
+            worker.grey.pop_back();
+            markObject(object);
+        }
+        if (steal(worker)) {
+            continue;
+        }
+        // Objects are only shared by workers that are not idle, so there is no more work once all workers are idle
+        idleWorkers.fetch_add(1);
+        while (!anySharedObjects()) {
+            if (idleWorkers.load() == gcThreads) {
+                gcWorker = nullptr;
+                return;
+            }
+            std::this_thread::yield();
+        }
+        idleWorkers.fetch_sub(1);
+    }
+}
+
+static void gcWorkerMain(GCWorker *worker) {
+    size_t cycle = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(workerPool->mutex);
+            workerPool->start.wait(lock, [cycle]{ return workerPool->cycle != cycle; });
+            cycle = workerPool->cycle;
+        }
+        collectInParallel(*worker);
+        std::lock_guard<std::mutex> lock(workerPool->mutex);
+        if (--workerPool->running == 0) {
+            workerPool->done.notify_one();
+        }
+    }
+}
 
+/// Marks the roots, and during a minor collection the dirty cards, and all objects reachable from them using
+/// gcThreads threads. The calling thread is one of them, the others are started the first time.
+static void markInParallel() {
+    if (!workers) {
+        workers = new GCWorker[gcThreads];
+        workerPool = new GCWorkerPool;
+        for (unsigned int i = 1; i < gcThreads; i++) {
+            std::thread(gcWorkerMain, &workers[i]).detach();
+        }
+    }
+
+    rootThreads.clear();
     for (Thread *thread = Thread::lastThread(); thread != nullptr; thread = thread->threadBefore()) {
-        thread->markStack();
-        thread->markRetainList();
+        rootThreads.push_back(thread);
+    }
+    promoted = currentSpace.top();
+    firstCard = cardTable ? (currentSpace.start - cardedSpace) >> cardShift : 0;
+    size_t cards = (currentSpace.used + cardSize - 1) >> cardShift;
+    cardTasks = minorCollection ? (cards + cardsTaskSize - 1) / cardsTaskSize : 0;
+    nextRootTask = 0;
+    idleWorkers = 0;
+    for (unsigned int i = 0; i < gcThreads; i++) {
+        workers[i].start = workers[i].top = workers[i].end = nullptr;
+        workers[i].sharedCount = 0;
     }
 
-    for (uint_fast16_t i = 0; i < stringPoolCount; i++) {
-        mark(stringPool + i);
+    {
+        std::lock_guard<std::mutex> lock(workerPool->mutex);
+        workerPool->running = gcThreads - 1;
+        workerPool->cycle++;
     }
+    workerPool->start.notify_all();
+    collectInParallel(workers[0]);
+    std::unique_lock<std::mutex> lock(workerPool->mutex);
+    workerPool->done.wait(lock, []{ return workerPool->running == 0; });
 
-    for (Byte *byte = currentHeap; byte < currentHeap + memoryUse;) {
-        auto object = reinterpret_cast<Object *>(byte);
+    for (unsigned int i = 0; i < gcThreads; i++) {
+        fill(workers[i].top, workers[i].end);
+    }
+}
+
+/// Makes previousNursery, whose objects were moved by the collection before the last one, the nursery.
+static void flipNursery() {
+    std::swap(nursery, previousNursery);
+    nursery.updateTouched();
+    nursery.used = 0;
+}
 
-        for (size_t i = 0; i < object->klass->instanceVariableRecordsCount; i++) {
-            auto record = object->klass->instanceVariableRecords[i];
-            markByObjectVariableRecord(record, object->variableDestination(0), i);
+/// Promotes all objects in the nursery that are referenced by roots or by objects in dirty cards to currentSpace.
+static void collectNursery() {
+    minorCollection = true;
+    markInParallel();
+    minorCollection = false;
+    flipNursery();
+}
+
+/// Resizes the semispaces after a full collection depending on the fraction of currentSpace occupied by the survivors.
+static void resizeAfterCollection() {
+    size_t size = currentSpace.size;
+    if (currentSpace.used > size / 2) {
+        size *= 2;
+    }
+    else if (currentSpace.used < size / 8) {
+        size /= 2;
+    }
+    resizeSemispaces(std::max(std::max(size, 2 * currentSpace.used), static_cast<size_t>(initialSemispaceSize)));
+}
+
+/// Copies all live objects to otherSpace, which becomes currentSpace, and condemns the unreachable large objects.
+/// Afterwards the semispaces are resized.
+static void collectAll() {
+    currentSpace.updateTouched();
+    std::swap(currentSpace, otherSpace);
+    currentSpace.used = 0;
+    // The objects in otherSpace were moved by the previous collection and are no longer needed
+    releaseUnusedMemory(currentSpace);
+
+    if (cardTable) {
+        for (Space *space : { &currentSpace, &otherSpace }) {
+            size_t firstCard = (space->start - cardedSpace) >> cardShift;
+            size_t cards = (space->touched + cardSize - 1) >> cardShift;
+            std::memset(cardTable + firstCard, 0, cards);
+            if (space == &currentSpace) {
+                std::memset(firstObjectInCard + firstCard, 0, cards * sizeof(uint16_t));
+            }
         }
+    }
+
+    markInParallel();
+    sweepLargeObjects();
+    currentSpace.updateTouched();
+    resizeAfterCollection();
+    // otherSpace is released once it becomes currentSpace as its objects might still be read until then
+    releaseUnusedMemory(currentSpace);
 
-        if (object->klass->mark) object->klass->mark(object);
-        byte += object->size;
+    if (collector == Collector::Generational) {
+        flipNursery();
     }
+}
 
-    if (oldMemoryUse == memoryUse) {
-        error("Terminating program due to too high memory pressure.");
+/// Calls @c function with each object in currentSpace marked in liveMap in the order of their addresses. The function
+/// may move the object to a lower address.
+template <typename Function>
+static void forEachLiveObject(Function function) {
+    size_t granule = 0;
+    while (true) {
+        size_t word = granule / 64;
+        if (word >= liveMapWords) {
+            return;
+        }
+        // All granules of a live object are marked, so the first marked granule is the start of an object
+        uint64_t bits = liveMap[word] & (~uint64_t(0) << (granule % 64));
+        while (bits == 0) {
+            if (++word == liveMapWords) {
+                return;
+            }
+            bits = liveMap[word];
+        }
+        granule = word * 64 + __builtin_ctzll(bits);
+        auto object = reinterpret_cast<Object *>(currentSpace.start + granule * granuleSize);
+        granule += objectSize(object, object->klass) / granuleSize;
+        function(object);
+    }
+}
+
+/// Updates the references collected in referencesToUpdate to the locations to which the objects will be moved.
+static void updateReferences() {
+    for (Object **reference : referencesToUpdate) {
+        *reference = compactedLocation(*reference);
+    }
+    referencesToUpdate.clear();
+}
+
+/// Marks all live objects in liveMap, updates all references to them, and slides them to the start of currentSpace
+/// in their order. Only the references must be held in memory in addition to the heap while they are updated.
+static void collectAndCompact() {
+    currentSpace.updateTouched();
+    // liveMap was kept for followMove until now
+    std::memset(liveMap, 0, liveMapWords * sizeof(uint64_t));
+    liveMapWords = (currentSpace.used / granuleSize + 63) / 64;
+
+    markInParallel();
+    sweepLargeObjects();
+
+    size_t live = 0;
+    for (size_t word = 0; word < liveMapWords; word++) {
+        liveBefore[word] = live;
+        live += __builtin_popcountll(liveMap[word]);
+    }
+
+    // The mark functions collect the references, which are updated once all references of an object were collected
+    updatingReferences = true;
+    for (size_t task = 0; task < rootThreads.size(); task++) {
+        markRootTask(task);
     }
+    updateReferences();
+    forEachLiveObject([](Object *object) {
+        markObject(object);
+        updateReferences();
+    });
+    updatingReferences = false;
+    std::vector<Object **>().swap(referencesToUpdate);
+
+    forEachLiveObject([](Object *object) {
+        Object *newObject = compactedLocation(object);
+        if (newObject != object) {
+            std::memmove(newObject, object, objectSize(object, object->klass));
+        }
+    });
+    currentSpace.used = live * granuleSize;
+    resizeAfterCollection();
+    releaseUnusedMemory(currentSpace);
+}
+
+/// Collects garbage. Unless @c full is true, the generational collector only collects the nursery if all survivors
+/// are guaranteed to fit into currentSpace.
+void gc(std::unique_lock<std::mutex> &allocationLock, bool full) {
+    auto pausingThreadsCountLock = std::unique_lock<std::mutex>(pausingThreadsCountMutex);
+    safepointRequested.store(true, std::memory_order_relaxed);
+    pausingThreadsCount++;
+    // Threads waiting for the allocation lock can now pause as they will see safepointRequested
+    allocationLock.unlock();
+
+    pausingThreadsCountCondition.wait(pausingThreadsCountLock, []{ return pausingThreadsCount == Thread::threads(); });
 
-    if (zeroingNeeded) {
-        std::memset(currentHeap + memoryUse, 0, (heapSize / 2) - memoryUse);
+    freeCondemnedLargeObjects();
+
+    // The buffers of the GC workers are not filled completely
+    size_t promotionReserve = nursery.used + nursery.used / 3 + gcThreads * allocationBufferSize;
+    if (collector == Collector::Generational && !full && promotionReserve <= currentSpace.available()) {
+        collectNursery();
+    }
+    else if (collector == Collector::Compacting) {
+        collectAndCompact();
     }
     else {
-        zeroingNeeded = true;
+        collectAll();
+    }
+    if (currentSpace.used > currentSpace.size) {
+        resizeSemispaces(2 * currentSpace.used);
+    }
+    gcCycle++;
+
+    if (collector == Collector::Generational) {
+        // Native code might store references to new objects into the retained objects without a write barrier
+        for (Thread *thread = Thread::lastThread(); thread != nullptr; thread = thread->threadBefore()) {
+            thread->rememberRetainList();
+        }
     }
 
     pausingThreadsCount--;
+    safepointRequested.store(false, std::memory_order_relaxed);
     pausingThreadsCountLock.unlock();
-    pauseThreads = false;
     pauseThreadsCondition.notify_all();
     allocationLock.lock();
 }
 
 void pauseForGC() {
-    if (pauseThreads) {
-        auto pausingThreadsCountLock = std::unique_lock<std::mutex>(pausingThreadsCountMutex);
-        pausingThreadsCount++;
-        pausingThreadsCountCondition.notify_one();
-        pauseThreadsCondition.wait(pausingThreadsCountLock, []{ return !pauseThreads; });
-        pausingThreadsCount--;
+    if (!safepointRequested.load(std::memory_order_relaxed)) {
+        return;
     }
+    auto pausingThreadsCountLock = std::unique_lock<std::mutex>(pausingThreadsCountMutex);
+    if (!safepointRequested.load(std::memory_order_relaxed)) {
+        return;
+    }
+    pausingThreadsCount++;
+    pausingThreadsCountCondition.notify_one();
+    pauseThreadsCondition.wait(pausingThreadsCountLock, []{
+        return !safepointRequested.load(std::memory_order_relaxed);
+    });
+    pausingThreadsCount--;
 }
 
 void allowGC() {
@@ -206,7 +1233,9 @@ void allowGC() {
 
 void disallowGCAndPauseIfNeeded() {
     auto pausingThreadsCountLock = std::unique_lock<std::mutex>(pausingThreadsCountMutex);
-    pauseThreadsCondition.wait(pausingThreadsCountLock, []{ return !pauseThreads; });
+    pauseThreadsCondition.wait(pausingThreadsCountLock, []{
+        return !safepointRequested.load(std::memory_order_relaxed);
+    });
     pausingThreadsCount--;
     pausingThreadsCountCondition.notify_one();
 }
@@ -10,15 +10,84 @@
 #define Object_hpp
 
 #include "Engine.hpp"
+#include <atomic>
 
 #ifndef heapSize
-#define heapSize (512 * 1000 * 1000)  // 512 MB
+/// The maximum size of the heap unless another size is passed with @c --heap-size. 0 means the size of the physical
+/// memory.
+#define heapSize 0
 #endif
 
+#ifndef initialSemispaceSize
+/// The size of the semispaces when the program starts. They grow and shrink depending on the number of live objects
+/// but never below this size.
+#define initialSemispaceSize (8 * 1024 * 1024)  // 8 MB
+#endif
+
+#ifndef maximumNurserySize
+/// The size of the nursery of the generational collector, unless the heap is so small that it is limited to 1/32 of it.
+#define maximumNurserySize (4 * 1024 * 1024)  // 4 MB
+#endif
+
+#ifndef allocationBufferSize
+/// The size of the thread-local allocation buffers, from which objects are allocated without locking. The GC workers
+/// copy objects into buffers of the same size.
+#define allocationBufferSize (32 * 1024)  // 32 KB
+#endif
+
+#ifndef largeObjectSize
+/// Arrays of at least this size are allocated in the large object space, where the collector never moves them.
+#define largeObjectSize (64 * 1024)  // 64 KB
+#endif
+
+/// The garbage collectors available
+enum class Collector {
+    /// Copies all live objects between two semispaces
+    Copying,
+    /// Allocates new objects in a nursery, whose survivors are promoted to semispaces. The nursery is collected on its
+    /// own using a card table, which is maintained by @c writeBarrier, to find references from old objects.
+    Generational,
+    /// Marks the live objects and slides them to the start of a single space, which does not need memory to copy the
+    /// objects to and thus allows a heap twice as large within the same maximum heap size
+    Compacting,
+};
+
+/// The size of the address space reserved for the heap, up to which it grows. Set at startup by the @c --heap-size
+/// option.
+extern size_t maximumHeapSize;
+/// The garbage collector. It is selected at startup and must not be changed afterwards.
+extern Collector collector;
+/// The number of threads that copy objects in parallel during a collection. Set at startup by the @c --gc-threads
+/// option, one thread per core is used by default.
+extern unsigned int gcThreads;
+/// The largest number of threads that can be passed with @c --gc-threads.
+#define maximumGCThreads 1024
+
 /// This method is called during the initialization of the Engine.
 /// @warning Obviously, you should not call it anywhere else!
 void allocateHeap();
 
+/// Allocates the immortal space, which holds constants created while the program is loaded. It is laid out
+/// contiguously and its objects are never moved, marked or freed. @c objects objects with a value of @c bytes bytes in
+/// total can be allocated in it.
+void allocateImmortalSpace(size_t objects, size_t bytes);
+/// Allocates an object in the immortal space. @c size is the size of the value of an array, or the size of the instance
+/// of any other class including characters stored inline behind a string. The object must only reference objects in
+/// the immortal space.
+Object* newImmortalObject(Class *klass, size_t size);
+
+/// Set while a thread waits for all other threads to pause for the garbage collector.
+extern std::atomic<bool> safepointRequested;
+
+/// A safepoint, at which the calling thread pauses if the garbage collector wants to run. The engines poll at loop
+/// back-edges and when entering a function, which bounds the time until a thread pauses without polling the flag after
+/// every statement. The frame’s execution pointer must be up to date.
+inline void safepoint() {
+    if (safepointRequested.load(std::memory_order_relaxed)) {
+        pauseForGC();
+    }
+}
+
 template <typename T>
 inline void markByObjectVariableRecord(ObjectVariableRecord &record, Value *va, T &index) {
     switch (record.type) {
@@ -40,4 +109,32 @@ inline void markByObjectVariableRecord(ObjectVariableRecord &record, Value *va,
     }
 }
 
+/// Marks the object references in the variables @c va as described by @c map. Only variables whose index is less
+/// than @c limit are considered.
+inline void markByPointerMap(const PointerMap &map, Value *va, unsigned int limit = UINT32_MAX) {
+    for (unsigned int word = 0; word < map.words && word * 64 < limit; word++) {
+        uint64_t references = map.references[word];
+        uint64_t optionalReferences = map.optionalReferences[word];
+        if (limit - word * 64 < 64) {
+            uint64_t mask = (static_cast<uint64_t>(1) << (limit - word * 64)) - 1;
+            references &= mask;
+            optionalReferences &= mask;
+        }
+        for (; references != 0; references &= references - 1) {
+            mark(&va[word * 64 + __builtin_ctzll(references)].object);
+        }
+        for (; optionalReferences != 0; optionalReferences &= optionalReferences - 1) {
+            unsigned int index = word * 64 + __builtin_ctzll(optionalReferences);
+            if (va[index - 1].raw) {
+                mark(&va[index].object);
+            }
+        }
+    }
+    for (unsigned int i = 0; i < map.exceptionsCount; i++) {
+        if (map.exceptions[i].variableIndex < limit) {
+            markByObjectVariableRecord(map.exceptions[i], va, i);
+        }
+    }
+}
+
 #endif /* Object_hpp */
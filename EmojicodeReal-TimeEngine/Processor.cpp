@@ -7,13 +7,18 @@
 //
 
 #include "Processor.hpp"
+#include "ThreadedProcessor.hpp"
+#include "JIT.hpp"
+#include <algorithm>
 #include <cmath>
 #include <cstring>
 #include <functional>
 #include <thread>
+#include <vector>
 #include "../EmojicodeInstructions.h"
 #include "Thread.hpp"
 #include "Class.hpp"
+#include "Object.hpp"
 #include "EmojicodeList.h"
 #include "EmojicodeString.h"
 #include "EmojicodeDictionary.h"
@@ -30,8 +35,6 @@ static bool runBlock(Thread *thread) {
         Box garbage;
         produce(thread->consumeInstruction(), thread, &garbage.type);
 
-        pauseForGC();
-
         if (thread->currentStackFrame()->executionPointer == nullptr) {
             return true;
         }
@@ -40,14 +43,18 @@ static bool runBlock(Thread *thread) {
     return false;
 }
 
-static void runFunctionPointerBlock(Thread *thread, uint32_t length) {
-    EmojicodeInstruction *end = thread->currentStackFrame()->executionPointer + length;
+static void runFunctionPointerBlock(Thread *thread, const Block &block) {
+    safepoint();
+    if (executionEngine == ExecutionEngine::Threaded) {
+        runThreaded(thread, block);
+        return;
+    }
+
+    EmojicodeInstruction *end = thread->currentStackFrame()->executionPointer + block.instructionCount;
     while (thread->currentStackFrame()->executionPointer < end) {
         Box garbage;
         produce(thread->consumeInstruction(), thread, &garbage.type);
 
-        pauseForGC();
-
         if (thread->currentStackFrame()->executionPointer == nullptr) {
             return;
         }
@@ -76,8 +83,8 @@ void Box::unwrapOptional() const {
 }
 
 void loadCapture(Closure *c, Thread *thread) {
-    Value *cv = static_cast<Value *>(c->capturedVariables->value);
-    CaptureInformation *infop = static_cast<CaptureInformation *>(c->capturesInformation->value);
+    Value *cv = static_cast<Value *>(c->capturedVariables->value());
+    CaptureInformation *infop = static_cast<CaptureInformation *>(c->capturesInformation->value());
     for (int i = 0; i < c->captureCount; i++) {
         std::memcpy(thread->variableDestination(infop->destination), cv, infop->size * sizeof(Value));
         cv += infop->size;
@@ -87,41 +94,40 @@ void loadCapture(Closure *c, Thread *thread) {
 
 void executeCallableExtern(Object *callable, Value *args, Thread *thread, Value *destination) {
     if (callable->klass == CL_CAPTURED_FUNCTION_CALL) {
-        CapturedFunctionCall *cmc = static_cast<CapturedFunctionCall *>(callable->value);
+        CapturedFunctionCall *cmc = static_cast<CapturedFunctionCall *>(callable->value());
         Function *method = cmc->function;
 
         if (method->native) {
             auto sf = thread->reserveFrame(cmc->callee, method->frameSize, method, nullptr, nullptr);
-            std::memcpy(sf->variableDestination(0), args, method->argumentCount * sizeof(Value));
+            std::memcpy(sf->variableDestination(0), args, method->argumentsSize * sizeof(Value));
             thread->pushReservedFrame();
             method->handler(thread, destination);
         }
         else {
             auto sf = thread->reserveFrame(cmc->callee, method->frameSize, method, destination,
                                             method->block.instructions);
-            memcpy(sf->variableDestination(0), args, method->argumentCount * sizeof(Value));
+            memcpy(sf->variableDestination(0), args, method->argumentsSize * sizeof(Value));
             thread->pushReservedFrame();
 
-            runFunctionPointerBlock(thread, method->block.instructionCount);
+            runFunctionPointerBlock(thread, method->block);
         }
     }
     else {
-        Closure *c = static_cast<Closure *>(callable->value);
+        Closure *c = static_cast<Closure *>(callable->value());
 
-        // TODO: Won’t work with real vts
-        // TODO: WRONG nullptr
-        auto sf = thread->reserveFrame(c->thisContext, c->variableCount, nullptr, destination, c->block.instructions);
-        memcpy(sf->variableDestination(0), args, c->argumentCount * sizeof(Value));
+        auto sf = thread->reserveFrame(c->thisContext, c->variableCount, c->function, destination,
+                                       c->block.instructions);
+        memcpy(sf->variableDestination(0), args, c->function->argumentsSize * sizeof(Value));
         thread->pushReservedFrame();
 
         loadCapture(c, thread);
 
-        runFunctionPointerBlock(thread, c->block.instructionCount);
+        runFunctionPointerBlock(thread, c->block);
     }
     thread->popStack();
 }
 
-bool performInitializer(Class *klass, Function *initializer, Object *object, Thread *thread) {
+bool performInitializer(Class *klass, Function *initializer, Object *&object, Thread *thread) {
     Value returned = EmojicodeInteger(1);
     if (initializer->native) {
         thread->pushStack(object, initializer->frameSize, initializer->argumentCount, initializer,
@@ -161,7 +167,12 @@ void performFunction(Function *function, Value self, Thread *thread, Value *dest
     else {
         thread->pushStack(self, function->frameSize, function->argumentCount, function, destination,
                           function->block.instructions);
-        runFunctionPointerBlock(thread, function->block.instructionCount);
+        if (CompiledFunction compiled = compiledCode(function)) {
+            compiled(thread, thread->currentStackFrame());
+        }
+        else {
+            runFunctionPointerBlock(thread, function->block);
+        }
     }
     thread->popStack();
 }
@@ -263,6 +274,12 @@ void produce(EmojicodeInstruction coin, Thread *thread, Value *destination) {
             destination->raw = thread->consumeInstruction();
             produce(thread->consumeInstruction(), thread, destination + 1);
             return;
+        case INS_PACK_LIST: {
+            EmojicodeInstruction type = thread->consumeInstruction();
+            produce(thread->consumeInstruction(), thread, destination);
+            listPack(destination->object, type);
+            return;
+        }
         case INS_UNBOX: {
             Box box;
             EmojicodeInstruction size = thread->consumeInstruction();
@@ -274,6 +291,7 @@ void produce(EmojicodeInstruction coin, Thread *thread, Value *destination) {
             destination->value = thread->variableDestination(thread->consumeInstruction());
             return;
         case INS_GET_VT_REFERENCE_OBJECT: {
+            writeBarrier(thread->getThisObject());
             destination->value = thread->getThisObject()->variableDestination(thread->consumeInstruction());
             return;
         }
@@ -324,8 +342,21 @@ void produce(EmojicodeInstruction coin, Thread *thread, Value *destination) {
         }
         case INS_PRODUCE_WITH_OBJECT_DESTINATION: {
             EmojicodeInstruction index = thread->consumeInstruction();
-            Value *d = thread->getThisObject()->variableDestination(index);
-            produce(thread->consumeInstruction(), thread, d);
+            EmojicodeInstruction size = thread->consumeInstruction();
+            // The value is produced into a buffer as the garbage collector might move the object meanwhile. The
+            // buffer holds the current value, which is modified by instructions like INS_INCREMENT.
+            if (size == 1) {
+                Value value = *thread->getThisObject()->variableDestination(index);
+                produce(thread->consumeInstruction(), thread, &value);
+                *thread->getThisObject()->variableDestination(index) = value;
+            }
+            else {
+                Value *current = thread->getThisObject()->variableDestination(index);
+                std::vector<Value> values(current, current + size);
+                produce(thread->consumeInstruction(), thread, values.data());
+                std::copy(values.begin(), values.end(), thread->getThisObject()->variableDestination(index));
+            }
+            writeBarrier(thread->getThisObject());
             return;
         }
         case INS_PRODUCE_WITH_VT_DESTINATION: {
@@ -689,7 +720,7 @@ void produce(EmojicodeInstruction coin, Thread *thread, Value *destination) {
         }
         case 0x50: {
             Object *const &dico = thread->retain(newObject(CL_DICTIONARY));
-            dictionaryInit(thread);
+            dictionaryInit(static_cast<EmojicodeDictionary *>(dico->value()));
 
             EmojicodeInstruction *end = thread->currentStackFrame()->executionPointer + thread->consumeInstruction();
             while (thread->currentStackFrame()->executionPointer < end) {
@@ -708,10 +739,11 @@ void produce(EmojicodeInstruction coin, Thread *thread, Value *destination) {
             Object *const &list = thread->retain(newObject(CL_LIST));
 
             EmojicodeInstruction *end = thread->currentStackFrame()->executionPointer + thread->consumeInstruction();
+            EmojicodeInstruction packedType = thread->consumeInstruction();
             while (thread->currentStackFrame()->executionPointer < end) {
-                produce(thread->consumeInstruction(), thread,
-                        reinterpret_cast<Value *>(listAppendDestination(list, thread)));
+                produce(thread->consumeInstruction(), thread, listAppendDestination(list, thread));
             }
+            listPack(list, packedType);
 
             destination->object = list;
             thread->release(1);
@@ -720,30 +752,16 @@ void produce(EmojicodeInstruction coin, Thread *thread, Value *destination) {
         case 0x52: {
             EmojicodeInstruction stringCount = thread->consumeInstruction();
 
-            size_t bufferSize = 10;
             size_t length = 0;
-            auto characters = std::ref(thread->retain(newArray(bufferSize * sizeof(EmojicodeChar))));
+            auto buffer = thread->retainSlot(stringConcatenationBegin());
 
             for (int i = 0; i < stringCount; i++) {
                 Value v;
                 produce(thread->consumeInstruction(), thread, &v);
-                String *string = static_cast<String *>(v.object->value);
-                if (bufferSize - length < string->length) {
-                    bufferSize += static_cast<size_t>(string->length) - (bufferSize - length);
-                    thread->release(1);
-                    characters = std::ref(thread->retain(resizeArray(characters, bufferSize * sizeof(EmojicodeChar))));
-                }
-                EmojicodeChar *dest = static_cast<EmojicodeChar *>(characters.get()->value) + length;
-                std::memcpy(dest, string->characters->value, string->length * sizeof(EmojicodeChar));
-                length += string->length;
+                stringConcatenationAppend(thread, buffer, length, v.object);
             }
 
-            Object *object = newObject(CL_STRING);
-            String *string = static_cast<String *>(object->value);
-            string->length = length;
-            string->characters = characters;
-
-            destination->object = object;
+            destination->object = stringConcatenationEnd(*buffer, length);
             thread->release(1);
             return;
         }
@@ -804,6 +822,7 @@ void produce(EmojicodeInstruction coin, Thread *thread, Value *destination) {
                 if (runBlock(thread)) {
                     return;
                 }
+                safepoint();
                 thread->currentStackFrame()->executionPointer = beginPosition;
             }
             passBlock(thread);
@@ -853,17 +872,18 @@ void produce(EmojicodeInstruction coin, Thread *thread, Value *destination) {
 
             EmojicodeInstruction listObjectVariable = thread->consumeInstruction();
             *thread->variableDestination(listObjectVariable) = losm;
-            List *list = static_cast<List *>(losm.object->value);
+            List *list = static_cast<List *>(losm.object->value());
 
             EmojicodeInstruction *begin = thread->currentStackFrame()->executionPointer;
 
-            for (size_t i = 0; i < (list = static_cast<List *>(thread->getVariable(listObjectVariable).object->value))->count; i++) {
-                list->elements()[i].copyTo(thread->variableDestination(variable));
+            for (size_t i = 0; i < (list = static_cast<List *>(thread->getVariable(listObjectVariable).object->value()))->count; i++) {
+                list->element(i).copyTo(thread->variableDestination(variable));
                 reinterpret_cast<Box *>(thread->variableDestination(variable))->unwrapOptional();
 
                 if (runBlock(thread)) {
                     return;
                 }
+                safepoint();
                 thread->currentStackFrame()->executionPointer = begin;
             }
             passBlock(thread);
@@ -880,6 +900,7 @@ void produce(EmojicodeInstruction coin, Thread *thread, Value *destination) {
                 if (runBlock(thread)) {
                     return;
                 }
+                safepoint();
                 thread->currentStackFrame()->executionPointer = begin;
             }
             passBlock(thread);
@@ -890,19 +911,19 @@ void produce(EmojicodeInstruction coin, Thread *thread, Value *destination) {
             produce(thread->consumeInstruction(), thread, &sth);
             Object *callable = sth.object;
             if (callable->klass == CL_CAPTURED_FUNCTION_CALL) {
-                CapturedFunctionCall *cmc = static_cast<CapturedFunctionCall *>(callable->value);
+                CapturedFunctionCall *cmc = static_cast<CapturedFunctionCall *>(callable->value());
                 performFunction(cmc->function, cmc->callee, thread, destination);
                 return;
             }
             else {
-                Closure *c = static_cast<Closure *>(callable->value);
+                Closure *c = static_cast<Closure *>(callable->value());
                 // TODO: wrong nullptr
-                thread->pushStack(c->thisContext, c->variableCount, c->argumentCount, nullptr, destination,
+                thread->pushStack(c->thisContext, c->variableCount, c->argumentCount, c->function, destination,
                                   c->block.instructions);
 
                 loadCapture(c, thread);
 
-                runFunctionPointerBlock(thread, c->block.instructionCount);
+                runFunctionPointerBlock(thread, c->block);
                 thread->popStack();
                 return;
             }
@@ -910,12 +931,12 @@ void produce(EmojicodeInstruction coin, Thread *thread, Value *destination) {
         case INS_CLOSURE: {
             Object *const &closure = thread->retain(newObject(CL_CLOSURE));
 
-            Closure *c = static_cast<Closure *>(closure->value);
+            Closure *c = static_cast<Closure *>(closure->value());
 
+            c->function = thread->currentStackFrame()->function->closures[thread->consumeInstruction()];
             c->variableCount = thread->consumeInstruction();
-            c->block.instructionCount = thread->consumeInstruction();
-            c->block.instructions = thread->currentStackFrame()->executionPointer;
-            thread->currentStackFrame()->executionPointer += c->block.instructionCount;
+            c->block = c->function->block;
+            thread->currentStackFrame()->executionPointer += thread->consumeInstruction();
 
             EmojicodeInstruction argumentCount = thread->consumeInstruction();
             c->argumentCount = argumentCount;
@@ -923,15 +944,16 @@ void produce(EmojicodeInstruction coin, Thread *thread, Value *destination) {
             c->captureCount = thread->consumeInstruction();
             EmojicodeInteger size = thread->consumeInstruction();
 
-            Object *captures = newArray(sizeof(Value) * size);
-            c = static_cast<Closure *>(closure->value);
-            c->capturedVariables = captures;
             Object *infoo = newArray(sizeof(CaptureInformation) * c->captureCount);
-            c = static_cast<Closure *>(closure->value);
+            c = static_cast<Closure *>(closure->value());
             c->capturesInformation = infoo;
+            // The references are copied into the captured variables without allocating after they were allocated
+            Object *captures = newArray(sizeof(Value) * size);
+            c = static_cast<Closure *>(closure->value());
+            c->capturedVariables = captures;
 
-            Value *t = static_cast<Value *>(c->capturedVariables->value);
-            CaptureInformation *info = static_cast<CaptureInformation *>(c->capturesInformation->value);
+            Value *t = static_cast<Value *>(c->capturedVariables->value());
+            CaptureInformation *info = static_cast<CaptureInformation *>(c->capturesInformation->value());
             for (int i = 0; i < c->captureCount; i++) {
                 EmojicodeInteger index = thread->consumeInstruction();
                 EmojicodeInteger size = thread->consumeInstruction();
@@ -954,7 +976,7 @@ void produce(EmojicodeInstruction coin, Thread *thread, Value *destination) {
             Object *const &callee = thread->retain(sth.object);
 
             Object *cmco = newObject(CL_CAPTURED_FUNCTION_CALL);
-            CapturedFunctionCall *cmc = static_cast<CapturedFunctionCall *>(cmco->value);
+            CapturedFunctionCall *cmc = static_cast<CapturedFunctionCall *>(cmco->value());
 
             EmojicodeInstruction vti = thread->consumeInstruction();
             cmc->function = callee->klass->methodsVtable[vti];
@@ -968,7 +990,7 @@ void produce(EmojicodeInstruction coin, Thread *thread, Value *destination) {
             produce(thread->consumeInstruction(), thread, &sth);
 
             Object *cmco = newObject(CL_CAPTURED_FUNCTION_CALL);
-            CapturedFunctionCall *cmc = static_cast<CapturedFunctionCall *>(cmco->value);
+            CapturedFunctionCall *cmc = static_cast<CapturedFunctionCall *>(cmco->value());
 
             EmojicodeInstruction vti = thread->consumeInstruction();
             cmc->function = sth.klass->methodsVtable[vti];
@@ -981,7 +1003,7 @@ void produce(EmojicodeInstruction coin, Thread *thread, Value *destination) {
             produce(thread->consumeInstruction(), thread, &sth);
 
             Object *cmco = newObject(CL_CAPTURED_FUNCTION_CALL);
-            CapturedFunctionCall *cmc = static_cast<CapturedFunctionCall *>(cmco->value);
+            CapturedFunctionCall *cmc = static_cast<CapturedFunctionCall *>(cmco->value());
 
             EmojicodeInstruction vti = thread->consumeInstruction();
             cmc->function = functionTable[vti];
@@ -13,5 +13,7 @@
 
 void performFunction(Function *function, Value self, Thread *thread, Value *destination);
 void produce(EmojicodeInstruction coin, Thread *thread, Value *destination);
+/// Copies the variables captured by the closure into the current stack frame.
+void loadCapture(Closure *c, Thread *thread);
 
 #endif /* Processor_hpp */
@@ -10,8 +10,13 @@
 #include <dlfcn.h>
 #include <cstring>
 #include <cstdlib>
+#include <algorithm>
+#include <vector>
 #include "Engine.hpp"
 #include "Class.hpp"
+#include "Object.hpp"
+#include "ThreadedProcessor.hpp"
+#include "EmojicodeString.h"
 
 #ifdef DEBUG
 #define DEBUG_LOG(format, ...) printf(format "\n", ##__VA_ARGS__)
@@ -66,25 +71,160 @@ char* packageError() {
     return dlerror();
 }
 
+/// Builds a pointer map from @c records. Simple records and Condition records whose flag directly precedes the
+/// reference become bits, all other records and the records skipped by a ConditionalSkip record are kept as exceptions
+/// in their original order.
+template <typename Record>
+PointerMap buildPointerMap(const std::vector<Record> &records) {
+    std::vector<unsigned int> references;
+    std::vector<unsigned int> optionalReferences;
+    std::vector<ObjectVariableRecord> exceptions;
+    unsigned int variables = 0;
+    size_t skipEnd = 0;
+    for (size_t i = 0; i < records.size(); i++) {
+        const ObjectVariableRecord &record = records[i];
+        if (record.type == ObjectVariableType::ConditionalSkip) {
+            skipEnd = std::max(skipEnd, i + 1 + record.variableIndex);
+        }
+        if (i < skipEnd) {
+            exceptions.push_back(record);
+        }
+        else if (record.type == ObjectVariableType::Simple) {
+            references.push_back(record.variableIndex);
+            variables = std::max(variables, record.variableIndex + 1);
+        }
+        else if (record.type == ObjectVariableType::Condition && record.condition + 1 == record.variableIndex) {
+            optionalReferences.push_back(record.variableIndex);
+            variables = std::max(variables, record.variableIndex + 1);
+        }
+        else {
+            exceptions.push_back(record);
+        }
+    }
+
+    PointerMap map;
+    map.words = (variables + 63) / 64;
+    map.references = new uint64_t[2 * map.words]();
+    map.optionalReferences = map.references + map.words;
+    for (auto index : references) {
+        map.references[index / 64] |= static_cast<uint64_t>(1) << (index % 64);
+    }
+    for (auto index : optionalReferences) {
+        map.optionalReferences[index / 64] |= static_cast<uint64_t>(1) << (index % 64);
+    }
+    map.exceptionsCount = static_cast<unsigned int>(exceptions.size());
+    map.exceptions = new ObjectVariableRecord[exceptions.size()];
+    std::copy(exceptions.begin(), exceptions.end(), map.exceptions);
+    return map;
+}
+
+/// Builds a stack map for each range of instructions in which the same records of @c function apply. The records a
+/// ConditionalSkip record skips belong to the same variable and therefore always apply together with it.
+/// A record of a local variable starts at the end of the statement that assigns it, where the recursive engine’s
+/// execution pointer already is while the value is still being produced. Such records are therefore moved one
+/// instruction later and the engines keep the execution pointer past the first instruction of the current statement,
+/// which is done on @c records.
+static void buildStackMaps(Function *function, std::vector<FunctionObjectVariableRecord> &records) {
+    for (auto &record : records) {
+        if (record.from > 0) {
+            record.from++;
+        }
+    }
+    std::vector<int> boundaries = { 0 };
+    for (auto &record : records) {
+        boundaries.push_back(record.from);
+        boundaries.push_back(record.to + 1);
+    }
+    std::sort(boundaries.begin(), boundaries.end());
+    boundaries.erase(std::unique(boundaries.begin(), boundaries.end()), boundaries.end());
+
+    function->stackMaps = new StackMap[boundaries.size()];
+    function->stackMapsCount = 0;
+    std::vector<size_t> previousIndices;
+    for (int from : boundaries) {
+        std::vector<FunctionObjectVariableRecord> active;
+        std::vector<size_t> indices;
+        for (size_t i = 0; i < records.size(); i++) {
+            if (records[i].from <= from && from <= records[i].to) {
+                active.push_back(records[i]);
+                indices.push_back(i);
+            }
+        }
+        if (function->stackMapsCount > 0 && indices == previousIndices) {
+            continue;
+        }
+        function->stackMaps[function->stackMapsCount++] = StackMap { from, buildPointerMap(active) };
+        previousIndices = std::move(indices);
+    }
+}
+
+/// Reads the object variable records of a function or closure and builds its stack maps.
+static void readStackMaps(Function *function, FILE *in) {
+    std::vector<FunctionObjectVariableRecord> records(readUInt16(in));
+    for (auto &record : records) {
+        record.variableIndex = readUInt16(in);
+        record.condition = readUInt16(in);
+        record.type = static_cast<ObjectVariableType>(readUInt16(in));
+        record.from = readInstruction(in);
+        record.to = readInstruction(in);
+    }
+    buildStackMaps(function, records);
+
+    DEBUG_LOG("Read %zu object variable records into %u stack maps", records.size(), function->stackMapsCount);
+}
+
+/// Reads the object variable records of the instance variables of a class or of the variables captured by a closure.
+static PointerMap readPointerMap(FILE *in) {
+    std::vector<ObjectVariableRecord> records(readUInt16(in));
+    for (auto &record : records) {
+        record.variableIndex = readUInt16(in);
+        record.condition = readUInt16(in);
+        record.type = static_cast<ObjectVariableType>(readUInt16(in));
+    }
+    DEBUG_LOG("Read %zu object variable records", records.size());
+    return buildPointerMap(records);
+}
+
+/// Reads the closures created in the block of @c function. Their blocks are the parts of the block of @c function that
+/// INS_CLOSURE skips.
+static void readClosures(Function *function, FILE *in) {
+    uint16_t count = readUInt16(in);
+    function->closures = count > 0 ? new Function*[count] : nullptr;
+    for (uint16_t i = 0; i < count; i++) {
+        Function *closure = new Function();
+        closure->argumentCount = fgetc(in);
+        closure->argumentsSize = readUInt16(in);
+        closure->objectContext = fgetc(in);
+        closure->native = false;
+        readStackMaps(closure, in);
+        closure->frameSize = readUInt16(in);
+        EmojicodeInstruction bodyStart = readInstruction(in);
+        closure->block.instructions = function->block.instructions + bodyStart;
+        closure->block.instructionCount = readInstruction(in);
+        closure->block.code = function->block.code != nullptr ? function->block.code + bodyStart : nullptr;
+        closure->captures = readPointerMap(in);
+        closure->closures = function->closures;
+        closure->callCount = 0;
+        closure->compiled = nullptr;
+        function->closures[i] = closure;
+    }
+    DEBUG_LOG("Read %d closure(s)", count);
+}
+
 void readFunction(Function **table, FILE *in, FunctionFunctionPointer *linkingTable) {
     uint16_t vti = readUInt16(in);
 
     Function *function = static_cast<Function *>(malloc(sizeof(Function)));
     function->argumentCount = fgetc(in);
+    function->argumentsSize = readUInt16(in);
+    function->objectContext = fgetc(in);
+    function->callCount = 0;
+    function->compiled = nullptr;
+    function->closures = nullptr;
 
     DEBUG_LOG("*️⃣ Reading function with vti %d and takes %d argument(s)", vti, function->argumentCount);
 
-    function->objectVariableRecordsCount = readUInt16(in);
-    function->objectVariableRecords = new FunctionObjectVariableRecord[function->objectVariableRecordsCount];
-    for (int i = 0; i < function->objectVariableRecordsCount; i++) {
-        function->objectVariableRecords[i].variableIndex = readUInt16(in);
-        function->objectVariableRecords[i].condition = readUInt16(in);
-        function->objectVariableRecords[i].type = static_cast<ObjectVariableType>(readUInt16(in));
-        function->objectVariableRecords[i].from = readInstruction(in);
-        function->objectVariableRecords[i].to = readInstruction(in);
-    }
-
-    DEBUG_LOG("Read %d object variable records", function->objectVariableRecordsCount);
+    readStackMaps(function, in);
 
     function->frameSize = readUInt16(in);
     uint16_t native = readUInt16(in);
@@ -101,9 +241,12 @@ void readFunction(Function **table, FILE *in, FunctionFunctionPointer *linkingTa
         for (unsigned int i = 0; i < function->block.instructionCount; i++) {
             function->block.instructions[i] = readInstruction(in);
         }
+        function->block.code = executionEngine == ExecutionEngine::Threaded ? allocateCode(function->block) : nullptr;
 
         DEBUG_LOG("Read block with %d coins and %d local variable(s)", function->block.instructionCount,
                   function->frameSize);
+
+        readClosures(function, in);
     }
     table[vti] = function;
 }
@@ -236,15 +379,7 @@ void readPackage(FILE *in) {
         klass->valueSize = klass->superclass && klass->superclass->valueSize ? klass->superclass->valueSize : size;
         klass->size = klass->valueSize + instanceVariableCount * sizeof(Value);
 
-        klass->instanceVariableRecordsCount = readUInt16(in);
-        klass->instanceVariableRecords = new FunctionObjectVariableRecord[klass->instanceVariableRecordsCount];
-        for (int i = 0; i < klass->instanceVariableRecordsCount; i++) {
-            klass->instanceVariableRecords[i].variableIndex = readUInt16(in);
-            klass->instanceVariableRecords[i].condition = readUInt16(in);
-            klass->instanceVariableRecords[i].type = static_cast<ObjectVariableType>(readUInt16(in));
-        }
-
-        DEBUG_LOG("Read %d object variable records", klass->instanceVariableRecordsCount);
+        klass->pointerMap = readPointerMap(in);
     }
 
     for (int functionCount = readUInt16(in); functionCount; functionCount--) {
@@ -299,16 +434,33 @@ Function* readBytecode(FILE *in) {
 
     stringPoolCount = readUInt16(in);
     DEBUG_LOG("Reading string pool with %d strings", stringPoolCount);
+    std::vector<std::vector<EmojicodeChar>> strings(stringPoolCount);
+    size_t bytes = 0;
+    for (auto &characters : strings) {
+        characters.resize(readUInt16(in));
+        for (auto &character : characters) {
+            character = readEmojicodeChar(in);
+        }
+        bool latin1 = isLatin1(characters.data(), characters.size());
+        bytes += CL_STRING->size + characters.size() * (latin1 ? 1 : sizeof(EmojicodeChar));
+    }
+
+    // The characters of the strings are stored inline
+    allocateImmortalSpace(strings.size(), bytes);
     stringPool = new Object*[stringPoolCount];
     for (int i = 0; i < stringPoolCount; i++) {
-        Object *o = newObject(CL_STRING);
-        String *string = static_cast<String *>(o->value);
-
-        string->length = readUInt16(in);
-        string->characters = newArray(string->length * sizeof(EmojicodeChar));
-
-        for (int j = 0; j < string->length; j++) {
-            ((EmojicodeChar*)string->characters->value)[j] = readEmojicodeChar(in);
+        bool latin1 = isLatin1(strings[i].data(), strings[i].size());
+        size_t size = strings[i].size() * (latin1 ? 1 : sizeof(EmojicodeChar));
+        Object *o = newImmortalObject(CL_STRING, CL_STRING->size + size);
+        String *string = static_cast<String *>(o->value());
+
+        string->length = strings[i].size();
+        string->latin1 = latin1;
+        if (latin1) {
+            narrowCharacters(latin1Characters(string), strings[i].data(), strings[i].size());
+        }
+        else {
+            std::copy(strings[i].begin(), strings[i].end(), utf32Characters(string));
         }
 
         stringPool[i] = o;
@@ -9,13 +9,15 @@
 #include "Thread.hpp"
 #include <cstring>
 #include <cstdlib>
+#include <algorithm>
 #include <thread>
 #include <mutex>
 #include "Processor.hpp"
+#include "ThreadedProcessor.hpp"
 #include "Object.hpp"
 
 Thread *Thread::lastThread_ = nullptr;
-int Thread::threads_ = 0;
+std::atomic<int> Thread::threads_(0);
 std::mutex threadListMutex;
 
 Thread* Thread::lastThread() {
@@ -57,6 +59,19 @@ Thread::~Thread() {
     threads_--;
 
     free(stackLimit_);
+    free(operationStack_);
+}
+
+Operation* Thread::operationStackTop() {
+    if (!operationStack_) {
+        operationStack_ = static_cast<Operation *>(calloc(operationStackSize, sizeof(Operation)));
+        if (!operationStack_) {
+            error("Could not allocate operation stack!");
+        }
+        operationStackTop_ = operationStack_;
+        operationStackLimit_ = operationStack_ + operationStackSize;
+    }
+    return operationStackTop_;
 }
 
 StackFrame* Thread::reserveFrame(Value self, int size, Function *function, Value *destination,
@@ -121,13 +136,14 @@ EmojicodeInstruction Thread::consumeInstruction() {
 
 void Thread::markStack() {
     for (auto frame = futureStack_; frame < stackBottom_; frame = frame->returnFutureStack) {
-        unsigned int delta = frame->executionPointer ? frame->executionPointer - frame->function->block.instructions : 0;
-        for (unsigned int i = 0; i < frame->function->objectVariableRecordsCount; i++) {
-            auto record = frame->function->objectVariableRecords[i];
-            if (record.from <= delta && delta <= frame->function->objectVariableRecords[i].to
-                && record.variableIndex < frame->argPushIndex) {
-                markByObjectVariableRecord(record, frame->variableDestination(0), i);
-            }
+        if (frame->function->objectContext) {
+            mark(&frame->thisContext.object);
         }
+        Function *function = frame->function;
+        int delta = frame->executionPointer ? frame->executionPointer - function->block.instructions : 0;
+        // The map that applies is the last one starting at or before the execution pointer
+        StackMap *map = std::upper_bound(function->stackMaps, function->stackMaps + function->stackMapsCount, delta,
+                                         [](int delta, const StackMap &map) { return delta < map.from; }) - 1;
+        markByPointerMap(map->map, frame->variableDestination(0), frame->argPushIndex);
     }
 }
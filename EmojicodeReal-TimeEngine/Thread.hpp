@@ -10,8 +10,10 @@
 #define Thread_hpp
 
 #include "Engine.hpp"
+#include <atomic>
 
 class Thread;
+struct Operation;
 
 struct StackFrame {
     StackFrame *returnPointer;
@@ -68,16 +70,32 @@ public:
     Thread* threadBefore() const { return threadBefore_; }
 
     Object* const& retain(Object *object) { *retainPointer = object; return *(retainPointer++); }
+    /// Retains @c object like @c retain and returns its slot in the retain list, through which native code can replace
+    /// it, e.g. with a grown copy. The slot stays valid until it is released.
+    Object** retainSlot(Object *object) { *retainPointer = object; return retainPointer++; }
     void release(int n) { retainPointer -= n; }
 
     void markRetainList() const {
         for (Object **pointer = retainPointer - 1; pointer >= retainList; pointer--) mark(pointer);
     }
+    /// Calls @c writeBarrier for all retained objects as native code can store references into them without.
+    void rememberRetainList() const {
+        for (Object **pointer = retainPointer - 1; pointer >= retainList; pointer--) writeBarrier(*pointer);
+    }
+
+    /// Returns the first free record of the operation stack used by the threaded engine. The operation stack is
+    /// allocated the first time this method is called.
+    Operation* operationStackTop();
+    /// Sets the first free record of the operation stack. The threaded engine calls this method before it leaves
+    /// to native code, which might enter the engine again.
+    void setOperationStackTop(Operation *top) { operationStackTop_ = top; }
+    /// Returns the end of the operation stack. Records must not be pushed at or beyond this address.
+    Operation* operationStackLimit() const { return operationStackLimit_; }
 
     ~Thread();
 private:
     static Thread *lastThread_;
-    static int threads_;
+    static std::atomic<int> threads_;
 
     StackFrame *stackLimit_;
     StackFrame *stackBottom_;
@@ -89,6 +107,10 @@ private:
 
     Object *retainList[100];
     Object **retainPointer = retainList;
+
+    Operation *operationStack_ = nullptr;
+    Operation *operationStackTop_ = nullptr;
+    Operation *operationStackLimit_ = nullptr;
 };
 
 #endif /* Thread_hpp */
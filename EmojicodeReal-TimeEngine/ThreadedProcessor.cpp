@@ -0,0 +1,1246 @@
+//
+//  ThreadedProcessor.cpp
+//  Emojicode
+//
+
+#include "ThreadedProcessor.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <mutex>
+#include "../EmojicodeInstructions.h"
+#include "Processor.hpp"
+#include "Thread.hpp"
+#include "Class.hpp"
+#include "Object.hpp"
+#include "EmojicodeList.h"
+#include "EmojicodeString.h"
+#include "EmojicodeDictionary.h"
+#include "JIT.hpp"
+
+// The threaded engine relies on labels as values, which are supported by GCC and Clang.
+#pragma GCC diagnostic ignored "-Wpedantic"
+#ifdef __clang__
+#pragma clang diagnostic ignored "-Wgnu-label-as-value"
+#endif
+
+#define dispatchTableSize 256
+
+/// Dispatches the instruction at @c ip. Instructions that were not executed before are decoded first.
+#define DISPATCH() do { \
+    void *handler = __atomic_load_n(&ip->handler, __ATOMIC_ACQUIRE); \
+    if (reinterpret_cast<uintptr_t>(handler) < dispatchTableSize) goto decodeInstruction; \
+    ip++; \
+    goto *handler; \
+} while (0)
+/// Produces the next instruction into @c d. Execution continues at the resume label of the top record afterwards.
+#define PRODUCE(d) do { destination = (d); DISPATCH(); } while (0)
+/// Pushes a new record, which continues at @c label and remembers the current destination.
+#define PUSH(label) do { \
+    if (++top == limit) error("Your program triggerd a stack overflow!"); \
+    top->resume = (label); \
+    top->destination = destination; \
+} while (0)
+/// Finishes the current instruction by continuing the instruction that requested its value.
+#define CONTINUE() goto *top->resume
+/// Pops the record of the current instruction and continues the instruction that requested its value.
+#define POP_AND_CONTINUE() do { top--; goto *top->resume; } while (0)
+/// Executes the block following the execution pointer. Afterwards the resume label of the top record is used.
+#define ENTER_BLOCK() do { \
+    EmojicodeInteger blockLength = (ip++)->raw; \
+    PUSH(&&statement); \
+    top->pointer = ip + blockLength; \
+    goto statement; \
+} while (0)
+#define SKIP_BLOCK() do { EmojicodeInteger blockLength = (ip++)->raw; ip += blockLength; } while (0)
+
+#define UNARY_OPERATION(label, expression) \
+label: \
+    PUSH(&&label##Produced); \
+    PRODUCE(top->values); \
+label##Produced: { \
+    Value &a = top->values[0]; \
+    Value *d = top->destination; \
+    expression; \
+} \
+    POP_AND_CONTINUE();
+
+/// The instructions that combine two operands. Every operation also gets a handler that is used if both operands are
+/// simple, i.e. a stack variable or a constant, which reads them directly instead of dispatching them.
+#define BINARY_OPERATIONS(X) \
+    X(INS_EQUAL_PRIMITIVE, equalPrimitive, d->raw = a.raw == b.raw) \
+    X(INS_SUBTRACT_INTEGER, subtractInteger, d->raw = a.raw - b.raw) \
+    X(INS_ADD_INTEGER, addInteger, d->raw = a.raw + b.raw) \
+    X(INS_MULTIPLY_INTEGER, multiplyInteger, d->raw = a.raw * b.raw) \
+    X(INS_DIVIDE_INTEGER, divideInteger, d->raw = a.raw / b.raw) \
+    X(INS_REMAINDER_INTEGER, remainderInteger, d->raw = a.raw % b.raw) \
+    X(INS_OR_BOOLEAN, orBoolean, d->raw = a.raw || b.raw) \
+    X(INS_AND_BOOLEAN, andBoolean, d->raw = a.raw && b.raw) \
+    X(INS_LESS_INTEGER, lessInteger, d->raw = a.raw < b.raw) \
+    X(INS_GREATER_INTEGER, greaterInteger, d->raw = a.raw > b.raw) \
+    X(INS_GREATER_OR_EQUAL_INTEGER, greaterOrEqualInteger, d->raw = a.raw >= b.raw) \
+    X(INS_LESS_OR_EQUAL_INTEGER, lessOrEqualInteger, d->raw = a.raw <= b.raw) \
+    X(INS_SAME_OBJECT, sameObject, d->raw = a.object == b.object) \
+    X(INS_EQUAL_DOUBLE, equalDouble, d->raw = a.doubl == b.doubl) \
+    X(INS_SUBTRACT_DOUBLE, subtractDouble, d->doubl = a.doubl - b.doubl) \
+    X(INS_ADD_DOUBLE, addDouble, d->doubl = a.doubl + b.doubl) \
+    X(INS_MULTIPLY_DOUBLE, multiplyDouble, d->doubl = a.doubl * b.doubl) \
+    X(INS_DIVIDE_DOUBLE, divideDouble, d->doubl = a.doubl / b.doubl) \
+    X(INS_LESS_DOUBLE, lessDouble, d->raw = a.doubl < b.doubl) \
+    X(INS_GREATER_DOUBLE, greaterDouble, d->raw = a.doubl > b.doubl) \
+    X(INS_LESS_OR_EQUAL_DOUBLE, lessOrEqualDouble, d->raw = a.doubl <= b.doubl) \
+    X(INS_GREATER_OR_EQUAL_DOUBLE, greaterOrEqualDouble, d->raw = a.doubl >= b.doubl) \
+    X(INS_REMAINDER_DOUBLE, remainderDouble, d->doubl = fmod(a.doubl, b.doubl)) \
+    X(INS_BINARY_AND_INTEGER, binaryAndInteger, d->raw = a.raw & b.raw) \
+    X(INS_BINARY_OR_INTEGER, binaryOrInteger, d->raw = a.raw | b.raw) \
+    X(INS_BINARY_XOR_INTEGER, binaryXorInteger, d->raw = a.raw ^ b.raw) \
+    X(INS_SHIFT_LEFT_INTEGER, shiftLeftInteger, d->raw = a.raw << b.raw) \
+    X(INS_SHIFT_RIGHT_INTEGER, shiftRightInteger, d->raw = a.raw >> b.raw)
+
+#define BINARY_OPERATION(coin, label, expression) \
+label: \
+    PUSH(&&label##Left); \
+    PRODUCE(top->values); \
+label##Left: \
+    top->resume = &&label##Right; \
+    PRODUCE(top->values + 1); \
+label##Right: { \
+    Value &a = top->values[0]; \
+    Value &b = top->values[1]; \
+    Value *d = top->destination; \
+    expression; \
+} \
+    POP_AND_CONTINUE(); \
+label##Simple: { \
+    Value a, b; \
+    SIMPLE_OPERAND(a); \
+    SIMPLE_OPERAND(b); \
+    Value *d = destination; \
+    expression; \
+} \
+    CONTINUE();
+
+#define REGISTER_BINARY_OPERATION(coin, label, expression) \
+    dispatchTable[coin] = &&label; \
+    simpleOperandsDispatchTable[coin] = &&label##Simple;
+
+/// Reads a simple operand, which was decoded with the binary operation, into @c v.
+#define SIMPLE_OPERAND(v) do { \
+    if (ip->handler == &&copySingleStack) { \
+        v = *frame->variableDestination(ip[1].raw); \
+        ip += 2; \
+    } \
+    else { \
+        v.raw = ip[1].raw; \
+        ip += ip->handler == &&getDouble ? 4 : (ip->handler == &&get64Integer ? 3 : 2); \
+    } \
+} while (0)
+
+static void *dispatchTable[dispatchTableSize];
+static void *simpleOperandsDispatchTable[dispatchTableSize];
+/// The handlers of method and protocol dispatch sites whose inline cache was created
+static void *cachedDispatchHandlers[2];
+
+double decodeDouble(const EmojicodeInstruction *instruction) {
+    EmojicodeInteger scale = ((EmojicodeInteger)instruction[0] << 32) ^ instruction[1];
+    EmojicodeInteger exp = instruction[2];
+
+    return ldexp(static_cast<double>(scale)/PORTABLE_INTLEAST64_MAX, static_cast<int>(exp));
+}
+
+/// Returns the number of words occupied by @c instruction if it is a simple operand or 0 otherwise.
+static int simpleOperandSize(const EmojicodeInstruction *instruction) {
+    switch (instruction[0]) {
+        case INS_COPY_SINGLE_STACK:
+        case INS_GET_32_INTEGER:
+            return 2;
+        case INS_GET_64_INTEGER:
+            return 3;
+        case INS_GET_DOUBLE:
+            return 4;
+        default:
+            return 0;
+    }
+}
+
+/// Held while instructions are decoded or inline caches are created, so that the operands of an instruction are only
+/// written once, by one thread, before the handler is published. Threads that read the handler with acquire semantics
+/// therefore never read operands that are being written.
+static std::mutex decodeMutex;
+
+/// Decodes the instruction at @c code, which was copied from @c instruction, in place unless it was decoded already.
+/// decodeMutex must be held.
+///
+/// Only the operands directly following the instruction are decoded as the position of operands following a nested
+/// instruction is unknown until it was executed. The operands are always decoded from the original bytecode.
+static void decodeLocked(Code *code, const EmojicodeInstruction *instruction) {
+    if (reinterpret_cast<uintptr_t>(__atomic_load_n(&code->handler, __ATOMIC_RELAXED)) >= dispatchTableSize) {
+        return;  // Another thread decoded the instruction in the meantime
+    }
+    EmojicodeInstruction coin = instruction[0];
+    switch (coin) {
+        case INS_GET_32_INTEGER:
+            code[1].raw = static_cast<EmojicodeInteger>(instruction[1]) - INT32_MAX;
+            break;
+        case INS_GET_64_INTEGER:
+            code[1].raw = static_cast<EmojicodeInteger>(instruction[1]) << 32 | instruction[2];
+            break;
+        case INS_GET_DOUBLE:
+            code[1].doubl = decodeDouble(instruction + 1);
+            break;
+        case INS_GET_CLASS_FROM_INDEX:
+            code[1].klass = classTable[instruction[1]];
+            break;
+        case INS_GET_STRING_POOL:
+            code[1].string = stringPool + instruction[1];
+            break;
+        case INS_INIT_VT:
+        case INS_CALL_FUNCTION:
+            code[1].function = functionTable[instruction[1]];
+            break;
+        case INS_IF:
+        case 0x50:
+        case 0x51:
+            code[1].pointer = code + 2 + instruction[1];
+            break;
+    }
+    void *handler = dispatchTable[coin < dispatchTableSize ? coin : 0];  // 0 is not a valid instruction
+    if (coin < dispatchTableSize && simpleOperandsDispatchTable[coin]) {
+        int leftSize = simpleOperandSize(instruction + 1);
+        if (leftSize > 0 && simpleOperandSize(instruction + 1 + leftSize) > 0) {
+            decodeLocked(code + 1, instruction + 1);
+            decodeLocked(code + 1 + leftSize, instruction + 1 + leftSize);
+            handler = simpleOperandsDispatchTable[coin];
+        }
+    }
+    __atomic_store_n(&code->handler, handler, __ATOMIC_RELEASE);
+}
+
+static void decode(Code *code, const EmojicodeInstruction *instruction) {
+    std::lock_guard<std::mutex> lock(decodeMutex);
+    decodeLocked(code, instruction);
+}
+
+bool inlineCacheStatistics = false;
+
+static std::mutex inlineCachesMutex;
+static InlineCache *lastInlineCache = nullptr;
+
+static InlineCache* newInlineCache(bool protocol, EmojicodeInstruction protocolIndex, EmojicodeInstruction vti) {
+    auto cache = new InlineCache();
+    cache->protocol = protocol;
+    cache->protocolIndex = protocolIndex;
+    cache->vti = vti;
+
+    std::lock_guard<std::mutex> lock(inlineCachesMutex);
+    cache->next = lastInlineCache;
+    lastInlineCache = cache;
+    return cache;
+}
+
+/// Stores a new inline cache in @c operand and makes the dispatch site @c site use @c cachedHandler, unless another
+/// thread did so already.
+static void installInlineCache(Code *site, Code *operand, void *cachedHandler, bool protocol,
+                               EmojicodeInstruction protocolIndex, EmojicodeInstruction vti) {
+    std::lock_guard<std::mutex> lock(decodeMutex);
+    if (__atomic_load_n(&site->handler, __ATOMIC_RELAXED) == cachedHandler) {
+        return;
+    }
+    operand->cache = newInlineCache(protocol, protocolIndex, vti);
+    __atomic_store_n(&site->handler, cachedHandler, __ATOMIC_RELEASE);
+}
+
+/// Returns the function cached for @c type or @c nullptr if @c type is not in the cache.
+static inline Function* cachedFunction(InlineCache *cache, uintptr_t type) {
+    unsigned int count = cache->count.load(std::memory_order_acquire);
+    for (unsigned int i = 0; i < count; i++) {
+        if (cache->entries[i].type == type) {
+            if (inlineCacheStatistics) cache->hits.fetch_add(1, std::memory_order_relaxed);
+            return cache->entries[i].function;
+        }
+    }
+    if (inlineCacheStatistics) cache->misses.fetch_add(1, std::memory_order_relaxed);
+    return nullptr;
+}
+
+static void cacheFunction(InlineCache *cache, uintptr_t type, Function *function) {
+    if (cache->count.load(std::memory_order_relaxed) == inlineCacheSize) {
+        return;  // The site is megamorphic
+    }
+
+    std::lock_guard<std::mutex> lock(inlineCachesMutex);
+    unsigned int count = cache->count.load(std::memory_order_relaxed);
+    for (unsigned int i = 0; i < count; i++) {
+        if (cache->entries[i].type == type) {
+            return;  // Another thread cached the function in the meantime
+        }
+    }
+    if (count < inlineCacheSize) {
+        cache->entries[count].type = type;
+        cache->entries[count].function = function;
+        cache->count.store(count + 1, std::memory_order_release);
+    }
+}
+
+Function* lookUpMethod(InlineCache *cache, Class *klass) {
+    Function *function = cachedFunction(cache, reinterpret_cast<uintptr_t>(klass));
+    if (function == nullptr) {
+        function = klass->methodsVtable[cache->vti];
+        cacheFunction(cache, reinterpret_cast<uintptr_t>(klass), function);
+    }
+    return function;
+}
+
+Function* lookUpProtocolMethod(InlineCache *cache, Class *klass) {
+    Function *function = cachedFunction(cache, reinterpret_cast<uintptr_t>(klass));
+    if (function == nullptr) {
+        function = klass->protocolTable.dispatch(cache->protocolIndex, cache->vti);
+        cacheFunction(cache, reinterpret_cast<uintptr_t>(klass), function);
+    }
+    return function;
+}
+
+/// Looks up the protocol method for the value type with the type id @c type. Type ids are small integers and can
+/// therefore not be confused with class pointers.
+Function* lookUpProtocolMethod(InlineCache *cache, EmojicodeInteger type) {
+    Function *function = cachedFunction(cache, type);
+    if (function == nullptr) {
+        function = protocolDispatchTableTable[type - protocolDTTOffset].dispatch(cache->protocolIndex, cache->vti);
+        cacheFunction(cache, type, function);
+    }
+    return function;
+}
+
+InlineCache* inlineCacheAt(const Block &block, const EmojicodeInstruction *site, const EmojicodeInstruction *operand) {
+    void *handler = __atomic_load_n(&block.code[site - block.instructions].handler, __ATOMIC_ACQUIRE);
+    if (handler != cachedDispatchHandlers[0] && handler != cachedDispatchHandlers[1]) {
+        return nullptr;
+    }
+    return block.code[operand - block.instructions].cache;
+}
+
+void printInlineCacheStatistics() {
+    std::lock_guard<std::mutex> lock(inlineCachesMutex);
+    fprintf(stderr, "Inline cache statistics (most recently created site first):\n");
+    for (InlineCache *cache = lastInlineCache; cache != nullptr; cache = cache->next) {
+        uint_fast64_t hits = cache->hits.load(std::memory_order_relaxed);
+        uint_fast64_t misses = cache->misses.load(std::memory_order_relaxed);
+        unsigned int count = cache->count.load(std::memory_order_relaxed);
+        if (cache->protocol) {
+            fprintf(stderr, "  protocol %u method %u: ", cache->protocolIndex, cache->vti);
+        }
+        else {
+            fprintf(stderr, "  method %u: ", cache->vti);
+        }
+        fprintf(stderr, "%lu hits, %lu misses (%.1f%% hit rate), %u %s%s\n", static_cast<unsigned long>(hits),
+                static_cast<unsigned long>(misses), hits + misses ? 100.0 * hits / (hits + misses) : 0.0,
+                count, count == 1 ? "type" : "types", count == inlineCacheSize ? ", megamorphic" : "");
+    }
+}
+
+/// Returns the number of operation records reserved below the record of an object variable destination to hold
+/// @c size values, or 0 if they fit into the record’s @c values.
+static inline EmojicodeInteger reservedOperations(EmojicodeInteger size) {
+    const EmojicodeInteger valuesPerOperation = sizeof(Operation) / sizeof(Value);
+    return size > 5 ? (size + valuesPerOperation - 1) / valuesPerOperation : 0;
+}
+
+static void execute(Thread *thread, const Block *block) {
+    if (thread == nullptr) {
+        for (auto &label : dispatchTable) label = &&illegalInstruction;
+        dispatchTable[INS_DISPATCH_METHOD] = &&dispatchMethod;
+        dispatchTable[INS_DISPATCH_TYPE_METHOD] = &&dispatchTypeMethod;
+        dispatchTable[INS_DISPATCH_PROTOCOL] = &&dispatchProtocol;
+        dispatchTable[INS_NEW_OBJECT] = &&newObjectInstruction;
+        dispatchTable[INS_PRODUCE_TO_AND_GET_VT_REFERENCE] = &&produceToAndGetVtReference;
+        dispatchTable[INS_INIT_VT] = &&initVt;
+        dispatchTable[INS_DISPATCH_SUPER] = &&dispatchSuper;
+        dispatchTable[INS_CALL_CONTEXTED_FUNCTION] = &&callContextedFunction;
+        dispatchTable[INS_CALL_FUNCTION] = &&callFunction;
+        dispatchTable[INS_SIMPLE_OPTIONAL_PRODUCE] = &&simpleOptionalProduce;
+        dispatchTable[INS_BOX_TO_SIMPLE_OPTIONAL_PRODUCE] = &&boxToSimpleOptionalProduce;
+        dispatchTable[INS_SIMPLE_OPTIONAL_TO_BOX] = &&simpleOptionalToBox;
+        dispatchTable[INS_BOX_PRODUCE] = &&boxProduce;
+        dispatchTable[INS_PACK_LIST] = &&packList;
+        dispatchTable[INS_UNBOX] = &&unbox;
+        dispatchTable[INS_GET_VT_REFERENCE_STACK] = &&getVtReferenceStack;
+        dispatchTable[INS_GET_VT_REFERENCE_OBJECT] = &&getVtReferenceObject;
+        dispatchTable[INS_GET_VT_REFERENCE_VT] = &&getVtReferenceVt;
+        dispatchTable[INS_GET_CLASS_FROM_INSTANCE] = &&getClassFromInstance;
+        dispatchTable[INS_GET_CLASS_FROM_INDEX] = &&getClassFromIndex;
+        dispatchTable[INS_GET_STRING_POOL] = &&getStringPool;
+        dispatchTable[INS_GET_TRUE] = &&getTrue;
+        dispatchTable[INS_GET_FALSE] = &&getFalse;
+        dispatchTable[INS_GET_32_INTEGER] = &&get32Integer;
+        dispatchTable[INS_GET_64_INTEGER] = &&get64Integer;
+        dispatchTable[INS_GET_DOUBLE] = &&getDouble;
+        dispatchTable[INS_GET_SYMBOL] = &&getSymbol;
+        dispatchTable[INS_GET_NOTHINGNESS] = &&getNothingness;
+        dispatchTable[INS_PRODUCE_WITH_STACK_DESTINATION] = &&produceWithStackDestination;
+        dispatchTable[INS_PRODUCE_WITH_OBJECT_DESTINATION] = &&produceWithObjectDestination;
+        dispatchTable[INS_PRODUCE_WITH_VT_DESTINATION] = &&produceWithVtDestination;
+        dispatchTable[INS_INCREMENT] = &&increment;
+        dispatchTable[INS_DECREMENT] = &&decrement;
+        dispatchTable[INS_COPY_SINGLE_STACK] = &&copySingleStack;
+        dispatchTable[INS_COPY_WITH_SIZE_STACK] = &&copyWithSizeStack;
+        dispatchTable[INS_COPY_SINGLE_OBJECT] = &&copySingleObject;
+        dispatchTable[INS_COPY_WITH_SIZE_OBJECT] = &&copyWithSizeObject;
+        dispatchTable[INS_COPY_SINGLE_VT] = &&copySingleVt;
+        dispatchTable[INS_COPY_WITH_SIZE_VT] = &&copyWithSizeVt;
+        dispatchTable[INS_COPY_REFERENCE] = &&copyReference;
+        dispatchTable[INS_INVERT_BOOLEAN] = &&invertBoolean;
+        dispatchTable[INS_IS_NOTHINGNESS] = &&isNothingness;
+        dispatchTable[INS_INT_TO_DOUBLE] = &&intToDouble;
+        dispatchTable[INS_UNWRAP_SIMPLE_OPTIONAL] = &&unwrapSimpleOptional;
+        dispatchTable[INS_UNWRAP_BOX_OPTIONAL] = &&unwrapBoxOptional;
+        dispatchTable[INS_OPTIONAL_DISPATCH_METHOD] = &&optionalDispatchMethod;
+        dispatchTable[INS_CONDITIONAL_PRODUCE_BOX] = &&conditionalProduceBox;
+        dispatchTable[INS_CONDITIONAL_PRODUCE_SIMPLE_OPTIONAL] = &&conditionalProduceSimpleOptional;
+        dispatchTable[INS_GET_THIS] = &&getThis;
+        dispatchTable[INS_SUPER_INITIALIZER] = &&superInitializer;
+        dispatchTable[INS_DOWNCAST_TO_CLASS] = &&downcastToClass;
+        dispatchTable[INS_CAST_TO_CLASS] = &&castToClass;
+        dispatchTable[INS_CAST_TO_PROTOCOL] = &&castToProtocol;
+        dispatchTable[INS_CAST_TO_VALUE_TYPE] = &&castToValueType;
+        dispatchTable[0x50] = &&dictionaryLiteral;
+        dispatchTable[0x51] = &&listLiteral;
+        dispatchTable[0x52] = &&stringConcatenation;
+        dispatchTable[INS_BINARY_NOT_INTEGER] = &&binaryNotInteger;
+        dispatchTable[INS_RETURN] = &&returnInstruction;
+        dispatchTable[INS_REPEAT_WHILE] = &&repeatWhile;
+        dispatchTable[INS_IF] = &&ifInstruction;
+        dispatchTable[0x65] = &&forInList;
+        dispatchTable[0x66] = &&forInRange;
+        dispatchTable[INS_EXECUTE_CALLABLE] = &&executeCallable;
+        dispatchTable[INS_CLOSURE] = &&closureInstruction;
+        dispatchTable[INS_CAPTURE_METHOD] = &&captureMethod;
+        dispatchTable[INS_CAPTURE_TYPE_METHOD] = &&captureTypeMethod;
+        dispatchTable[INS_CAPTURE_CONTEXTED_FUNCTION] = &&captureContextedFunction;
+        BINARY_OPERATIONS(REGISTER_BINARY_OPERATION)
+        cachedDispatchHandlers[0] = &&dispatchMethodCached;
+        cachedDispatchHandlers[1] = &&dispatchProtocolCached;
+        return;
+    }
+
+    Operation *const base = thread->operationStackTop();
+    Operation *const limit = thread->operationStackLimit();
+    Operation *top = base;
+    Operation *currentCall = base;
+    StackFrame *frame = thread->currentStackFrame();
+    Value *destination = nullptr;
+
+    // The decoded code and the bytecode of the function or closure that is executed
+    Code *code = block->code;
+    EmojicodeInstruction *instructions = block->instructions;
+    Code *ip = code;
+
+    // Registers used to set up a call at invoke
+    Function *function;
+    Value self;
+    void *enter;
+    Block body;
+
+    top->resume = &&finished;
+    PUSH(&&statement);
+    top->pointer = ip + block->instructionCount;
+
+statement:
+    if (ip < top->pointer) {
+        frame->executionPointer = instructions + (ip - code) + 1;
+        PRODUCE(top->values);
+    }
+    POP_AND_CONTINUE();
+
+initializerStatement:
+    if (!currentCall->destination->raw) {
+        top = currentCall;
+        CONTINUE();
+    }
+    if (ip < top->pointer) {
+        frame->executionPointer = instructions + (ip - code) + 1;
+        PRODUCE(top->values);
+    }
+    POP_AND_CONTINUE();
+
+invokeFunction:
+    enter = &&enterFunction;
+invoke:
+    PUSH(&&argumentProduced);
+    top->function = function;
+    top->enter = enter;
+    top->frame = thread->reserveFrame(self, function->frameSize, function, destination,
+                                      function->native ? nullptr : function->block.instructions);
+    top->count = function->argumentCount;
+produceArguments:
+    top->frame->argPushIndex = 0;
+    goto nextArgument;
+argumentProduced:
+    top->frame->argPushIndex += top->size;
+nextArgument:
+    if (top->count > 0) {
+        top->count--;
+        top->size = (ip++)->raw;
+        PRODUCE(top->frame->variableDestination(0) + top->frame->argPushIndex);
+    }
+    thread->pushReservedFrame();
+    goto *top->enter;
+
+enterFunction:
+    if (top->function->native) {
+        thread->setOperationStackTop(top + 1);
+        top->function->handler(thread, top->destination);
+        thread->popStack();
+        POP_AND_CONTINUE();
+    }
+    if (CompiledFunction compiled = compiledCode(top->function)) {
+        thread->setOperationStackTop(top + 1);
+        compiled(thread, thread->currentStackFrame());
+        thread->popStack();
+        POP_AND_CONTINUE();
+    }
+    enter = &&statement;
+    body = top->function->block;
+    goto enterBody;
+enterInitializer:
+    if (top->function->native) {
+        thread->setOperationStackTop(top + 1);
+        top->function->handler(thread, top->destination);
+        thread->popStack();
+        POP_AND_CONTINUE();
+    }
+    enter = &&initializerStatement;
+    body = top->function->block;
+    goto enterBody;
+enterClosure:
+    loadCapture(top->closure, thread);
+    enter = &&statement;
+    body = top->closure->block;
+enterBody:
+    safepoint();
+    top->pointer = ip;
+    top->code = code;
+    top->instructions = instructions;
+    top->call = currentCall;
+    top->resume = &&returned;
+    currentCall = top;
+    frame = thread->currentStackFrame();
+    ip = code = body.code;
+    instructions = body.instructions;
+    PUSH(enter);
+    top->pointer = ip + body.instructionCount;
+    goto *enter;
+returned:
+    thread->popStack();
+    frame = thread->currentStackFrame();
+    ip = top->pointer;
+    code = top->code;
+    instructions = top->instructions;
+    currentCall = top->call;
+    POP_AND_CONTINUE();
+
+decodeInstruction:
+    decode(ip, instructions + (ip - code));
+    DISPATCH();
+
+popOperation:
+    POP_AND_CONTINUE();
+
+dispatchMethod:
+    PUSH(&&dispatchMethodCallee);
+    top->pointer = ip - 1;
+    PRODUCE(top->values);
+dispatchMethodCallee:
+    installInlineCache(top->pointer, ip, &&dispatchMethodCached, false, 0, instructions[ip - code]);
+    goto dispatchMethodLookUp;
+dispatchMethodCached:
+    PUSH(&&dispatchMethodLookUp);
+    PRODUCE(top->values);
+dispatchMethodLookUp:
+    self = top->values[0];
+    function = lookUpMethod((ip++)->cache, self.object->klass);
+    destination = top->destination;
+    top--;
+    goto invokeFunction;
+
+dispatchTypeMethod:
+    PUSH(&&dispatchTypeMethodCallee);
+    PRODUCE(top->values);
+dispatchTypeMethodCallee:
+    self = top->values[0];
+    function = self.klass->methodsVtable[(ip++)->raw];
+    destination = top->destination;
+    top--;
+    goto invokeFunction;
+
+dispatchProtocol:
+    PUSH(&&dispatchProtocolCallee);
+    top->pointer = ip - 1;
+    PRODUCE(top->values);
+dispatchProtocolCallee:
+    installInlineCache(top->pointer, ip, &&dispatchProtocolCached, true, instructions[ip - code],
+                       instructions[ip + 1 - code]);
+    goto dispatchProtocolLookUp;
+dispatchProtocolCached:
+    PUSH(&&dispatchProtocolLookUp);
+    PRODUCE(top->values);
+dispatchProtocolLookUp: {
+    Value sth = top->values[0];
+    InlineCache *cache = ip->cache;
+    ip += 2;
+
+    auto type = sth.value[0].raw;
+    if (type == T_OBJECT) {
+        self = sth.value[1];
+        function = lookUpProtocolMethod(cache, self.object->klass);
+    }
+    else {
+        self = Value(sth.value + 1);
+        function = lookUpProtocolMethod(cache, type);
+    }
+    destination = top->destination;
+    top--;
+    goto invokeFunction;
+}
+
+newObjectInstruction:
+    PUSH(&&newObjectClass);
+    PRODUCE(top->values);
+newObjectClass: {
+    Class *klass = top->values[0].klass;
+    top->values[1].object = newObject(klass);
+    top->values[0].raw = 1;
+    top->resume = &&newObjectInitialized;
+    function = klass->initializersVtable[(ip++)->raw];
+    self = top->values[1];
+    destination = top->values;
+    enter = &&enterInitializer;
+    goto invoke;
+}
+newObjectInitialized:
+    // The initializer’s frame was popped but is still intact. It holds the object, which might have been moved by the GC.
+    top->destination->object = (top + 1)->frame->thisContext.object;
+    POP_AND_CONTINUE();
+
+superInitializer:
+    PUSH(&&superInitializerClass);
+    PRODUCE(top->values);
+superInitializerClass: {
+    Class *klass = top->values[0].klass;
+    top->values[0].raw = 1;
+    top->resume = &&popOperation;
+    function = klass->initializersVtable[(ip++)->raw];
+    self = Value(frame->thisContext.object);
+    destination = top->values;
+    enter = &&enterInitializer;
+    goto invoke;
+}
+
+produceToAndGetVtReference:
+    PUSH(&&produceToAndGetVtReferenceProduced);
+    top->values[0].value = frame->variableDestination((ip++)->raw);
+    PRODUCE(top->values[0].value);
+produceToAndGetVtReferenceProduced:
+    top->destination->value = top->values[0].value;
+    POP_AND_CONTINUE();
+
+initVt:
+    function = (ip++)->function;
+    self = Value(destination);
+    destination = nullptr;
+    goto invokeFunction;
+
+dispatchSuper:
+    PUSH(&&dispatchSuperClass);
+    PRODUCE(top->values);
+dispatchSuperClass:
+    function = top->values[0].klass->methodsVtable[(ip++)->raw];
+    self = frame->thisContext;
+    destination = top->destination;
+    top--;
+    goto invokeFunction;
+
+callContextedFunction:
+    PUSH(&&callContextedFunctionCallee);
+    PRODUCE(top->values);
+callContextedFunctionCallee:
+    self = top->values[0];
+    function = functionTable[(ip++)->raw];
+    destination = top->destination;
+    top--;
+    goto invokeFunction;
+
+callFunction:
+    function = (ip++)->function;
+    self.raw = 0;
+    goto invokeFunction;
+
+simpleOptionalProduce:
+    destination->raw = 1;
+    PRODUCE(destination + 1);
+
+boxToSimpleOptionalProduce:
+    PUSH(&&boxToSimpleOptionalProduceBox);
+    top->size = (ip++)->raw;
+    PRODUCE(top->values);
+boxToSimpleOptionalProduceBox:
+    if (top->values[0].raw != T_NOTHINGNESS) std::memcpy(top->destination, top->values, top->size * sizeof(Value));
+    else top->destination->raw = 0;
+    POP_AND_CONTINUE();
+
+simpleOptionalToBox:
+    PUSH(&&simpleOptionalToBoxProduced);
+    top->size = (ip++)->raw;
+    PRODUCE(destination);
+simpleOptionalToBoxProduced:
+    if (top->destination->raw) top->destination->raw = top->size;  // First value non-zero means a value
+    POP_AND_CONTINUE();
+
+boxProduce:
+    destination->raw = (ip++)->raw;
+    PRODUCE(destination + 1);
+
+packList:
+    PUSH(&&packListProduced);
+    top->size = (ip++)->raw;
+    PRODUCE(destination);
+packListProduced:
+    listPack(top->destination->object, top->size);
+    POP_AND_CONTINUE();
+
+unbox:
+    PUSH(&&unboxBox);
+    top->size = (ip++)->raw;
+    PRODUCE(top->values);
+unboxBox:
+    std::memcpy(top->destination, top->values + 1, top->size * sizeof(Value));
+    POP_AND_CONTINUE();
+
+getVtReferenceStack:
+    destination->value = frame->variableDestination((ip++)->raw);
+    CONTINUE();
+getVtReferenceObject:
+    writeBarrier(frame->thisContext.object);
+    destination->value = frame->thisContext.object->variableDestination((ip++)->raw);
+    CONTINUE();
+getVtReferenceVt:
+    destination->value = frame->thisContext.value + (ip++)->raw;
+    CONTINUE();
+
+UNARY_OPERATION(getClassFromInstance, d->klass = a.object->klass)
+
+getClassFromIndex:
+    destination->klass = (ip++)->klass;
+    CONTINUE();
+getStringPool:
+    destination->object = *(ip++)->string;
+    CONTINUE();
+getTrue:
+    destination->raw = 1;
+    CONTINUE();
+getFalse:
+    destination->raw = 0;
+    CONTINUE();
+get32Integer:
+    destination->raw = (ip++)->raw;
+    CONTINUE();
+get64Integer:
+    destination->raw = ip->raw;
+    ip += 2;
+    CONTINUE();
+getDouble:
+    destination->doubl = ip->doubl;
+    ip += 3;
+    CONTINUE();
+getSymbol:
+    destination->character = (ip++)->raw;
+    CONTINUE();
+getNothingness:
+    destination->raw = 0;
+    CONTINUE();
+
+produceWithStackDestination: {
+    EmojicodeInstruction index = (ip++)->raw;
+    PRODUCE(frame->variableDestination(index));
+}
+produceWithObjectDestination: {
+    // The value is produced into a buffer as the garbage collector might move the object meanwhile. The buffer holds
+    // the current value, which is modified by instructions like INS_INCREMENT.
+    EmojicodeInteger reserved = reservedOperations(ip[1].raw);
+    if (limit - top <= reserved) error("Your program triggerd a stack overflow!");
+    top += reserved;
+    PUSH(&&objectVariableProduced);
+    top->count = ip[0].raw;
+    top->size = ip[1].raw;
+    ip += 2;
+    Value *values = reserved > 0 ? reinterpret_cast<Value *>(top - reserved) : top->values;
+    Value *current = frame->thisContext.object->variableDestination(top->count);
+    std::copy(current, current + top->size, values);
+    PRODUCE(values);
+}
+objectVariableProduced: {
+    EmojicodeInteger reserved = reservedOperations(top->size);
+    Value *values = reserved > 0 ? reinterpret_cast<Value *>(top - reserved) : top->values;
+    std::copy(values, values + top->size, frame->thisContext.object->variableDestination(top->count));
+    writeBarrier(frame->thisContext.object);
+    top -= reserved;
+    POP_AND_CONTINUE();
+}
+produceWithVtDestination: {
+    EmojicodeInstruction index = (ip++)->raw;
+    PRODUCE(frame->thisContext.value + index);
+}
+
+increment:
+    destination->raw++;
+    CONTINUE();
+decrement:
+    destination->raw--;
+    CONTINUE();
+
+copySingleStack:
+    *destination = *frame->variableDestination((ip++)->raw);
+    CONTINUE();
+copyWithSizeStack: {
+    Value *source = frame->variableDestination(ip[0].raw);
+    std::memcpy(destination, source, sizeof(Value) * ip[1].raw);
+    ip += 2;
+    CONTINUE();
+}
+copySingleObject:
+    *destination = *frame->thisContext.object->variableDestination((ip++)->raw);
+    CONTINUE();
+copyWithSizeObject: {
+    Value *source = frame->thisContext.object->variableDestination(ip[0].raw);
+    std::memcpy(destination, source, sizeof(Value) * ip[1].raw);
+    ip += 2;
+    CONTINUE();
+}
+copySingleVt:
+    *destination = frame->thisContext.value[(ip++)->raw];
+    CONTINUE();
+copyWithSizeVt: {
+    Value *source = frame->thisContext.value + ip[0].raw;
+    std::memcpy(destination, source, sizeof(Value) * ip[1].raw);
+    ip += 2;
+    CONTINUE();
+}
+copyReference:
+    PUSH(&&copyReferenceProduced);
+    top->size = (ip++)->raw;
+    PRODUCE(top->values);
+copyReferenceProduced:
+    std::memcpy(top->destination, top->values[0].value, sizeof(Value) * top->size);
+    POP_AND_CONTINUE();
+
+BINARY_OPERATIONS(BINARY_OPERATION)
+UNARY_OPERATION(invertBoolean, d->raw = !a.raw)
+UNARY_OPERATION(isNothingness, d->raw = a.value->raw == T_NOTHINGNESS)
+UNARY_OPERATION(intToDouble, d->doubl = a.raw)
+UNARY_OPERATION(binaryNotInteger, d->raw = ~a.raw)
+
+unwrapSimpleOptional:
+    PUSH(&&unwrapSimpleOptionalProduced);
+    PRODUCE(top->values);
+unwrapSimpleOptionalProduced: {
+    Value *value = top->values[0].value;
+    EmojicodeInteger n = (ip++)->raw;
+    if (value->raw != T_NOTHINGNESS) {
+        std::memcpy(top->destination, value + 1, n * sizeof(Value));
+    }
+    else {
+        error("Unexpectedly found ✨ while unwrapping a 🍬.");
+    }
+    POP_AND_CONTINUE();
+}
+
+UNARY_OPERATION(unwrapBoxOptional, {
+    Box *box = reinterpret_cast<Box *>(a.value);
+    box->unwrapOptional();
+    box->copyTo(d);
+})
+
+optionalDispatchMethod:
+    error("Optional dispatch not available");
+
+conditionalProduceBox:
+    PUSH(&&conditionalProduceBoxProduced);
+    PRODUCE(top->values);
+conditionalProduceBoxProduced: {
+    Box *box = reinterpret_cast<Box *>(top->values[0].value);
+    EmojicodeInstruction index = (ip++)->raw;
+    if ((top->destination->raw = (box->type.raw != T_NOTHINGNESS))) {
+        box->copyTo(frame->variableDestination(index));
+    }
+    POP_AND_CONTINUE();
+}
+
+conditionalProduceSimpleOptional:
+    PUSH(&&conditionalProduceSimpleOptionalProduced);
+    PRODUCE(top->values);
+conditionalProduceSimpleOptionalProduced: {
+    Value *value = top->values[0].value;
+    EmojicodeInstruction index = ip[0].raw;
+    EmojicodeInstruction n = ip[1].raw;
+    ip += 2;
+    if ((top->destination->raw = (value->raw != T_NOTHINGNESS))) {
+        std::memcpy(frame->variableDestination(index), value + 1, n * sizeof(Value));
+    }
+    POP_AND_CONTINUE();
+}
+
+getThis:
+    *destination = frame->thisContext;
+    CONTINUE();
+
+downcastToClass:
+    PUSH(&&downcastToClassProduced);
+    PRODUCE(destination + 1);
+downcastToClassProduced:
+    top->resume = &&downcastToClassClass;
+    PRODUCE(top->values);
+downcastToClassClass:
+    top->destination->raw = top->destination[1].object->klass->inheritsFrom(top->values[0].klass);
+    POP_AND_CONTINUE();
+
+castToClass:
+    PUSH(&&castToClassProduced);
+    PRODUCE(top->values);
+castToClassProduced:
+    top->resume = &&castToClassClass;
+    PRODUCE(top->values + 4);
+castToClassClass: {
+    Box *box = reinterpret_cast<Box *>(top->values);
+    Class *klass = top->values[4].klass;
+    if (box->type.raw == T_OBJECT && !box->isNothingness() && box->value1.object->klass->inheritsFrom(klass)) {
+        top->destination[0].raw = 1;
+        top->destination[1] = box->value1;
+    }
+    else {
+        top->destination[0].raw = 0;
+    }
+    POP_AND_CONTINUE();
+}
+
+castToProtocol:
+    PUSH(&&castToProtocolProduced);
+    PRODUCE(destination);
+castToProtocolProduced: {
+    EmojicodeInstruction pi = (ip++)->raw;
+    auto box = reinterpret_cast<Box *>(top->destination);
+    if (!(!box->isNothingness() &&
+          ((box->type.raw == T_OBJECT && box->value1.object->klass->protocolTable.conformsTo(pi)) ||
+           protocolDispatchTableTable[box->type.raw].conformsTo(pi)))) {
+        top->destination[0].raw = 0;
+    }
+    POP_AND_CONTINUE();
+}
+
+castToValueType:
+    PUSH(&&castToValueTypeProduced);
+    PRODUCE(top->values);
+castToValueTypeProduced: {
+    Box *box = reinterpret_cast<Box *>(top->values);
+    EmojicodeInstruction id = (ip++)->raw;
+    if (box->type.raw != id) {
+        top->destination->makeNothingness();
+    }
+    else {
+        top->destination->raw = 1;
+        box->copyContentTo(top->destination + 1);
+    }
+    POP_AND_CONTINUE();
+}
+
+dictionaryLiteral: {
+    PUSH(&&dictionaryLiteralKey);
+    top->retained = thread->retainSlot(newObject(CL_DICTIONARY));
+    dictionaryInit(static_cast<EmojicodeDictionary *>((*top->retained)->value()));
+    top->pointer = (ip++)->pointer;
+    goto dictionaryLiteralNext;
+}
+dictionaryLiteralKey:
+    top->resume = &&dictionaryLiteralValue;
+    PRODUCE(top->values + 1);
+dictionaryLiteralValue:
+    dictionaryPutVal(*top->retained, top->values[0].object, *reinterpret_cast<Box *>(top->values + 1), thread);
+dictionaryLiteralNext:
+    if (ip < top->pointer) {
+        top->resume = &&dictionaryLiteralKey;
+        PRODUCE(top->values);
+    }
+    top->destination->object = *top->retained;
+    thread->release(1);
+    POP_AND_CONTINUE();
+
+listLiteral: {
+    PUSH(&&listLiteralNext);
+    top->retained = thread->retainSlot(newObject(CL_LIST));
+    top->pointer = (ip++)->pointer;
+    top->size = (ip++)->raw;  // The type the list is packed with
+}
+listLiteralNext:
+    if (ip < top->pointer) {
+        PRODUCE(listAppendDestination(*top->retained, thread));
+    }
+    listPack(*top->retained, top->size);
+    top->destination->object = *top->retained;
+    thread->release(1);
+    POP_AND_CONTINUE();
+
+stringConcatenation:
+    PUSH(&&stringConcatenationProduced);
+    top->count = (ip++)->raw;
+    top->size = 0;  // The length
+    top->retained = thread->retainSlot(stringConcatenationBegin());
+    goto stringConcatenationNext;
+stringConcatenationProduced: {
+    size_t length = top->size;
+    stringConcatenationAppend(thread, top->retained, length, top->values[0].object);
+    top->size = length;
+}
+stringConcatenationNext:
+    if (top->count > 0) {
+        top->count--;
+        PRODUCE(top->values);
+    }
+    top->destination->object = stringConcatenationEnd(*top->retained, top->size);
+    thread->release(1);
+    POP_AND_CONTINUE();
+
+returnInstruction:
+    PUSH(&&returnProduced);
+    PRODUCE(frame->destination);
+returnProduced:
+    top = currentCall;
+    CONTINUE();
+
+repeatWhile:
+    PUSH(&&repeatWhileCondition);
+    top->pointer = ip;
+    PRODUCE(top->values);
+repeatWhileCondition:
+    if (top->values[0].raw) {
+        top->resume = &&repeatWhileRepeat;
+        ENTER_BLOCK();
+    }
+    SKIP_BLOCK();
+    POP_AND_CONTINUE();
+repeatWhileRepeat:
+    safepoint();
+    ip = top->pointer;
+    top->resume = &&repeatWhileCondition;
+    PRODUCE(top->values);
+
+ifInstruction: {
+    PUSH(&&ifCondition);
+    top->pointer = (ip++)->pointer;
+    PRODUCE(top->values);
+}
+ifCondition:
+    if (top->values[0].raw) {  // Main if
+        top->resume = &&ifBlockFinished;
+        ENTER_BLOCK();
+    }
+    SKIP_BLOCK();
+ifNextBranch:
+    switch ((ip++)->raw) {
+        case 0:
+            POP_AND_CONTINUE();
+        case 1:  // Else If
+            top->resume = &&elseIfCondition;
+            PRODUCE(top->values);
+        default:  // Else
+            top->resume = &&popOperation;
+            ENTER_BLOCK();
+    }
+elseIfCondition:
+    if (top->values[0].raw) {
+        top->resume = &&ifBlockFinished;
+        ENTER_BLOCK();
+    }
+    SKIP_BLOCK();
+    goto ifNextBranch;
+ifBlockFinished:
+    ip = top->pointer;
+    POP_AND_CONTINUE();
+
+forInList:
+    PUSH(&&forInListProduced);
+    top->count = (ip++)->raw;  // The variable
+    PRODUCE(top->values);
+forInListProduced:
+    top->size = (ip++)->raw;  // The variable holding the list object
+    *frame->variableDestination(top->size) = top->values[0];
+    top->pointer = ip;
+    top->values[1].raw = 0;
+    top->resume = &&forInListRepeat;
+forInListNext: {
+    List *list = static_cast<List *>(frame->variableDestination(top->size)->object->value());
+    if (static_cast<size_t>(top->values[1].raw) < list->count) {
+        list->element(top->values[1].raw).copyTo(frame->variableDestination(top->count));
+        reinterpret_cast<Box *>(frame->variableDestination(top->count))->unwrapOptional();
+        ENTER_BLOCK();
+    }
+}
+    SKIP_BLOCK();
+    POP_AND_CONTINUE();
+forInListRepeat:
+    safepoint();
+    ip = top->pointer;
+    top->values[1].raw++;
+    goto forInListNext;
+
+forInRange:
+    PUSH(&&forInRangeProduced);
+    top->count = (ip++)->raw;  // The variable
+    PRODUCE(top->values);
+forInRangeProduced:
+    top->pointer = ip;
+    top->values[1].raw = top->values[0].value[0].raw;
+    top->resume = &&forInRangeRepeat;
+forInRangeNext:
+    if (top->values[1].raw != top->values[0].value[1].raw) {
+        frame->variableDestination(top->count)->raw = top->values[1].raw;
+        ENTER_BLOCK();
+    }
+    SKIP_BLOCK();
+    POP_AND_CONTINUE();
+forInRangeRepeat:
+    safepoint();
+    ip = top->pointer;
+    top->values[1].raw += top->values[0].value[2].raw;
+    goto forInRangeNext;
+
+executeCallable:
+    PUSH(&&executeCallableProduced);
+    PRODUCE(top->values);
+executeCallableProduced: {
+    Object *callable = top->values[0].object;
+    destination = top->destination;
+    top--;
+    if (callable->klass == CL_CAPTURED_FUNCTION_CALL) {
+        CapturedFunctionCall *cmc = static_cast<CapturedFunctionCall *>(callable->value());
+        function = cmc->function;
+        self = cmc->callee;
+        goto invokeFunction;
+    }
+
+    Closure *c = static_cast<Closure *>(callable->value());
+    PUSH(&&argumentProduced);
+    top->closure = c;
+    top->enter = &&enterClosure;
+    top->frame = thread->reserveFrame(c->thisContext, c->variableCount, c->function, destination,
+                                      c->block.instructions);
+    top->count = c->argumentCount;
+    goto produceArguments;
+}
+
+closureInstruction: {
+    Object *const &closure = thread->retain(newObject(CL_CLOSURE));
+
+    Closure *c = static_cast<Closure *>(closure->value());
+
+    c->function = frame->function->closures[(ip++)->raw];
+    c->variableCount = (ip++)->raw;
+    c->block = c->function->block;
+    EmojicodeInstruction instructionCount = (ip++)->raw;
+    ip += instructionCount;
+
+    EmojicodeInstruction argumentCount = (ip++)->raw;
+    c->argumentCount = argumentCount;
+
+    c->captureCount = (ip++)->raw;
+    EmojicodeInteger size = (ip++)->raw;
+
+    Object *infoo = newArray(sizeof(CaptureInformation) * c->captureCount);
+    c = static_cast<Closure *>(closure->value());
+    c->capturesInformation = infoo;
+    // The references are copied into the captured variables without allocating after they were allocated
+    Object *captures = newArray(sizeof(Value) * size);
+    c = static_cast<Closure *>(closure->value());
+    c->capturedVariables = captures;
+
+    Value *t = static_cast<Value *>(c->capturedVariables->value());
+    CaptureInformation *info = static_cast<CaptureInformation *>(c->capturesInformation->value());
+    for (int i = 0; i < c->captureCount; i++) {
+        EmojicodeInteger index = (ip++)->raw;
+        EmojicodeInteger size = (ip++)->raw;
+        info->destination = (ip++)->raw;
+        (info++)->size = size;
+        std::memcpy(t, frame->variableDestination(index), size * sizeof(Value));
+        t += size;
+    }
+
+    if (argumentCount >> 16)
+        c->thisContext = frame->thisContext;
+
+    destination->object = closure;
+    thread->release(1);
+    CONTINUE();
+}
+
+captureMethod:
+    PUSH(&&captureMethodProduced);
+    PRODUCE(top->values);
+captureMethodProduced: {
+    Object *const &callee = thread->retain(top->values[0].object);
+
+    Object *cmco = newObject(CL_CAPTURED_FUNCTION_CALL);
+    CapturedFunctionCall *cmc = static_cast<CapturedFunctionCall *>(cmco->value());
+
+    cmc->function = callee->klass->methodsVtable[(ip++)->raw];
+    cmc->callee.object = callee;
+    thread->release(1);
+    top->destination->object = cmco;
+    POP_AND_CONTINUE();
+}
+
+captureTypeMethod:
+    PUSH(&&captureTypeMethodProduced);
+    PRODUCE(top->values);
+captureTypeMethodProduced: {
+    Object *cmco = newObject(CL_CAPTURED_FUNCTION_CALL);
+    CapturedFunctionCall *cmc = static_cast<CapturedFunctionCall *>(cmco->value());
+
+    cmc->function = top->values[0].klass->methodsVtable[(ip++)->raw];
+    cmc->callee.klass = top->values[0].klass;
+    top->destination->object = cmco;
+    POP_AND_CONTINUE();
+}
+
+captureContextedFunction:
+    PUSH(&&captureContextedFunctionProduced);
+    PRODUCE(top->values);
+captureContextedFunctionProduced: {
+    Object *cmco = newObject(CL_CAPTURED_FUNCTION_CALL);
+    CapturedFunctionCall *cmc = static_cast<CapturedFunctionCall *>(cmco->value());
+
+    cmc->function = functionTable[(ip++)->raw];
+    cmc->callee = top->values[0];
+
+    top->destination->object = cmco;
+    POP_AND_CONTINUE();
+}
+
+illegalInstruction:
+    error("Illegal bytecode instruction %X", instructions[ip - 1 - code]);
+
+finished:
+    thread->setOperationStackTop(base);
+}
+
+void prepareThreadedEngine() {
+    execute(nullptr, nullptr);
+}
+
+void runThreaded(Thread *thread, const Block &block) {
+    execute(thread, &block);
+}
+
+Code* allocateCode(const Block &block) {
+    Code *code = new Code[block.instructionCount];
+    for (unsigned int i = 0; i < block.instructionCount; i++) {
+        code[i].raw = block.instructions[i];
+    }
+    return code;
+}
@@ -0,0 +1,107 @@
+//
+//  ThreadedProcessor.hpp
+//  Emojicode
+//
+
+#ifndef ThreadedProcessor_hpp
+#define ThreadedProcessor_hpp
+
+#include "Engine.hpp"
+#include "Thread.hpp"
+#include <atomic>
+
+/// The number of records in the operation stack of a thread.
+#define operationStackSize 100000
+
+/**
+ * A record on the operation stack of the threaded engine.
+ *
+ * The threaded engine does not evaluate nested instructions by recursion. Instead, every instruction that needs the
+ * values of other instructions pushes an operation record, evaluates its operands into the record’s @c values and
+ * continues at the label stored in @c resume once an operand has been produced.
+ */
+struct Operation {
+    /// The label at which execution continues once the operand that is currently evaluated was produced.
+    void *resume;
+    /// The destination into which the instruction that pushed this record must produce its result.
+    Value *destination;
+    /// The end of a block, the beginning of a loop or the position to return to after a call.
+    Code *pointer;
+    /// The code and the bytecode of the caller, which are restored after a call.
+    Code *code;
+    EmojicodeInstruction *instructions;
+    /// The label at which a call continues once its arguments were produced.
+    void *enter;
+    /// The record of the call that was executed when the callee was entered.
+    Operation *call;
+    /// The frame reserved for a call.
+    StackFrame *frame;
+    union {
+        Function *function;
+        Closure *closure;
+        Object **retained;
+    };
+    EmojicodeInteger count;
+    EmojicodeInteger size;
+    /// Storage for operands. Large enough to hold a string key and a Box.
+    Value values[5];
+};
+
+/// The number of receiver types an inline cache can hold before the call site is considered megamorphic.
+#define inlineCacheSize 4
+
+/**
+ * The inline cache of a method or protocol dispatch site.
+ *
+ * It remembers the functions that were dispatched to for up to @c inlineCacheSize receiver types. Entries are only
+ * appended and become visible to other threads once @c count was incremented.
+ */
+struct InlineCache {
+    struct Entry {
+        /// The class of the receiver or, for value types, the type id
+        uintptr_t type;
+        Function *function;
+    };
+
+    bool protocol;
+    EmojicodeInstruction protocolIndex;
+    EmojicodeInstruction vti;
+    std::atomic<unsigned int> count{0};
+    Entry entries[inlineCacheSize];
+    std::atomic<uint_fast64_t> hits{0};
+    std::atomic<uint_fast64_t> misses{0};
+    /// The cache created before this one
+    InlineCache *next;
+};
+
+/// Returns the function to call for a receiver of class @c klass and caches it in @c cache.
+Function* lookUpMethod(InlineCache *cache, Class *klass);
+Function* lookUpProtocolMethod(InlineCache *cache, Class *klass);
+/// Returns the function to call for a value type with the type id @c type and caches it in @c cache.
+Function* lookUpProtocolMethod(InlineCache *cache, EmojicodeInteger type);
+
+/// Returns the inline cache of the dispatch instruction at @c site in @c block, whose cache is stored in the slot of
+/// @c operand, or @c nullptr if the instruction was not executed yet.
+InlineCache* inlineCacheAt(const Block &block, const EmojicodeInstruction *site, const EmojicodeInstruction *operand);
+
+/// Whether the inline caches count their hits and misses. Set at startup by the @c --ic-stats option.
+extern bool inlineCacheStatistics;
+
+/// Prints the hits and misses of all inline caches to stderr.
+void printInlineCacheStatistics();
+
+/// Must be called once before the threaded engine is used and before any other threads were started.
+void prepareThreadedEngine();
+
+/// Executes @c block, which must belong to the current stack frame, using the threaded engine. Returns once the last
+/// instruction was executed or the function returned.
+void runThreaded(Thread *thread, const Block &block);
+
+/// Decodes the double stored in the three instructions at @c instruction.
+double decodeDouble(const EmojicodeInstruction *instruction);
+
+/// Allocates the code the threaded engine runs for @c block. Instructions are decoded in place when they are executed
+/// for the first time.
+Code* allocateCode(const Block &block);
+
+#endif /* ThreadedProcessor_hpp */
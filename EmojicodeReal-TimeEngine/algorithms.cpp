@@ -8,30 +8,223 @@
 
 #include "algorithms.h"
 #include <string.h>
+#include <algorithm>
 
-const void* findBytesInBytes(const void *l, size_t l_len, const void *s, size_t s_len) {
-    char *cur, *last;
-    const char *cl = (const char *)l;
-    const char *cs = (const char *)s;
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+// The searches filter the positions of the haystack by comparing the first and the last element of the needle, several
+// positions at once if SIMD instructions are available, and only compare the remaining elements at the positions that
+// pass. If too many positions pass, they switch to the Two-Way algorithm, whose running time is linear in the worst
+// case. The elements are bytes or code points, which are always compared as a whole.
+
+/// Needles of at most this many elements are always searched with the filter, as comparing them is cheap anyway
+static const size_t twoWayMinimumLength = 16;
+
+/// Returns true if a search that verified @c verifications candidates among the first @c position positions should
+/// switch to the Two-Way algorithm.
+static inline bool tooManyCandidates(size_t verifications, size_t position, size_t needleLength) {
+    return needleLength > twoWayMinimumLength && verifications > 64 && verifications * 8 > position;
+}
+
+/// Returns true if the elements between the first and the last element of @c needle, which were compared already,
+/// match at @c candidate.
+template <typename T>
+static inline bool remainderMatches(const T *candidate, const T *needle, size_t needleLength) {
+    return needleLength <= 2 || memcmp(candidate + 1, needle + 1, (needleLength - 2) * sizeof(T)) == 0;
+}
+
+/// Computes the maximal suffix of @c needle with respect to the order of elements, or the reversed order if
+/// @c reversed is true. Returns the index of the element before the suffix and stores its period in @c period.
+template <typename T>
+static ptrdiff_t maximalSuffix(const T *needle, ptrdiff_t length, ptrdiff_t *period, bool reversed) {
+    ptrdiff_t suffix = -1, j = 0, k = 1;
+    *period = 1;
+    while (j + k < length) {
+        T a = needle[j + k], b = needle[suffix + k];
+        if (reversed ? a > b : a < b) {
+            j += k;
+            k = 1;
+            *period = j - suffix;
+        }
+        else if (a == b) {
+            if (k != *period) {
+                k++;
+            }
+            else {
+                j += *period;
+                k = 1;
+            }
+        }
+        else {
+            suffix = j;
+            j = suffix + 1;
+            k = *period = 1;
+        }
+    }
+    return suffix;
+}
 
-    /* we need something to compare */
-    if (l_len == 0 || s_len == 0)
-        return NULL;
+/// Searches @c needle in @c haystack with the Two-Way algorithm by Crochemore and Perrin.
+template <typename T>
+static const T* findTwoWay(const T *haystack, size_t haystackLength, const T *needle, size_t needleLength) {
+    auto n = static_cast<ptrdiff_t>(haystackLength), m = static_cast<ptrdiff_t>(needleLength);
+    ptrdiff_t p, q;
+    ptrdiff_t i = maximalSuffix(needle, m, &p, false);
+    ptrdiff_t j = maximalSuffix(needle, m, &q, true);
+    ptrdiff_t ell = i > j ? i : j;
+    ptrdiff_t period = i > j ? p : q;
 
-    /* "s" must be smaller or equal to "l" */
-    if (l_len < s_len)
-        return NULL;
+    if (memcmp(needle, needle + period, (ell + 1) * sizeof(T)) == 0) {
+        // The needle is periodic, the part of the period matched already is remembered after a shift by the period
+        ptrdiff_t memory = -1;
+        for (j = 0; j <= n - m;) {
+            for (i = std::max(ell, memory) + 1; i < m && needle[i] == haystack[i + j]; i++);
+            if (i >= m) {
+                for (i = ell; i > memory && needle[i] == haystack[i + j]; i--);
+                if (i <= memory) {
+                    return haystack + j;
+                }
+                j += period;
+                memory = m - period - 1;
+            }
+            else {
+                j += i - ell;
+                memory = -1;
+            }
+        }
+        return nullptr;
+    }
 
-    /* special case where s_len == 1 */
-    if (s_len == 1)
-        return memchr(l, (int)*cs, l_len);
+    period = std::max(ell + 1, m - ell - 1) + 1;
+    for (j = 0; j <= n - m;) {
+        for (i = ell + 1; i < m && needle[i] == haystack[i + j]; i++);
+        if (i >= m) {
+            for (i = ell; i >= 0 && needle[i] == haystack[i + j]; i--);
+            if (i < 0) {
+                return haystack + j;
+            }
+            j += period;
+        }
+        else {
+            j += i - ell;
+        }
+    }
+    return nullptr;
+}
+
+/// Searches the positions from @c position on without SIMD instructions.
+template <typename T>
+static const T* findScalar(const T *haystack, size_t haystackLength, const T *needle, size_t needleLength,
+                           size_t position, size_t verifications) {
+    T first = needle[0], last = needle[needleLength - 1];
+    for (; position + needleLength <= haystackLength; position++) {
+        const T *candidate = haystack + position;
+        if (candidate[0] == first && candidate[needleLength - 1] == last) {
+            if (remainderMatches(candidate, needle, needleLength)) {
+                return candidate;
+            }
+            if (tooManyCandidates(++verifications, position, needleLength)) {
+                return findTwoWay(candidate, haystackLength - position, needle, needleLength);
+            }
+        }
+    }
+    return nullptr;
+}
 
-    /* the last position where its possible to find "s" in "l" */
-    last = (char *)cl + l_len - s_len;
+#if defined(__x86_64__)
 
-    for (cur = (char *)cl; cur <= last; cur++)
-        if (cur[0] == cs[0] && memcmp(cur, cs, s_len) == 0)
-            return cur;
+/// Returns a mask with one bit set for each element of @c T of a vector of @c size bytes.
+template <typename T>
+static inline uint32_t elementMask(size_t size) {
+    uint32_t bytes = size == 32 ? 0xFFFFFFFF : 0xFFFF;
+    return sizeof(T) == 1 ? bytes : bytes & 0x11111111;
+}
+
+/// Searches with SSE2, which every x86-64 processor supports, comparing 16 bytes at once.
+template <typename T>
+static const T* findSSE2(const T *haystack, size_t haystackLength, const T *needle, size_t needleLength) {
+    const size_t elements = 16 / sizeof(T);
+    __m128i first = sizeof(T) == 1 ? _mm_set1_epi8(static_cast<char>(needle[0])) : _mm_set1_epi32(needle[0]);
+    __m128i last = sizeof(T) == 1 ? _mm_set1_epi8(static_cast<char>(needle[needleLength - 1]))
+                                  : _mm_set1_epi32(needle[needleLength - 1]);
+    size_t verifications = 0;
+    size_t position = 0;
+    for (; position + needleLength - 1 + elements <= haystackLength; position += elements) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(haystack + position));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(haystack + position + needleLength - 1));
+        __m128i equal = sizeof(T) == 1 ? _mm_and_si128(_mm_cmpeq_epi8(a, first), _mm_cmpeq_epi8(b, last))
+                                       : _mm_and_si128(_mm_cmpeq_epi32(a, first), _mm_cmpeq_epi32(b, last));
+        uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(equal)) & elementMask<T>(16);
+        for (; mask != 0; mask &= mask - 1) {
+            const T *candidate = haystack + position + __builtin_ctz(mask) / sizeof(T);
+            if (remainderMatches(candidate, needle, needleLength)) {
+                return candidate;
+            }
+            if (tooManyCandidates(++verifications, position, needleLength)) {
+                return findTwoWay(candidate, haystackLength - (candidate - haystack), needle, needleLength);
+            }
+        }
+    }
+    return findScalar(haystack, haystackLength, needle, needleLength, position, verifications);
+}
+
+/// Searches with AVX2 comparing 32 bytes at once. Must only be called if the processor supports AVX2.
+template <typename T>
+__attribute__((target("avx2")))
+static const T* findAVX2(const T *haystack, size_t haystackLength, const T *needle, size_t needleLength) {
+    const size_t elements = 32 / sizeof(T);
+    __m256i first = sizeof(T) == 1 ? _mm256_set1_epi8(static_cast<char>(needle[0])) : _mm256_set1_epi32(needle[0]);
+    __m256i last = sizeof(T) == 1 ? _mm256_set1_epi8(static_cast<char>(needle[needleLength - 1]))
+                                  : _mm256_set1_epi32(needle[needleLength - 1]);
+    size_t verifications = 0;
+    size_t position = 0;
+    for (; position + needleLength - 1 + elements <= haystackLength; position += elements) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(haystack + position));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(haystack + position + needleLength - 1));
+        __m256i equal = sizeof(T) == 1
+                            ? _mm256_and_si256(_mm256_cmpeq_epi8(a, first), _mm256_cmpeq_epi8(b, last))
+                            : _mm256_and_si256(_mm256_cmpeq_epi32(a, first), _mm256_cmpeq_epi32(b, last));
+        uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(equal)) & elementMask<T>(32);
+        for (; mask != 0; mask &= mask - 1) {
+            const T *candidate = haystack + position + __builtin_ctz(mask) / sizeof(T);
+            if (remainderMatches(candidate, needle, needleLength)) {
+                return candidate;
+            }
+            if (tooManyCandidates(++verifications, position, needleLength)) {
+                return findTwoWay(candidate, haystackLength - (candidate - haystack), needle, needleLength);
+            }
+        }
+    }
+    return findScalar(haystack, haystackLength, needle, needleLength, position, verifications);
+}
+
+#endif
+
+template <typename T>
+static const T* find(const T *haystack, size_t haystackLength, const T *needle, size_t needleLength) {
+    if (haystackLength == 0 || needleLength == 0 || haystackLength < needleLength) {
+        return nullptr;
+    }
+#if defined(__x86_64__)
+    static const bool avx2 = __builtin_cpu_supports("avx2");
+    if (avx2) {
+        return findAVX2(haystack, haystackLength, needle, needleLength);
+    }
+    return findSSE2(haystack, haystackLength, needle, needleLength);
+#else
+    return findScalar(haystack, haystackLength, needle, needleLength, 0, 0);
+#endif
+}
+
+const void* findBytesInBytes(const void *l, size_t l_len, const void *s, size_t s_len) {
+    if (s_len == 1 && l_len > 0) {
+        return memchr(l, *static_cast<const uint8_t *>(s), l_len);
+    }
+    return find(static_cast<const uint8_t *>(l), l_len, static_cast<const uint8_t *>(s), s_len);
+}
 
-    return NULL;
+const uint32_t* findCodePoints(const uint32_t *l, size_t l_len, const uint32_t *s, size_t s_len) {
+    return find(l, l_len, s, s_len);
 }
@@ -10,8 +10,12 @@
 #define algorithms_h
 
 #include <stddef.h>
+#include <stdint.h>
 
 /** @c memmem implementation. */
 const void* findBytesInBytes(const void *l, size_t l_len, const void *s, size_t s_len);
 
+/** @c memmem for code points: Searches the @c s_len code points at @c s in the @c l_len code points at @c l. */
+const uint32_t* findCodePoints(const uint32_t *l, size_t l_len, const uint32_t *s, size_t s_len);
+
 #endif /* algorithms_h */
@@ -22,6 +22,7 @@
 #include "EmojicodeDictionary.h"
 #include "../utf8.h"
 #include "algorithms.h"
+#include "Object.hpp"
 #include "Thread.hpp"
 
 EmojicodeInteger secureRandomNumber(EmojicodeInteger min, EmojicodeInteger max) {
@@ -44,7 +45,7 @@ static void systemExit(Thread *thread, Value *destination) {
 }
 
 static void systemGetEnv(Thread *thread, Value *destination) {
-    char* variableName = stringToChar(static_cast<String *>(thread->getVariable(0).object->value));
+    char* variableName = stringToChar(static_cast<String *>(thread->getVariable(0).object->value()));
     char* env = getenv(variableName);
 
     if (!env) {
@@ -70,14 +71,17 @@ static void systemTime(Thread *thread, Value *destination) {
 static void systemArgs(Thread *thread, Value *destination) {
     Object *const &listObject = thread->retain(newObject(CL_LIST));
 
-    List *newList = static_cast<List *>(listObject->value);
-    newList->capacity = cliArgumentCount;
     Object *items = newArray(sizeof(Value) * cliArgumentCount);
-
-    static_cast<List *>(listObject->value)->items = items;
+    List *newList = static_cast<List *>(listObject->value());
+    newList->capacity = cliArgumentCount;
+    newList->items = items;
+    newList->packedType = T_OBJECT;
 
     for (int i = 0; i < cliArgumentCount; i++) {
-        listAppendDestination(listObject, thread)->copySingleValue(T_OBJECT, stringFromChar(cliArguments[i]));
+        Object *string = stringFromChar(cliArguments[i]);
+        newList = static_cast<List *>(listObject->value());
+        newList->values()[newList->count++].object = string;
+        writeBarrier(listObject);
     }
 
     thread->release(1);
@@ -85,7 +89,7 @@ static void systemArgs(Thread *thread, Value *destination) {
 }
 
 static void systemSystem(Thread *thread, Value *destination) {
-    char *command = stringToChar(static_cast<String *>(thread->getVariable(0).object->value));
+    char *command = stringToChar(static_cast<String *>(thread->getVariable(0).object->value()));
     FILE *f = popen(command, "r");
     delete [] command;
 
@@ -98,8 +102,8 @@ static void systemSystem(Thread *thread, Value *destination) {
     int bufferSize = 50;
     Object *buffer = newArray(bufferSize);
 
-    while (fgets((char *)buffer->value + bufferUsedSize, bufferSize - (int)bufferUsedSize, f) != nullptr) {
-        bufferUsedSize = strlen(static_cast<char *>(buffer->value));
+    while (fgets((char *)buffer->value() + bufferUsedSize, bufferSize - (int)bufferUsedSize, f) != nullptr) {
+        bufferUsedSize = strlen(static_cast<char *>(buffer->value()));
 
         if (bufferSize - bufferUsedSize < 2) {
             bufferSize *= 2;
@@ -107,19 +111,14 @@ static void systemSystem(Thread *thread, Value *destination) {
         }
     }
 
-    bufferUsedSize = strlen(static_cast<char *>(buffer->value));
-
-    EmojicodeInteger len = u8_strlen_l(static_cast<char *>(buffer->value), bufferUsedSize);
-
-    Object *const &so = thread->retain(newObject(CL_STRING));
-    String *string = static_cast<String *>(so->value);
-    string->length = len;
+    bufferUsedSize = strlen(static_cast<char *>(buffer->value()));
 
-    Object *chars = newArray(len * sizeof(EmojicodeChar));
-    string = static_cast<String *>(so->value);
-    string->characters = chars;
+    int latin1;
+    EmojicodeInteger len = u8_measure(static_cast<char *>(buffer->value()), bufferUsedSize, &latin1, nullptr);
 
-    u8_toucs(characters(string), len, static_cast<char *>(buffer->value), bufferUsedSize);
+    Object *const &retainedBuffer = thread->retain(buffer);
+    Object *so = newString(len, latin1);
+    stringDecodeUTF8(static_cast<String *>(so->value()), static_cast<char *>(retainedBuffer->value()), bufferUsedSize);
     thread->release(1);
     destination->object = so;
 }
@@ -128,7 +127,7 @@ static void systemSystem(Thread *thread, Value *destination) {
 
 static void threadJoin(Thread *thread, Value *destination) {
     allowGC();
-    pthread_join(*(pthread_t *)((Object *)thread->getThisObject())->value, nullptr);  // TODO: GC?!
+    pthread_join(*(pthread_t *)((Object *)thread->getThisObject())->value(), nullptr);  // TODO: GC?!
     disallowGCAndPauseIfNeeded();
 }
 
@@ -150,11 +149,11 @@ static void initThread(Thread *thread, Value *destination) {
 }
 
 static void initMutex(Thread *thread, Value *destination) {
-    pthread_mutex_init(static_cast<pthread_mutex_t*>(thread->getThisObject()->value), nullptr);
+    pthread_mutex_init(static_cast<pthread_mutex_t*>(thread->getThisObject()->value()), nullptr);
 }
 
 static void mutexLock(Thread *thread, Value *destination) {
-    while (pthread_mutex_trylock(static_cast<pthread_mutex_t*>(thread->getThisObject()->value)) != 0) {
+    while (pthread_mutex_trylock(static_cast<pthread_mutex_t*>(thread->getThisObject()->value())) != 0) {
         // TODO: Obviously stupid, but this is the only safe way. If pthread_mutex_lock was used,
         // the thread would be block, and the GC could cause a deadlock. allowGC, however, would
         // allow moving this mutex – obviously not a good idea either when using pthread_mutex_lock.
@@ -164,11 +163,11 @@ static void mutexLock(Thread *thread, Value *destination) {
 }
 
 static void mutexUnlock(Thread *thread, Value *destination) {
-    pthread_mutex_unlock(static_cast<pthread_mutex_t*>(thread->getThisObject()->value));
+    pthread_mutex_unlock(static_cast<pthread_mutex_t*>(thread->getThisObject()->value()));
 }
 
 static void mutexTryLock(Thread *thread, Value *destination) {
-    destination->raw = pthread_mutex_trylock(static_cast<pthread_mutex_t*>(thread->getThisObject()->value)) == 0;
+    destination->raw = pthread_mutex_trylock(static_cast<pthread_mutex_t*>(thread->getThisObject()->value())) == 0;
 }
 
 // MARK: Error
@@ -176,7 +175,7 @@ static void mutexTryLock(Thread *thread, Value *destination) {
 Object* newError(const char *message, int code) {
     Object *o = newObject(CL_ERROR);
 
-    EmojicodeError* error = static_cast<EmojicodeError *>(o->value);
+    EmojicodeError* error = static_cast<EmojicodeError *>(o->value());
     error->message = message;
     error->code = code;
 
@@ -184,26 +183,26 @@ Object* newError(const char *message, int code) {
 }
 
 void initErrorBridge(Thread *thread, Value *destination) {
-    EmojicodeError *error = static_cast<EmojicodeError *>(thread->getThisObject()->value);
-    error->message = stringToChar(static_cast<String *>(thread->getVariable(0).object->value));
+    EmojicodeError *error = static_cast<EmojicodeError *>(thread->getThisObject()->value());
+    error->message = stringToChar(static_cast<String *>(thread->getVariable(0).object->value()));
     error->code = thread->getVariable(1).raw;
 }
 
 static void errorGetMessage(Thread *thread, Value *destination) {
-    EmojicodeError *error = static_cast<EmojicodeError *>(thread->getThisObject()->value);
+    EmojicodeError *error = static_cast<EmojicodeError *>(thread->getThisObject()->value());
     destination->object = stringFromChar(error->message);
 }
 
 static void errorGetCode(Thread *thread, Value *destination) {
-    EmojicodeError *error = static_cast<EmojicodeError *>(thread->getThisObject()->value);
+    EmojicodeError *error = static_cast<EmojicodeError *>(thread->getThisObject()->value());
     destination->raw = error->code;
 }
 
 // MARK: Data
 
 static void dataEqual(Thread *thread, Value *destination) {
-    Data *d = static_cast<Data *>(thread->getThisObject()->value);
-    Data *b = static_cast<Data *>(thread->getVariable(0).object->value);
+    Data *d = static_cast<Data *>(thread->getThisObject()->value());
+    Data *b = static_cast<Data *>(thread->getVariable(0).object->value());
 
     if (d->length != b->length) {
         destination->raw = 0;
@@ -214,20 +213,20 @@ static void dataEqual(Thread *thread, Value *destination) {
 }
 
 static void dataSize(Thread *thread, Value *destination) {
-    Data *d = static_cast<Data *>(thread->getThisObject()->value);
+    Data *d = static_cast<Data *>(thread->getThisObject()->value());
     destination->raw = d->length;
 }
 
 static void dataMark(Object *o) {
-    Data *d = static_cast<Data *>(o->value);
+    Data *d = static_cast<Data *>(o->value());
     if (d->bytesObject) {
         mark(&d->bytesObject);
-        d->bytes = static_cast<char *>(d->bytesObject->value);
+        d->bytes = static_cast<char *>(d->bytesObject->value());
     }
 }
 
 static void dataGetByte(Thread *thread, Value *destination) {
-    Data *d = static_cast<Data *>(thread->getThisObject()->value);
+    Data *d = static_cast<Data *>(thread->getThisObject()->value());
 
     EmojicodeInteger index = thread->getVariable(0).raw;
     if (index < 0) {
@@ -242,28 +241,24 @@ static void dataGetByte(Thread *thread, Value *destination) {
 }
 
 static void dataToString(Thread *thread, Value *destination) {
-    Data *data = static_cast<Data *>(thread->getThisObject()->value);
-    if (!u8_isvalid(data->bytes, data->length)) {
+    Data *data = static_cast<Data *>(thread->getThisObject()->value());
+    int latin1, valid;
+    EmojicodeInteger len = u8_measure(data->bytes, data->length, &latin1, &valid);
+    if (!valid) {
         destination->makeNothingness();
         return;
     }
 
-    EmojicodeInteger len = u8_strlen_l(data->bytes, data->length);
-    Object *const &characters = thread->retain(newArray(len * sizeof(EmojicodeChar)));
-
-    Object *sto = newObject(CL_STRING);
-    String *string = static_cast<String *>(sto->value);
-    string->length = len;
-    string->characters = characters;
-    thread->release(1);
-    u8_toucs(characters(string), len, data->bytes, data->length);
+    Object *sto = newString(len, latin1);
+    data = static_cast<Data *>(thread->getThisObject()->value());
+    stringDecodeUTF8(static_cast<String *>(sto->value()), data->bytes, data->length);
     destination->optionalSet(sto);
 }
 
 static void dataSlice(Thread *thread, Value *destination) {
     Object *ooData = newObject(CL_DATA);
-    Data *oData = static_cast<Data *>(ooData->value);
-    Data *data = static_cast<Data *>(thread->getThisObject()->value);
+    Data *oData = static_cast<Data *>(ooData->value());
+    Data *data = static_cast<Data *>(thread->getThisObject()->value());
 
     EmojicodeInteger from = thread->getVariable(0).raw;
     if (from >= data->length) {
@@ -283,8 +278,8 @@ static void dataSlice(Thread *thread, Value *destination) {
 }
 
 static void dataIndexOf(Thread *thread, Value *destination) {
-    Data *data = static_cast<Data *>(thread->getThisObject()->value);
-    Data *search = static_cast<Data *>(thread->getVariable(0).object->value);
+    Data *data = static_cast<Data *>(thread->getThisObject()->value());
+    Data *search = static_cast<Data *>(thread->getVariable(0).object->value());
     const void *location = findBytesInBytes(data->bytes, data->length, search->bytes, search->length);
     if (!location) {
         destination->makeNothingness();
@@ -295,22 +290,22 @@ static void dataIndexOf(Thread *thread, Value *destination) {
 }
 
 static void dataByAppendingData(Thread *thread, Value *destination) {
-    Data *data = static_cast<Data *>(thread->getThisObject()->value);
-    Data *b = static_cast<Data *>(thread->getVariable(0).object->value);
+    Data *data = static_cast<Data *>(thread->getThisObject()->value());
+    Data *b = static_cast<Data *>(thread->getVariable(0).object->value());
 
     size_t size = data->length + b->length;
     Object *const &newBytes = thread->retain(newArray(size));
 
-    b = static_cast<Data *>(thread->getVariable(0).object->value);
-    data = static_cast<Data *>(thread->getThisObject()->value);
+    b = static_cast<Data *>(thread->getVariable(0).object->value());
+    data = static_cast<Data *>(thread->getThisObject()->value());
 
-    memcpy(newBytes->value, data->bytes, data->length);
-    memcpy(static_cast<Byte *>(newBytes->value) + data->length, b->bytes, b->length);
+    memcpy(newBytes->value(), data->bytes, data->length);
+    memcpy(static_cast<Byte *>(newBytes->value()) + data->length, b->bytes, b->length);
 
     Object *ooData = newObject(CL_DATA);
-    Data *oData = static_cast<Data *>(ooData->value);
+    Data *oData = static_cast<Data *>(ooData->value());
     oData->bytesObject = newBytes;
-    oData->bytes = static_cast<char *>(oData->bytesObject->value);
+    oData->bytes = static_cast<char *>(oData->bytesObject->value());
     oData->length = size;
     thread->release(1);
     destination->object = ooData;
@@ -320,26 +315,10 @@ static void dataByAppendingData(Thread *thread, Value *destination) {
 
 void integerToString(Thread *thread, Value *destination) {
     EmojicodeInteger base = thread->getVariable(0).raw;
-    EmojicodeInteger n = thread->getThisContext().raw, a = std::abs(n);
-    bool negative = n < 0;
-
-    EmojicodeInteger d = negative ? 2 : 1;
-    while (n /= base) d++;
-
-    Object *const &co = thread->retain(newArray(d * sizeof(EmojicodeChar)));
-
-    Object *stringObject = newObject(CL_STRING);
-    String *string = static_cast<String *>(stringObject->value);
-    string->length = d;
-    string->characters = co;
-
-    EmojicodeChar *characters = characters(string) + d;
-    do
-        *--characters =  "0123456789abcdefghijklmnopqrstuvxyz"[a % base % 35];
-    while (a /= base);
-
-    if (negative) characters[-1] = '-';
-    thread->release(1);
+    EmojicodeInteger n = thread->getThisContext().raw;
+    size_t count = integerCharacterCount(n, base);
+    Object *stringObject = newString(count, true);
+    writeInteger(latin1Characters(static_cast<String *>(stringObject->value())), count, n, base);
     destination->object = stringObject;
 }
 
@@ -352,13 +331,15 @@ static void integerAbsolute(Thread *thread, Value *destination) {
 }
 
 static void symbolToString(Thread *thread, Value *destination) {
-    Object *co = thread->retain(newArray(sizeof(EmojicodeChar)));
-    Object *stringObject = newObject(CL_STRING);
-    String *string = static_cast<String *>(stringObject->value);
-    string->length = 1;
-    string->characters = co;
-    thread->release(1);
-    ((EmojicodeChar *)string->characters->value)[0] = thread->getThisContext().character;
+    EmojicodeChar character = thread->getThisContext().character;
+    Object *stringObject = newString(1, character < 256);
+    String *string = static_cast<String *>(stringObject->value());
+    if (string->latin1) {
+        latin1Characters(string)[0] = static_cast<uint8_t>(character);
+    }
+    else {
+        utf32Characters(string)[0] = character;
+    }
     destination->object = stringObject;
 }
 
@@ -369,42 +350,9 @@ static void symbolToInteger(Thread *thread, Value *destination) {
 static void doubleToString(Thread *thread, Value *destination) {
     EmojicodeInteger precision = thread->getVariable(0).raw;
     double d = thread->getThisContext().doubl;
-    double absD = std::abs(d);
-
-    bool negative = d < 0;
-
-    EmojicodeInteger length = negative ? 1 : 0;
-    if (precision != 0) {
-        length++;
-    }
-    length += precision;
-    EmojicodeInteger iLength = 1;
-    for (size_t i = 1; pow(10, i) < absD; i++) {
-        iLength++;
-    }
-    length += iLength;
-
-    Object *const &co = thread->retain(newArray(length * sizeof(EmojicodeChar)));
-    Object *stringObject = newObject(CL_STRING);
-    String *string = static_cast<String *>(stringObject->value);
-    string->length = length;
-    string->characters = co;
-    thread->release(1);
-    EmojicodeChar *characters = characters(string) + length;
-
-    for (size_t i = precision; i > 0; i--) {
-        *--characters =  (unsigned char) (fmod(absD * pow(10, i), 10.0)) % 10 + '0';
-    }
-
-    if (precision != 0) {
-        *--characters = '.';
-    }
-
-    for (size_t i = 0; i < iLength; i++) {
-        *--characters =  (unsigned char) (fmod(absD / pow(10, i), 10.0)) % 10 + '0';
-    }
-
-    if (negative) characters[-1] = '-';
+    size_t count = doubleCharacterCount(d, precision);
+    Object *stringObject = newString(count, true);
+    writeDouble(latin1Characters(static_cast<String *>(stringObject->value())), count, d, precision);
     destination->object = stringObject;
 }
 
@@ -467,27 +415,26 @@ static void doubleAbsolute(Thread *thread, Value *destination) {
 // MARK: Callable
 
 static void closureMark(Object *o) {
-    Closure *c = static_cast<Closure *>(o->value);
-//    if (isRealObject(c->thisContext)) {
-//        mark(&c->thisContext.object);
-//    }
-    mark(&c->capturedVariables);
-
-    Value *t = static_cast<Value *>(c->capturedVariables->value);
-    CaptureInformation *infop = static_cast<CaptureInformation *>(c->capturesInformation->value);
-//    for (int i = 0; i < c->captureCount; i++) {
-//        Value *s = t + (infop++)->destination;
-//        if (isRealObject(*s)) {
-//            mark(&s->object);
-//        }
-//    }
+    Closure *c = static_cast<Closure *>(o->value());
+    // The closure might still be being created
+    if (c->function == nullptr) {
+        return;
+    }
+    if (c->function->objectContext) {
+        mark(&c->thisContext.object);
+    }
+    mark(&c->capturesInformation);
+    if (c->capturedVariables) {
+        mark(&c->capturedVariables);
+        markByPointerMap(c->function->captures, static_cast<Value *>(c->capturedVariables->value()));
+    }
 }
 
 static void capturedMethodMark(Object *o) {
-    CapturedFunctionCall *c = static_cast<CapturedFunctionCall *>(o->value);
-//    if (isRealObject(c->callee)) {
-//        mark(&c->callee.object);
-//    }
+    CapturedFunctionCall *c = static_cast<CapturedFunctionCall *>(o->value());
+    if (c->function != nullptr && c->function->objectContext) {
+        mark(&c->callee.object);
+    }
 }
 
 FunctionFunctionPointer integerMethodForName(EmojicodeChar name);
@@ -594,6 +541,18 @@ FunctionFunctionPointer sLinkingTable[] = {
     bridgeDictionaryClear,  //🐗
     bridgeDictionaryContains,  //🐣
     bridgeDictionarySize,  //🐔
+    //🏗
+    initStringBuilder,
+    initStringBuilderWithCapacity,  //🐧
+    stringBuilderAppendString,  //📝
+    stringBuilderAppendSymbol,  //✏️
+    stringBuilderAppendInteger,  //🔢
+    stringBuilderAppendDouble,  //💯
+    stringBuilderLength,  //🐔
+    stringBuilderToString,  //🔡
+    //🍨
+    listStableSort,  //🐘
+    listNaturalSort,  //🐆
 };
 
 uint_fast32_t sizeForClass(Class *cl, EmojicodeChar name) {
@@ -614,6 +573,8 @@ uint_fast32_t sizeForClass(Class *cl, EmojicodeChar name) {
             return sizeof(pthread_t);
         case 0x1f510:  //🔐
             return sizeof(pthread_mutex_t);
+        case 0x1F3D7:  //🏗
+            return sizeof(StringBuilder);
     }
     return 0;
 }
@@ -632,6 +593,8 @@ Marker markerPointerForClass(EmojicodeChar cl) {
             return capturedMethodMark;
         case 0x1F4C7:
             return dataMark;
+        case 0x1F3D7:
+            return stringBuilderMark;
     }
     return nullptr;
 }
@@ -21,7 +21,7 @@ typedef uint32_t EmojicodeInstruction;
 #define defaultPackagesDirectory "/usr/local/EmojicodePackages"
 #endif
 
-#define ByteCodeSpecificationVersion 5
+#define ByteCodeSpecificationVersion 8
 
 #define T_NOTHINGNESS 0
 #define T_OBJECT 1
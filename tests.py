@@ -9,18 +9,31 @@ os.environ["EMOJICODE_PACKAGES_PATH"] = os.path.join(dist.path, "packages")
 compilation_tests = [
     "hello", "intTest", "branch", "namespace", "enum", "enumMethod",
     "enumTypeMethod", "unwrap",
-    "conditionalProduce", "piglatin", "stringConcat", "extension", "class",
+    "conditionalProduce", "piglatin", "stringConcat", "stringRepresentation",
+    "stringViews", "stringSearch", "extension", "class",
     "babyBottleInitializer", "valueType", "isNothingness", "downcastClass",
     "protocolClass", "protocolValueType", "variableInitAndScoping",
-    "gcStressTest1", "gcStressTest2",
-    "valueTypeCopySelf",
+    "gcStressTest1", "gcStressTest2", "gcLargeObjectTest", "gcLoopVariableTest",
+    "gcDictionaryTest", "gcListCopyTest", "gcClosureTest", "gcPackedListTest",
+    "gcStatementTest", "gcPackedListStoreTest",
+    "valueTypeCopySelf", "valueTypeSort", "valueTypeInstanceVariable",
+    "instanceVariableIncrement", "primitiveOperatorBoxing",
     # chaining callable threads
 ]
 library_tests = [
     "stringTest", "primitives", "mathTest", "listTest", "rangeTest",
-    "dataTest", "dictionaryTest", "systemTest", "jsonTest", "enumerator"
+    "dataTest", "dictionaryTest", "systemTest", "jsonTest", "enumerator",
+    "stringBuilderTest"
     # fileTest
 ]
+# The options of the engine configurations each test is run with. --jit=0 compiles functions on their first call.
+engines = {
+    "recursive": ["--engine=recursive"],
+    "threaded": ["--engine=threaded"],
+    "jit": ["--engine=threaded", "--jit=0"],
+    "generational": ["--engine=threaded", "--jit=0", "--gc=generational"],
+    "compacting": ["--engine=threaded", "--jit=0", "--gc=compacting"],
+}
 reject_tests = glob.glob(os.path.join(dist.source, "tests", "reject",
                                       "*.emojic"))
 
@@ -38,26 +51,32 @@ def test_paths(name, kind):
             os.path.join(dist.source, "tests", kind, name + ".emojib"))
 
 
+def run_engines(binary_path):
+    for engine, options in engines.items():
+        yield engine, run(["./emojicode"] + options + [binary_path],
+                          stdout=PIPE)
+
+
 def library_test(name):
     source_path, binary_path = test_paths(name, 's')
 
     run(["./emojicodec", source_path], check=True)
-    completed = run(["./emojicode", binary_path], stdout=PIPE)
-    if completed.returncode != 0:
-        fail_test(name)
-        print(completed.stdout.decode('utf-8'))
+    for engine, completed in run_engines(binary_path):
+        if completed.returncode != 0:
+            fail_test("{0} ({1})".format(name, engine))
+            print(completed.stdout.decode('utf-8'))
 
 
 def compilation_test(name):
     source_path, binary_path = test_paths(name, 'compilation')
 
     run(["./emojicodec", source_path], check=True)
-    completed = run(["./emojicode", binary_path], stdout=PIPE)
     exp_path = os.path.join(dist.source, "tests", "compilation", name + ".txt")
-    output = completed.stdout.decode('utf-8')
-    if output != open(exp_path, "r").read():
-        print(output)
-        fail_test(name)
+    for engine, completed in run_engines(binary_path):
+        output = completed.stdout.decode('utf-8')
+        if output != open(exp_path, "r").read():
+            print(output)
+            fail_test("{0} ({1})".format(name, engine))
 
 
 def reject_test(filename):
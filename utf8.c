@@ -31,6 +31,10 @@
 
 #include "utf8.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 static const uint32_t offsetsFromUTF8[6] = {
     0x00000000UL, 0x00003080UL, 0x000E2080UL,
     0x03C82080UL, 0xFA082080UL, 0x82082080UL
@@ -68,64 +72,201 @@ size_t u8_charlen(uint32_t ch)
     return 0;
 }
 
-size_t u8_codingsize(const uint32_t *wcstr, size_t n)
+/* The conversions below handle runs of ASCII 16 bytes at a time if SSE2 is
+   available, which every x86-64 processor supports, and decode everything else
+   one sequence at a time. */
+
+/* number of ASCII bytes at the start of s, which is n bytes long */
+static size_t u8_asciispan(const unsigned char *s, size_t n)
 {
-    size_t i, c=0;
+    size_t i = 0;
+#if defined(__SSE2__)
+    for (; i + 16 <= n; i += 16) {
+        int mask = _mm_movemask_epi8(_mm_loadu_si128((const __m128i *)(s + i)));
+        if (mask != 0)
+            return i + __builtin_ctz(mask);
+    }
+#endif
+    while (i < n && s[i] < 0x80)
+        i++;
+    return i;
+}
 
-    for(i=0; i < n; i++)
+#define iscont(c) (((c)&0xC0)==0x80)
+
+/* decodes the non-ASCII sequence at *ps, which must be before end, and
+   advances *ps past it. a sequence that is not well-formed UTF-8 (no overlong
+   forms, no surrogates, nothing above U+10FFFF) is decoded as U+FFFD replacing
+   its first byte only, and *valid is cleared. */
+static uint32_t u8_decodeseq(const unsigned char **ps, const unsigned char *end, int *valid)
+{
+    const unsigned char *s = *ps;
+    size_t avail = end - s;
+    unsigned char c = s[0];
+
+    if (c >= 0xC2 && c <= 0xDF) {
+        if (avail >= 2 && iscont(s[1])) {
+            *ps += 2;
+            return ((uint32_t)(c & 0x1F) << 6) | (s[1] & 0x3F);
+        }
+    }
+    else if (c >= 0xE0 && c <= 0xEF) {
+        if (avail >= 3 && iscont(s[1]) && iscont(s[2]) &&
+            (c != 0xE0 || s[1] >= 0xA0) && (c != 0xED || s[1] < 0xA0)) {
+            *ps += 3;
+            return ((uint32_t)(c & 0x0F) << 12) | ((uint32_t)(s[1] & 0x3F) << 6) | (s[2] & 0x3F);
+        }
+    }
+    else if (c >= 0xF0 && c <= 0xF4) {
+        if (avail >= 4 && iscont(s[1]) && iscont(s[2]) && iscont(s[3]) &&
+            (c != 0xF0 || s[1] >= 0x90) && (c != 0xF4 || s[1] < 0x90)) {
+            *ps += 4;
+            return ((uint32_t)(c & 0x07) << 18) | ((uint32_t)(s[1] & 0x3F) << 12) |
+                   ((uint32_t)(s[2] & 0x3F) << 6) | (s[3] & 0x3F);
+        }
+    }
+    *valid = 0;
+    *ps += 1;
+    return 0xFFFD;
+}
+
+size_t u8_codingsize(const uint32_t *wcstr, size_t n)
+{
+    size_t i = 0, c = 0;
+#if defined(__SSE2__)
+    /* a character needs 1 + (ch > 0x7F) + (ch > 0x7FF) + (ch > 0xFFFF) bytes,
+       or none if ch > 0x10FFFF. the comparisons are made unsigned by flipping
+       the sign bits. */
+    const __m128i sign = _mm_set1_epi32((int)0x80000000);
+    const __m128i two = _mm_set1_epi32((int)(0x7F ^ 0x80000000));
+    const __m128i three = _mm_set1_epi32((int)(0x7FF ^ 0x80000000));
+    const __m128i four = _mm_set1_epi32((int)(0xFFFF ^ 0x80000000));
+    const __m128i none = _mm_set1_epi32((int)(0x10FFFF ^ 0x80000000));
+    while (i + 4 <= n) {
+        /* the lanes change by at most 4 per step, add them up before they can overflow */
+        size_t blockEnd = n - (n - i) % 4;
+        if (blockEnd - i > ((size_t)1 << 24))
+            blockEnd = i + ((size_t)1 << 24);
+        __m128i sum = _mm_setzero_si128();
+        c += blockEnd - i;
+        for (; i < blockEnd; i += 4) {
+            __m128i v = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(wcstr + i)), sign);
+            sum = _mm_sub_epi32(sum, _mm_cmpgt_epi32(v, two));
+            sum = _mm_sub_epi32(sum, _mm_cmpgt_epi32(v, three));
+            sum = _mm_sub_epi32(sum, _mm_cmpgt_epi32(v, four));
+            sum = _mm_add_epi32(sum, _mm_slli_epi32(_mm_cmpgt_epi32(v, none), 2));
+        }
+        int32_t lanes[4];
+        _mm_storeu_si128((__m128i *)lanes, sum);
+        c += (size_t)((int64_t)lanes[0] + lanes[1] + lanes[2] + lanes[3]);
+    }
+#endif
+    for (; i < n; i++)
         c += u8_charlen(wcstr[i]);
     return c;
 }
 
-/* conversions without error checking
-   only works for valid UTF-8, i.e. no 5- or 6-byte sequences
+size_t u8_codingsize_latin1(const uint8_t *src, size_t n)
+{
+    size_t i = 0, c = n;
+#if defined(__SSE2__)
+    for (; i + 16 <= n; i += 16)
+        c += __builtin_popcount(_mm_movemask_epi8(_mm_loadu_si128((const __m128i *)(src + i))));
+#endif
+    for (; i < n; i++)
+        c += src[i] >> 7;
+    return c;
+}
+
+/* conversions from UTF-8 data that need not be valid, every sequence that
+   is not well-formed becomes U+FFFD
    srcsz = source size in bytes
    sz = dest size in # of wide characters
 
    returns # characters converted
-   if sz == srcsz+1 (i.e. 4*srcsz+4 bytes), there will always be enough space.
+   if sz == srcsz (i.e. 4*srcsz bytes), there will always be enough space.
 */
 size_t u8_toucs(uint32_t *dest, size_t sz, const char *src, size_t srcsz)
 {
-    uint32_t ch;
-    const char *src_end = src + srcsz;
-    size_t nb;
-    size_t i=0;
-
-    if (sz == 0 || srcsz == 0)
-        return 0;
+    const unsigned char *s = (const unsigned char *)src, *end = s + srcsz;
+    size_t i = 0;
+    int valid;
 
-    while (i < sz) {
-        if (!isutf(*src)) {     // invalid sequence
-            dest[i++] = 0xFFFD;
-            src++;
-            if (src >= src_end) break;
+    while (i < sz && s < end) {
+        if (*s >= 0x80) {
+            dest[i++] = u8_decodeseq(&s, end, &valid);
             continue;
         }
-        nb = trailingBytesForUTF8[(unsigned char)*src];
-        if (src + nb >= src_end)
-            break;
-        ch = 0;
-        switch (nb) {
-            /* these fall through deliberately */
-        case 5: ch += (unsigned char)*src++; ch <<= 6;
-        case 4: ch += (unsigned char)*src++; ch <<= 6;
-        case 3: ch += (unsigned char)*src++; ch <<= 6;
-        case 2: ch += (unsigned char)*src++; ch <<= 6;
-        case 1: ch += (unsigned char)*src++; ch <<= 6;
-        case 0: ch += (unsigned char)*src++;
+        size_t n = (size_t)(end - s) < sz - i ? (size_t)(end - s) : sz - i;
+#if defined(__SSE2__)
+        const __m128i zero = _mm_setzero_si128();
+        for (; n >= 16; n -= 16, s += 16, i += 16) {
+            __m128i v = _mm_loadu_si128((const __m128i *)s);
+            if (_mm_movemask_epi8(v) != 0)
+                break;
+            __m128i lo = _mm_unpacklo_epi8(v, zero), hi = _mm_unpackhi_epi8(v, zero);
+            _mm_storeu_si128((__m128i *)(dest + i), _mm_unpacklo_epi16(lo, zero));
+            _mm_storeu_si128((__m128i *)(dest + i + 4), _mm_unpackhi_epi16(lo, zero));
+            _mm_storeu_si128((__m128i *)(dest + i + 8), _mm_unpacklo_epi16(hi, zero));
+            _mm_storeu_si128((__m128i *)(dest + i + 12), _mm_unpackhi_epi16(hi, zero));
+        }
+#endif
+        for (; n > 0 && *s < 0x80; n--)
+            dest[i++] = *s++;
+    }
+    return i;
+}
+
+/* the same for UTF-8 data all of whose characters are below 256, as
+   reported by u8_measure */
+size_t u8_tolatin1(uint8_t *dest, size_t sz, const char *src, size_t srcsz)
+{
+    const unsigned char *s = (const unsigned char *)src, *end = s + srcsz;
+    size_t i = 0;
+    int valid;
+
+    while (i < sz && s < end) {
+        if (*s >= 0x80) {
+            dest[i++] = (uint8_t)u8_decodeseq(&s, end, &valid);
+            continue;
         }
-        ch -= offsetsFromUTF8[nb];
-        dest[i++] = ch;
+        size_t n = (size_t)(end - s) < sz - i ? (size_t)(end - s) : sz - i;
+        n = u8_asciispan(s, n);
+        memcpy(dest + i, s, n);
+        i += n;
+        s += n;
     }
     return i;
 }
 
+size_t u8_measure(const char *src, size_t srcsz, int *latin1, int *valid)
+{
+    const unsigned char *s = (const unsigned char *)src, *end = s + srcsz;
+    size_t count = 0;
+    int below256 = 1, wellformed = 1;
+
+    while (s < end) {
+        size_t n = u8_asciispan(s, end - s);
+        s += n;
+        count += n;
+        if (s < end) {
+            if (u8_decodeseq(&s, end, &wellformed) > 0xFF)
+                below256 = 0;
+            count++;
+        }
+    }
+    if (latin1)
+        *latin1 = below256;
+    if (valid)
+        *valid = wellformed;
+    return count;
+}
+
 /* srcsz = number of source characters
    sz = size of dest buffer in bytes
 
    returns # bytes stored in dest
-   the destination string will never be bigger than the source string.
+   characters above U+10FFFF are skipped.
 */
 size_t u8_toutf8(char *dest, size_t sz, const uint32_t *src, size_t srcsz)
 {
@@ -135,6 +276,24 @@ size_t u8_toutf8(char *dest, size_t sz, const uint32_t *src, size_t srcsz)
     char *dest_end = dest + sz;
 
     while (i < srcsz) {
+#if defined(__SSE2__)
+        /* 16 ASCII characters at once */
+        const __m128i high = _mm_set1_epi32(~0x7F);
+        while (i + 16 <= srcsz && dest_end - dest >= 16 && src[i] < 0x80) {
+            __m128i a = _mm_loadu_si128((const __m128i *)(src + i));
+            __m128i b = _mm_loadu_si128((const __m128i *)(src + i + 4));
+            __m128i c = _mm_loadu_si128((const __m128i *)(src + i + 8));
+            __m128i d = _mm_loadu_si128((const __m128i *)(src + i + 12));
+            __m128i any = _mm_and_si128(_mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d)), high);
+            if (_mm_movemask_epi8(_mm_cmpeq_epi32(any, _mm_setzero_si128())) != 0xFFFF)
+                break;
+            _mm_storeu_si128((__m128i *)dest, _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d)));
+            dest += 16;
+            i += 16;
+        }
+        if (i >= srcsz)
+            break;
+#endif
         ch = src[i];
         if (ch < 0x80) {
             if (dest >= dest_end)
@@ -167,6 +326,26 @@ size_t u8_toutf8(char *dest, size_t sz, const uint32_t *src, size_t srcsz)
     return (dest-dest0);
 }
 
+/* the same for characters below 256 */
+size_t u8_fromlatin1(char *dest, size_t sz, const uint8_t *src, size_t srcsz)
+{
+    size_t i = 0, j = 0;
+
+    while (i < srcsz) {
+        size_t n = srcsz - i < sz - j ? srcsz - i : sz - j;
+        n = u8_asciispan(src + i, n);
+        memcpy(dest + j, src + i, n);
+        i += n;
+        j += n;
+        if (i >= srcsz || j + 2 > sz)
+            break;
+        dest[j++] = (char)(0xC0 | (src[i] >> 6));
+        dest[j++] = (char)(0x80 | (src[i] & 0x3F));
+        i++;
+    }
+    return j;
+}
+
 size_t u8_wc_toutf8(char *dest, uint32_t ch)
 {
     if (ch < 0x80) {
@@ -225,35 +404,11 @@ size_t u8_charnum(const char *s, size_t offset)
 /* number of characters in NUL-terminated string */
 size_t u8_strlen(const char *s)
 {
-    size_t count = 0;
-    size_t i = 0, lasti;
-
-    while (1) {
-        lasti = i;
-        while (s[i] > 0)
-            i++;
-        count += (i-lasti);
-        if (s[i++]==0) break;
-        (void)(isutf(s[++i]) || isutf(s[++i]) || ++i);
-        count++;
-    }
-    return count;
+    return u8_measure(s, strlen(s), NULL, NULL);
 }
 
 size_t u8_strlen_l(const char *s, size_t length) {
-    size_t count = 0;
-    size_t i = 0, lasti;
-    
-    while (1) {
-        lasti = i;
-        while (i < length && s[i] > 0)
-            i++;
-        count += (i-lasti);
-        if (i + 1 >= length || s[i++]==0) break;
-        (void)(isutf(s[++i]) || isutf(s[++i]) || ++i);
-        count++;
-    }
-    return count;
+    return u8_measure(s, length, NULL, NULL);
 }
 
 int wcwidth(wchar_t c);
@@ -638,71 +793,15 @@ size_t u8_printf(const char *fmt, ...)
     return cnt;
 }
 
-/* based on the valid_utf8 routine from the PCRE library by Philip Hazel
-
-   length is in bytes, since without knowing whether the string is valid
+/* length is in bytes, since without knowing whether the string is valid
    it's hard to know how many characters there are! */
 int u8_isvalid(const char *str, size_t length)
 {
-    const unsigned char *p, *pend = (unsigned char*)str + length;
-    unsigned char c;
-    int ret = 1; /* ASCII */
-    size_t ab;
-
-    for (p = (unsigned char*)str; p < pend; p++) {
-        c = *p;
-        if (c < 128)
-            continue;
-        ret = 2; /* non-ASCII UTF-8 */
-        if ((c & 0xc0) != 0xc0)
-            return 0;
-        ab = trailingBytesForUTF8[c];
-        if (length < ab)
-            return 0;
-        length -= ab;
-
-        p++;
-        /* Check top bits in the second byte */
-        if ((*p & 0xc0) != 0x80)
-            return 0;
-
-        /* Check for overlong sequences for each different length */
-        switch (ab) {
-            /* Check for xx00 000x */
-        case 1:
-            if ((c & 0x3e) == 0) return 0;
-            continue;   /* We know there aren't any more bytes to check */
-
-            /* Check for 1110 0000, xx0x xxxx */
-        case 2:
-            if (c == 0xe0 && (*p & 0x20) == 0) return 0;
-            break;
-
-            /* Check for 1111 0000, xx00 xxxx */
-        case 3:
-            if (c == 0xf0 && (*p & 0x30) == 0) return 0;
-            break;
-
-            /* Check for 1111 1000, xx00 0xxx */
-        case 4:
-            if (c == 0xf8 && (*p & 0x38) == 0) return 0;
-            break;
-
-            /* Check for leading 0xfe or 0xff,
-               and then for 1111 1100, xx00 00xx */
-        case 5:
-            if (c == 0xfe || c == 0xff ||
-                (c == 0xfc && (*p & 0x3c) == 0)) return 0;
-            break;
-        }
-
-        /* Check for valid bytes after the 2nd, if any; all must start 10 */
-        while (--ab > 0) {
-            if ((*(++p) & 0xc0) != 0x80) return 0;
-        }
-    }
-
-    return ret;
+    int valid;
+    size_t count = u8_measure(str, length, NULL, &valid);
+    if (!valid)
+        return 0;
+    return count == length ? 1 : 2;
 }
 
 int u8_reverse(char *dest, char * src, size_t len)
@@ -19,9 +19,20 @@ extern int locale_is_utf8;
 /* convert UTF-8 data to wide character */
 size_t u8_toucs(uint32_t *dest, size_t sz, const char *src, size_t srcsz);
 
-/* the opposite conversion */
+/* convert UTF-8 data all of whose characters are below 256 to Latin-1 */
+size_t u8_tolatin1(uint8_t *dest, size_t sz, const char *src, size_t srcsz);
+
+/* count the characters u8_toucs decodes from UTF-8 data in one pass, telling
+   whether they are all below 256 and whether the data is valid UTF-8.
+   latin1 and valid may be NULL */
+size_t u8_measure(const char *src, size_t srcsz, int *latin1, int *valid);
+
+/* convert wide characters to UTF-8 */
 size_t u8_toutf8(char *dest, size_t sz, const uint32_t *src, size_t srcsz);
 
+/* convert Latin-1 characters to UTF-8 */
+size_t u8_fromlatin1(char *dest, size_t sz, const uint8_t *src, size_t srcsz);
+
 /* single character to UTF-8, returns # bytes written */
 size_t u8_wc_toutf8(char *dest, uint32_t ch);
 
@@ -52,6 +63,9 @@ size_t u8_charlen(uint32_t ch);
 /* computes the # of bytes needed to encode a WC string as UTF-8 */
 size_t u8_codingsize(const uint32_t *wcstr, size_t n);
 
+/* the same for a Latin-1 string */
+size_t u8_codingsize_latin1(const uint8_t *src, size_t n);
+
 char read_escape_control_char(char c);
 
 /* assuming src points to the character after a backslash, read an